@@ -7,9 +7,12 @@
 #include <common.h>
 #include <command.h>
 #include <console.h>
+#include <malloc.h>
+#include <memalign.h>
 #include <mmc.h>
 #include <sparse_format.h>
 #include <image-sparse.h>
+#include <linux/math64.h>
 
 static int curr_device = -1;
 
@@ -317,6 +320,54 @@ static int do_mmc_read(cmd_tbl_t *cmdtp, int flag,
 	return (n == cnt) ? CMD_RET_SUCCESS : CMD_RET_FAILURE;
 }
 
+static int do_mmc_bench(cmd_tbl_t *cmdtp, int flag,
+			int argc, char * const argv[])
+{
+	struct mmc *mmc;
+	u32 blk, cnt, n;
+	ulong time;
+	u64 len;
+	void *buf;
+
+	if (argc != 3)
+		return CMD_RET_USAGE;
+
+	blk = simple_strtoul(argv[1], NULL, 16);
+	cnt = simple_strtoul(argv[2], NULL, 16);
+
+	mmc = init_mmc_device(curr_device, false);
+	if (!mmc)
+		return CMD_RET_FAILURE;
+
+	len = (u64)cnt * mmc->read_bl_len;
+	buf = malloc_cache_aligned(len);
+	if (!buf) {
+		printf("Cannot allocate %llu bytes\n", len);
+		return CMD_RET_FAILURE;
+	}
+
+#if CONFIG_IS_ENABLED(MMC_VERBOSE)
+	printf("Mode: %s, ", mmc_mode_name(mmc->selected_mode));
+#endif
+	printf("%d-bit%s at %d Hz, %s transfers\n", mmc->bus_width,
+	       mmc->ddr_mode ? " DDR" : "", mmc->clock,
+	       mmc->card_caps & mmc->host_caps & MMC_CAP_CMD23 ?
+	       "CMD23" : "CMD12");
+
+	time = get_timer(0);
+	n = blk_dread(mmc_get_blk_desc(mmc), blk, cnt, buf);
+	time = get_timer(time);
+	free(buf);
+	if (n != cnt) {
+		printf("Read failed after %d blocks\n", n);
+		return CMD_RET_FAILURE;
+	}
+
+	print_read_time(len, time);
+
+	return CMD_RET_SUCCESS;
+}
+
 #if CONFIG_IS_ENABLED(CMD_MMC_SWRITE)
 static lbaint_t mmc_sparse_write(struct sparse_storage *info, lbaint_t blk,
 				 lbaint_t blkcnt, const void *buffer)
@@ -875,6 +926,7 @@ static int do_mmc_bkops_enable(cmd_tbl_t *cmdtp, int flag,
 static cmd_tbl_t cmd_mmc[] = {
 	U_BOOT_CMD_MKENT(info, 1, 0, do_mmcinfo, "", ""),
 	U_BOOT_CMD_MKENT(read, 4, 1, do_mmc_read, "", ""),
+	U_BOOT_CMD_MKENT(bench, 3, 1, do_mmc_bench, "", ""),
 #if CONFIG_IS_ENABLED(MMC_WRITE)
 	U_BOOT_CMD_MKENT(write, 4, 0, do_mmc_write, "", ""),
 	U_BOOT_CMD_MKENT(erase, 3, 0, do_mmc_erase, "", ""),
@@ -935,6 +987,7 @@ U_BOOT_CMD(
 	"MMC sub system",
 	"info - display info of the current MMC device\n"
 	"mmc read addr blk# cnt\n"
+	"mmc bench blk# cnt - time reading cnt blocks from blk#\n"
 	"mmc write addr blk# cnt\n"
 #if CONFIG_IS_ENABLED(CMD_MMC_SWRITE)
 	"mmc swrite addr blk#\n"
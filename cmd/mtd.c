@@ -14,8 +14,10 @@
 #include <malloc.h>
 #include <mapmem.h>
 #include <mtd.h>
+#include <time.h>
 #include <dm/devres.h>
 #include <linux/err.h>
+#include <linux/math64.h>
 
 #include <linux/ctype.h>
 
@@ -484,6 +486,290 @@ out_put_mtd:
 	return CMD_RET_SUCCESS;
 }
 
+#ifdef CONFIG_CMD_MTD_BENCH
+#define MTD_BENCH_HIST_SIZE	24
+
+enum mtd_bench_test {
+	MTD_BENCH_ERASE,
+	MTD_BENCH_WRITE,
+	MTD_BENCH_SEQ_READ,
+	MTD_BENCH_RAND_READ,
+};
+
+static const char * const mtd_bench_names[] = {
+	[MTD_BENCH_ERASE] = "erase",
+	[MTD_BENCH_WRITE] = "program",
+	[MTD_BENCH_SEQ_READ] = "seq read",
+	[MTD_BENCH_RAND_READ] = "rand read",
+};
+
+/**
+ * struct mtd_bench_stats - Results of one benchmark pass
+ *
+ * @bytes: Number of bytes transferred or erased
+ * @time_us: Sum of the latencies of all operations
+ * @min_us: Lowest latency of a single operation
+ * @max_us: Highest latency of a single operation
+ * @ops: Number of operations done
+ * @skipped: Number of operations skipped because of a bad block
+ * @mismatch: Number of pages not matching the programmed pattern
+ * @over_threshold: Number of reads returning -EUCLEAN
+ * @ecc: ECC statistics of the device before the pass, then the delta
+ * @hist: Latency histogram, bucket n counts [2^(n-1), 2^n) us
+ */
+struct mtd_bench_stats {
+	u64 bytes;
+	ulong time_us;
+	ulong min_us;
+	ulong max_us;
+	uint ops;
+	uint skipped;
+	uint mismatch;
+	uint over_threshold;
+	struct mtd_ecc_stats ecc;
+	uint hist[MTD_BENCH_HIST_SIZE];
+};
+
+/* Simple LCG, so that the random offsets are the same from run to run */
+static uint mtd_bench_rand(uint *seed)
+{
+	*seed = *seed * 1103515245 + 12345;
+
+	return *seed >> 8;
+}
+
+static void mtd_bench_fill(u8 *buf, uint len, u64 off)
+{
+	uint i;
+
+	for (i = 0; i < len; i++)
+		buf[i] = (u8)(off + i) ^ 0x5a;
+}
+
+static void mtd_bench_account(struct mtd_bench_stats *st, ulong us,
+			      uint len)
+{
+	st->hist[min(fls(us), MTD_BENCH_HIST_SIZE - 1)]++;
+	if (!st->ops || us < st->min_us)
+		st->min_us = us;
+	if (us > st->max_us)
+		st->max_us = us;
+	st->time_us += us;
+	st->bytes += len;
+	st->ops++;
+}
+
+static int mtd_bench_run(struct mtd_info *mtd, enum mtd_bench_test test,
+			 u64 start, u64 len, uint unit, u8 *buf, u8 *ref,
+			 struct mtd_bench_stats *st)
+{
+	struct mtd_oob_ops io_op = {};
+	struct erase_info erase_op = {};
+	uint i, count, seed = 1;
+	ulong time;
+	u64 off;
+	int ret;
+
+	memset(st, 0, sizeof(*st));
+	st->ecc = mtd->ecc_stats;
+	count = div_u64(len, unit);
+
+	io_op.mode = MTD_OPS_AUTO_OOB;
+	io_op.len = unit;
+	io_op.datbuf = test == MTD_BENCH_WRITE ? ref : buf;
+
+	erase_op.mtd = mtd;
+	erase_op.len = unit;
+
+	for (i = 0; i < count; i++) {
+		if (ctrlc()) {
+			puts("\nAbort\n");
+			return -EINTR;
+		}
+
+		if (test == MTD_BENCH_RAND_READ)
+			off = start + (u64)(mtd_bench_rand(&seed) % count) * unit;
+		else
+			off = start + (u64)i * unit;
+
+		if (mtd_can_have_bb(mtd) &&
+		    mtd_block_isbad(mtd, off - mtd_mod_by_eb(off, mtd))) {
+			st->skipped++;
+			continue;
+		}
+
+		if (test == MTD_BENCH_WRITE)
+			mtd_bench_fill(ref, unit, off);
+
+		time = timer_get_us();
+		switch (test) {
+		case MTD_BENCH_ERASE:
+			erase_op.addr = off;
+			ret = mtd_erase(mtd, &erase_op);
+			break;
+		case MTD_BENCH_WRITE:
+			ret = mtd_write_oob(mtd, off, &io_op);
+			break;
+		default:
+			ret = mtd_read_oob(mtd, off, &io_op);
+			break;
+		}
+		time = timer_get_us() - time;
+
+		if (ret == -EUCLEAN) {
+			st->over_threshold++;
+			ret = 0;
+		}
+		if (ret) {
+			printf("Failure during %s at offset 0x%llx (%d)\n",
+			       mtd_bench_names[test], off, ret);
+			return ret;
+		}
+
+		mtd_bench_account(st, time, unit);
+
+		/* Only the sequential pass checks what the program pass wrote */
+		if (test == MTD_BENCH_SEQ_READ && ref) {
+			mtd_bench_fill(ref, unit, off);
+			if (memcmp(buf, ref, unit))
+				st->mismatch++;
+		}
+	}
+
+	st->ecc.corrected = mtd->ecc_stats.corrected - st->ecc.corrected;
+	st->ecc.failed = mtd->ecc_stats.failed - st->ecc.failed;
+
+	return 0;
+}
+
+static void mtd_bench_show(struct mtd_info *mtd, enum mtd_bench_test test,
+			   struct mtd_bench_stats *st)
+{
+	int i, last;
+
+	printf("%-10s %llu bytes, %u op(s) in %lu us", mtd_bench_names[test],
+	       st->bytes, st->ops, st->time_us);
+	print_rate(st->bytes, st->time_us);
+	putc('\n');
+
+	if (st->skipped)
+		printf("  %u op(s) skipped in bad blocks\n", st->skipped);
+	if (!st->ops)
+		return;
+
+	printf("  latency: min %lu us, avg %lu us, max %lu us\n",
+	       st->min_us, st->time_us / st->ops, st->max_us);
+	for (last = MTD_BENCH_HIST_SIZE - 1; last > 0; last--)
+		if (st->hist[last])
+			break;
+	for (i = 0; i <= last; i++) {
+		if (!st->hist[i])
+			continue;
+		if (i == MTD_BENCH_HIST_SIZE - 1)
+			printf("  %8lu us and more: %u\n", 1UL << (i - 1),
+			       st->hist[i]);
+		else
+			printf("  %8lu - %8lu us: %u\n", i ? 1UL << (i - 1) : 0,
+			       (1UL << i) - 1, st->hist[i]);
+	}
+
+	if (test < MTD_BENCH_SEQ_READ)
+		return;
+
+	if (mtd->ecc_strength)
+		printf("  bitflips: %u corrected, %u uncorrectable, %u read(s) over threshold\n",
+		       st->ecc.corrected, st->ecc.failed, st->over_threshold);
+	if (test == MTD_BENCH_SEQ_READ && st->mismatch)
+		printf("  %u page(s) do not match the programmed data\n",
+		       st->mismatch);
+}
+
+static int do_mtd_bench(cmd_tbl_t *cmdtp, int flag, int argc,
+			char * const argv[])
+{
+	struct mtd_bench_stats st;
+	enum mtd_bench_test test;
+	struct mtd_info *mtd;
+	u8 *buf, *ref = NULL;
+	u64 off, len;
+	bool write;
+	uint unit;
+	int ret = 0;
+
+	if (argc < 2)
+		return CMD_RET_USAGE;
+
+	mtd = get_mtd_by_name(argv[1]);
+	if (IS_ERR_OR_NULL(mtd))
+		return CMD_RET_FAILURE;
+
+	write = strstr(argv[0], ".write");
+
+	argc -= 2;
+	argv += 2;
+
+	off = argc > 0 ? simple_strtoul(argv[0], NULL, 16) : 0;
+	len = argc > 1 ? simple_strtoul(argv[1], NULL, 16) : mtd->size;
+
+	/* NOR devices have a writesize of 1 but program a page at a time */
+	unit = mtd->writesize;
+	if (unit == 1 && mtd->writebufsize)
+		unit = mtd->writebufsize;
+
+	if (write ? !mtd_is_aligned_with_block_size(mtd, off) ||
+		    !mtd_is_aligned_with_block_size(mtd, len) :
+		    !IS_ALIGNED(off, unit) || !IS_ALIGNED(len, unit)) {
+		printf("Offset and size must be multiples of a %s (0x%x)\n",
+		       write ? "block" : "page",
+		       write ? mtd->erasesize : unit);
+		ret = CMD_RET_FAILURE;
+		goto out_put_mtd;
+	}
+
+	if (!len || off + len > mtd->size) {
+		printf("Range 0x%llx+0x%llx is outside of %s\n", off, len,
+		       mtd->name);
+		ret = CMD_RET_FAILURE;
+		goto out_put_mtd;
+	}
+
+	buf = kmalloc(unit, GFP_KERNEL);
+	if (write)
+		ref = kmalloc(unit, GFP_KERNEL);
+	if (!buf || (write && !ref)) {
+		printf("Could not allocate the bench buffers\n");
+		ret = CMD_RET_FAILURE;
+		goto out_free;
+	}
+
+	printf("Benchmarking %s 0x%08llx ... 0x%08llx, %u byte(s) per op%s\n",
+	       mtd->name, off, off + len - 1, unit,
+	       write ? " [write]" : "");
+
+	for (test = write ? MTD_BENCH_ERASE : MTD_BENCH_SEQ_READ;
+	     test <= MTD_BENCH_RAND_READ; test++) {
+		ret = mtd_bench_run(mtd, test, off, len,
+				    test == MTD_BENCH_ERASE ? mtd->erasesize :
+				    unit, buf, ref, &st);
+		if (ret)
+			break;
+
+		mtd_bench_show(mtd, test, &st);
+	}
+
+	ret = ret ? CMD_RET_FAILURE : CMD_RET_SUCCESS;
+
+out_free:
+	kfree(ref);
+	kfree(buf);
+
+out_put_mtd:
+	put_mtd_device(mtd);
+
+	return ret;
+}
+#endif /* CONFIG_CMD_MTD_BENCH */
+
 #ifdef CONFIG_AUTO_COMPLETE
 static int mtd_name_complete(int argc, char * const argv[], char last_char,
 			     int maxv, char *cmdv[])
@@ -532,6 +818,9 @@ static char mtd_help_text[] =
 	"\n"
 	"Specific functions:\n"
 	"mtd bad                               <name>\n"
+#ifdef CONFIG_CMD_MTD_BENCH
+	"mtd bench[.write]                     <name>        [<off> [<size>]]\n"
+#endif
 	"\n"
 	"With:\n"
 	"\t<name>: NAND partition/chip name\n"
@@ -543,7 +832,13 @@ static char mtd_help_text[] =
 	"\t\t* must be a multiple of a block for erase\n"
 	"\t\t* must be a multiple of a page otherwise (special case: default is a page with dump)\n"
 	"\n"
-	"The .dontskipff option forces writing empty pages, don't use it if unsure.\n";
+	"The .dontskipff option forces writing empty pages, don't use it if unsure.\n"
+#ifdef CONFIG_CMD_MTD_BENCH
+	"\n"
+	"bench measures sequential and random page reads, .write also erases\n"
+	"and programs the range first: its content is lost.\n"
+#endif
+	;
 #endif
 
 U_BOOT_CMD_WITH_SUBCMDS(mtd, "MTD utils", mtd_help_text,
@@ -556,5 +851,9 @@ U_BOOT_CMD_WITH_SUBCMDS(mtd, "MTD utils", mtd_help_text,
 					     mtd_name_complete),
 		U_BOOT_SUBCMD_MKENT_COMPLETE(erase, 4, 0, do_mtd_erase,
 					     mtd_name_complete),
+#ifdef CONFIG_CMD_MTD_BENCH
+		U_BOOT_SUBCMD_MKENT_COMPLETE(bench, 4, 0, do_mtd_bench,
+					     mtd_name_complete),
+#endif
 		U_BOOT_SUBCMD_MKENT_COMPLETE(bad, 2, 1, do_mtd_bad,
 					     mtd_name_complete));
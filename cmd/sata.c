@@ -13,10 +13,13 @@
 #include <ahci.h>
 #include <dm.h>
 #include <command.h>
+#include <malloc.h>
+#include <memalign.h>
 #include <part.h>
 #include <sata.h>
 #include <dm/device-internal.h>
 #include <dm/uclass-internal.h>
+#include <linux/math64.h>
 
 static int sata_curr_device = -1;
 
@@ -78,6 +81,40 @@ int sata_probe(int devnum)
 #endif
 }
 
+static int sata_bench(lbaint_t blk, lbaint_t cnt)
+{
+	struct blk_desc *desc;
+	ulong time, n;
+	u64 len;
+	void *buf;
+
+	desc = blk_get_devnum_by_type(IF_TYPE_SATA, sata_curr_device);
+	if (!desc) {
+		printf("No SATA device %d\n", sata_curr_device);
+		return CMD_RET_FAILURE;
+	}
+
+	len = (u64)cnt * desc->blksz;
+	buf = malloc_cache_aligned(len);
+	if (!buf) {
+		printf("Cannot allocate %llu bytes\n", len);
+		return CMD_RET_FAILURE;
+	}
+
+	time = get_timer(0);
+	n = blk_dread(desc, blk, cnt, buf);
+	time = get_timer(time);
+	free(buf);
+	if (n != cnt) {
+		printf("Read failed after %lu blocks\n", n);
+		return CMD_RET_FAILURE;
+	}
+
+	print_read_time(len, time);
+
+	return CMD_RET_SUCCESS;
+}
+
 static int do_sata(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 {
 	int rc = 0;
@@ -109,6 +146,10 @@ static int do_sata(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 		sata_curr_device = 0;
 	}
 
+	if (argc == 4 && !strcmp(argv[1], "bench"))
+		return sata_bench(simple_strtoul(argv[2], NULL, 16),
+				  simple_strtoul(argv[3], NULL, 16));
+
 	return blk_common_cmd(argc, argv, IF_TYPE_SATA, &sata_curr_device);
 }
 
@@ -121,5 +162,6 @@ U_BOOT_CMD(
 	"sata device [dev] - show or set current device\n"
 	"sata part [dev] - print partition table\n"
 	"sata read addr blk# cnt\n"
-	"sata write addr blk# cnt"
+	"sata write addr blk# cnt\n"
+	"sata bench blk# cnt - time reading cnt blocks from blk#"
 );
@@ -12,6 +12,7 @@
 #include <mapmem.h>
 #include <spi.h>
 #include <spi_flash.h>
+#include <time.h>
 #include <jffs2/jffs2.h>
 #include <linux/mtd/mtd.h>
 
@@ -153,25 +154,75 @@ static int do_spi_flash_probe(int argc, char * const argv[])
 	return 0;
 }
 
+/* Statistics of an update */
+struct sf_update_stats {
+	size_t skipped;		/* bytes already up to date */
+	uint erased;		/* sectors erased */
+	size_t programmed;	/* bytes programmed */
+};
+
+/**
+ * Program a buffer to erased SPI flash, leaving out the pages which are all
+ * 0xff since the erase already put that there.
+ *
+ * @param flash		flash context pointer
+ * @param offset	flash offset to write
+ * @param len		number of bytes to write
+ * @param buf		buffer to write from
+ * @param st		statistics, updated by this function
+ * @return 0 if OK, -ve on error
+ */
+static int spi_flash_program_erased(struct spi_flash *flash, u32 offset,
+				    size_t len, const char *buf,
+				    struct sf_update_stats *st)
+{
+	size_t pos, start, todo;
+	int ret;
+
+	for (pos = 0; pos < len; ) {
+		/* Find the next run of pages with data */
+		for (start = pos; start < len; start += todo) {
+			todo = min_t(size_t, len - start, flash->page_size);
+			if (memchr_inv(buf + start, 0xff, todo))
+				break;
+		}
+		for (pos = start; pos < len; pos += todo) {
+			todo = min_t(size_t, len - pos, flash->page_size);
+			if (!memchr_inv(buf + pos, 0xff, todo))
+				break;
+		}
+		if (pos == start)
+			break;
+
+		ret = spi_flash_write(flash, offset + start, pos - start,
+				      buf + start);
+		if (ret)
+			return ret;
+		st->programmed += pos - start;
+	}
+
+	return 0;
+}
+
 /**
  * Write a block of data to SPI flash, first checking if it is different from
  * what is already there.
  *
- * If the data being written is the same, then *skipped is incremented by len.
+ * If the data being written is the same, then st->skipped is incremented by
+ * len. The erase is left out when the sector is already blank.
  *
  * @param flash		flash context pointer
  * @param offset	flash offset to write
  * @param len		number of bytes to write
  * @param buf		buffer to write from
  * @param cmp_buf	read buffer to use to compare data
- * @param skipped	Count of skipped data (incremented by this function)
+ * @param st		statistics, updated by this function
  * @return NULL if OK, else a string containing the stage which failed
  */
 static const char *spi_flash_update_block(struct spi_flash *flash, u32 offset,
-		size_t len, const char *buf, char *cmp_buf, size_t *skipped)
+		size_t len, const char *buf, char *cmp_buf,
+		struct sf_update_stats *st)
 {
-	char *ptr = (char *)buf;
-
 	debug("offset=%#x, sector_size=%#x, len=%#zx\n",
 	      offset, flash->sector_size, len);
 	/* Read the entire sector so to allow for rewriting */
@@ -181,19 +232,27 @@ static const char *spi_flash_update_block(struct spi_flash *flash, u32 offset,
 	if (memcmp(cmp_buf, buf, len) == 0) {
 		debug("Skip region %x size %zx: no change\n",
 		      offset, len);
-		*skipped += len;
+		st->skipped += len;
+		return NULL;
+	}
+	/* A blank sector only needs the new data */
+	if (!memchr_inv(cmp_buf, 0xff, flash->sector_size)) {
+		if (spi_flash_program_erased(flash, offset, len, buf, st))
+			return "write";
 		return NULL;
 	}
 	/* Erase the entire sector */
 	if (spi_flash_erase(flash, offset, flash->sector_size))
 		return "erase";
+	st->erased++;
 	/* If it's a partial sector, copy the data into the temp-buffer */
 	if (len != flash->sector_size) {
 		memcpy(cmp_buf, buf, len);
-		ptr = cmp_buf;
+		buf = cmp_buf;
 	}
 	/* Write one complete sector */
-	if (spi_flash_write(flash, offset, flash->sector_size, ptr))
+	if (spi_flash_program_erased(flash, offset, flash->sector_size, buf,
+				     st))
 		return "write";
 
 	return NULL;
@@ -216,7 +275,7 @@ static int spi_flash_update(struct spi_flash *flash, u32 offset,
 	char *cmp_buf;
 	const char *end = buf + len;
 	size_t todo;		/* number of bytes to do in this pass */
-	size_t skipped = 0;	/* statistics */
+	struct sf_update_stats st = { 0 };
 	const ulong start_time = get_timer(0);
 	size_t scale = 1;
 	const char *start_buf = buf;
@@ -238,7 +297,7 @@ static int spi_flash_update(struct spi_flash *flash, u32 offset,
 				last_update = get_timer(0);
 			}
 			err_oper = spi_flash_update_block(flash, offset, todo,
-					buf, cmp_buf, &skipped);
+					buf, cmp_buf, &st);
 		}
 	} else {
 		err_oper = "malloc";
@@ -251,10 +310,12 @@ static int spi_flash_update(struct spi_flash *flash, u32 offset,
 	}
 
 	delta = get_timer(start_time);
-	printf("%zu bytes written, %zu bytes skipped", len - skipped,
-	       skipped);
+	printf("%zu bytes written, %zu bytes skipped", len - st.skipped,
+	       st.skipped);
 	printf(" in %ld.%lds, speed %ld B/s\n",
 	       delta / 1000, delta % 1000, bytes_per_second(len, start_time));
+	printf("%u sectors erased, %zu bytes programmed\n", st.erased,
+	       st.programmed);
 
 	return 0;
 }
@@ -542,6 +603,80 @@ static int do_spi_flash_test(int argc, char * const argv[])
 }
 #endif /* CONFIG_CMD_SF_TEST */
 
+#ifdef CONFIG_CMD_SF_BENCH
+/**
+ * Read the same area of flash a number of times and report the throughput.
+ * Nothing is written, so this can be used to compare controller and bus
+ * settings on a production flash.
+ */
+static int do_spi_flash_bench(int argc, char * const argv[])
+{
+	unsigned long addr, offset, len, count = 1;
+	unsigned long i, start, us, total = 0, best = ~0UL;
+	uint64_t speed;	/* KiB/s */
+	uint64_t mbps;	/* bits per us */
+	char *endp;
+	void *buf;
+	int ret = 0;
+
+	if (argc < 4)
+		return -1;
+	addr = simple_strtoul(argv[1], &endp, 16);
+	if (*argv[1] == 0 || *endp != 0)
+		return -1;
+	offset = simple_strtoul(argv[2], &endp, 16);
+	if (*argv[2] == 0 || *endp != 0)
+		return -1;
+	len = simple_strtoul(argv[3], &endp, 16);
+	if (*argv[3] == 0 || *endp != 0 || !len)
+		return -1;
+	if (argc > 4) {
+		count = simple_strtoul(argv[4], &endp, 10);
+		if (*argv[4] == 0 || *endp != 0 || !count)
+			return -1;
+	}
+
+	if (offset + len > flash->size) {
+		printf("ERROR: attempting %s past flash size (%#x)\n",
+		       argv[0], flash->size);
+		return 1;
+	}
+
+	buf = map_physmem(addr, len, MAP_WRBACK);
+	if (!buf && addr) {
+		puts("Failed to map physical memory\n");
+		return 1;
+	}
+
+	for (i = 0; i < count; i++) {
+		start = timer_get_us();
+		ret = spi_flash_read(flash, offset, len, buf);
+		us = timer_get_us() - start;
+		if (ret) {
+			printf("Read failed: %d\n", ret);
+			break;
+		}
+		total += us;
+		best = min(best, us);
+	}
+
+	unmap_physmem(buf, len);
+	if (ret)
+		return 1;
+
+	total = max(total, 1UL);
+	speed = (uint64_t)len * count * 1000000;
+	do_div(speed, total * 1024);
+	mbps = (uint64_t)len * count * 8;
+	do_div(mbps, total);
+	printf("SF: %lu x %lu bytes @ %#lx: avg %lu us, best %lu us, %u KiB/s %u Mbps\n",
+	       count, len, offset, total / count, best, (uint)speed,
+	       (uint)mbps);
+
+	return 0;
+}
+#endif
+
 static int do_spi_flash(cmd_tbl_t *cmdtp, int flag, int argc,
 			char * const argv[])
 {
@@ -577,6 +712,10 @@ static int do_spi_flash(cmd_tbl_t *cmdtp, int flag, int argc,
 #ifdef CONFIG_CMD_SF_TEST
 	else if (!strcmp(cmd, "test"))
 		ret = do_spi_flash_test(argc, argv);
+#endif
+#ifdef CONFIG_CMD_SF_BENCH
+	else if (!strcmp(cmd, "bench"))
+		ret = do_spi_flash_bench(argc, argv);
 #endif
 	else
 		ret = -1;
@@ -596,8 +735,15 @@ usage:
 #define SF_TEST_HELP
 #endif
 
+#ifdef CONFIG_CMD_SF_BENCH
+#define SF_BENCH_HELP "\nsf bench addr offset len [count]	" \
+		"- measure read throughput"
+#else
+#define SF_BENCH_HELP
+#endif
+
 U_BOOT_CMD(
-	sf,	5,	1,	do_spi_flash,
+	sf,	6,	1,	do_spi_flash,
 	"SPI flash sub-system",
 	"probe [[bus:]cs] [hz] [mode]	- init flash device on given SPI bus\n"
 	"				  and chip select\n"
@@ -616,4 +762,5 @@ U_BOOT_CMD(
 	"sf protect lock/unlock sector len	- protect/unprotect 'len' bytes starting\n"
 	"					  at address 'sector'\n"
 	SF_TEST_HELP
+	SF_BENCH_HELP
 );
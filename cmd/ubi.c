@@ -320,11 +320,12 @@ int ubi_volume_write(char *volume, void *buf, size_t size)
 int ubi_volume_read(char *volume, char *buf, size_t size)
 {
 	int err, lnum, off, len, tbuf_size;
-	void *tbuf;
+	void *tbuf, *rbuf;
 	unsigned long long tmp;
 	struct ubi_volume *vol;
 	loff_t offp = 0;
 	size_t len_read;
+	ulong time;
 
 	vol = ubi_find_volume(volume);
 	if (vol == NULL)
@@ -367,11 +368,24 @@ int ubi_volume_read(char *volume, char *buf, size_t size)
 	off = do_div(tmp, vol->usable_leb_size);
 	lnum = tmp;
 	len_read = size;
+	time = get_timer(0);
 	do {
 		if (off + len >= vol->usable_leb_size)
 			len = vol->usable_leb_size - off;
 
-		err = ubi_eba_read_leb(ubi, vol, lnum, tbuf, off, len, 0);
+		/*
+		 * Read straight into the destination when the driver may DMA
+		 * to it, so only an unaligned start or tail goes through tbuf.
+		 */
+		if (IS_ALIGNED((uintptr_t)buf, ARCH_DMA_MINALIGN) &&
+		    len >= ARCH_DMA_MINALIGN) {
+			len = round_down(len, ARCH_DMA_MINALIGN);
+			rbuf = buf;
+		} else {
+			rbuf = tbuf;
+		}
+
+		err = ubi_eba_read_leb(ubi, vol, lnum, rbuf, off, len, 0);
 		if (err) {
 			printf("read err %x\n", err);
 			err = -err;
@@ -386,14 +400,19 @@ int ubi_volume_read(char *volume, char *buf, size_t size)
 		size -= len;
 		offp += len;
 
-		memcpy(buf, tbuf, len);
+		if (rbuf == tbuf)
+			memcpy(buf, tbuf, len);
 
 		buf += len;
 		len = size > tbuf_size ? tbuf_size : size;
 	} while (size);
 
-	if (!size)
+	if (!size) {
+		time = get_timer(time);
+		print_read_time(len_read, time);
+
 		env_set_hex("filesize", len_read);
+	}
 
 	free(tbuf);
 	return err;
@@ -55,6 +55,7 @@ struct usb_device_scan {
 };
 
 static LIST_HEAD(usb_scan_list);
+static bool usb_scan_held;
 
 __weak void usb_hub_reset_devices(struct usb_hub_device *hub, int port)
 {
@@ -574,8 +575,6 @@ static int usb_device_list_scan(void)
 			goto out;
 
 		list_for_each_entry_safe(usb_scan, tmp, &usb_scan_list, list) {
-			int ret;
-
 			/* Scan this port */
 			ret = usb_scan_port(usb_scan);
 			if (ret)
@@ -594,6 +593,15 @@ out:
 	return ret;
 }
 
+int usb_hub_scan_hold(bool hold)
+{
+	usb_scan_held = hold;
+	if (hold)
+		return 0;
+
+	return usb_device_list_scan();
+}
+
 static struct usb_hub_device *usb_get_hub_device(struct usb_device *dev)
 {
 	struct usb_hub_device *hub;
@@ -866,8 +874,11 @@ static int usb_hub_configure(struct usb_device *dev)
 	}
 
 	/*
-	 * And now call the scanning code which loops over the generated list
+	 * And now call the scanning code which loops over the generated list,
+	 * unless the ports of more hubs are to be powered up first
 	 */
+	if (usb_scan_held)
+		return 0;
 	ret = usb_device_list_scan();
 
 	return ret;
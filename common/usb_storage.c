@@ -738,8 +738,29 @@ static int usb_stor_BBB_transport(struct scsi_cmd *srb, struct us_data *us)
 	else
 		pipe = pipeout;
 
-	result = usb_bulk_msg(us->pusb_dev, pipe, srb->pdata, srb->datalen,
-			      &data_actlen, USB_CNTL_TIMEOUT * 5);
+	if (CONFIG_IS_ENABLED(DM_USB) && dir_in) {
+		/*
+		 * The status comes in on the same endpoint as the data, so let
+		 * the host controller queue both.
+		 */
+		struct usb_bulk_xfer xfers[2] = {
+			{ .buffer = srb->pdata, .length = srb->datalen },
+			{ .buffer = csw, .length = UMASS_BBB_CSW_SIZE },
+		};
+
+		result = submit_bulk_msg_batch(us->pusb_dev, pipein, xfers, 2);
+		data_actlen = xfers[0].act_len;
+		if (!xfers[0].status) {
+			if (result || xfers[1].status)
+				goto st;
+			actlen = xfers[1].act_len;
+			goto check_csw;
+		}
+	} else {
+		result = usb_bulk_msg(us->pusb_dev, pipe, srb->pdata,
+				      srb->datalen, &data_actlen,
+				      USB_CNTL_TIMEOUT * 5);
+	}
 	/* special handling of STALL in DATA phase */
 	if ((result < 0) && (us->pusb_dev->status & USB_ST_STALLED)) {
 		debug("DATA:stall\n");
@@ -785,6 +806,7 @@ again:
 		usb_stor_BBB_reset(us);
 		return USB_STOR_TRANSPORT_FAILED;
 	}
+check_csw:
 #ifdef BBB_XPORT_TRACE
 	ptr = (unsigned char *)csw;
 	for (index = 0; index < UMASS_BBB_CSW_SIZE; index++)
@@ -954,9 +976,16 @@ static void usb_stor_set_max_xfer_blk(struct usb_device *udev,
 	 * Windows 7 limiting transfers to 128 sectors for both USB2 and USB3
 	 * and Apple Mac OS X 10.11 limiting transfers to 256 sectors for USB2
 	 * and 2048 for USB3 devices.
+	 *
+	 * Each command costs a CBW and a CSW round trip, which dominates with
+	 * the small limit on SuperSpeed. Follow Mac OS X and allow 2048
+	 * sectors for USB3 devices, which are not affected by the IDE legacy.
 	 */
 	unsigned short blk = 240;
 
+	if (udev->speed >= USB_SPEED_SUPER)
+		blk = 2048;
+
 #if CONFIG_IS_ENABLED(DM_USB)
 	size_t size;
 	int ret;
@@ -52,6 +52,13 @@ struct ahci_uc_priv *probe_ent = NULL;
 #define WAIT_MS_LINKUP	200
 
 #define AHCI_CAP_S64A BIT(31)
+#define AHCI_CAP_SNCQ BIT(30)
+#define AHCI_CAP_SCLO BIT(24)
+#define AHCI_CAP_NCS(cap)	((((cap) >> 8) & 0x1f) + 1)
+
+/* Command list, received FIS area and @slots command tables */
+#define AHCI_PORT_DMA_SZ(slots)	(AHCI_CMD_SLOT_SZ * AHCI_MAX_CMD_SLOT + \
+				 AHCI_RX_FIS_SZ + (slots) * AHCI_CMD_TBL_SZ)
 
 __weak void __iomem *ahci_port_base(void __iomem *base, u32 port)
 {
@@ -83,14 +90,20 @@ static void ahci_dcache_invalidate_range(unsigned long begin, unsigned long len)
 	invalidate_dcache_range(start, end);
 }
 
+static ulong ahci_cmd_tbl(struct ahci_ioports *pp, int slot)
+{
+	return pp->cmd_tbl + slot * AHCI_CMD_TBL_SZ;
+}
+
 /*
  * Ensure data for SATA controller is flushed out of dcache and
  * written to physical memory.
  */
-static void ahci_dcache_flush_sata_cmd(struct ahci_ioports *pp)
+static void ahci_dcache_flush_sata_cmd(struct ahci_ioports *pp, int slot)
 {
 	ahci_dcache_flush_range((unsigned long)pp->cmd_slot,
-				AHCI_PORT_PRIV_DMA_SZ);
+				AHCI_CMD_SLOT_SZ * AHCI_MAX_CMD_SLOT);
+	ahci_dcache_flush_range(ahci_cmd_tbl(pp, slot), AHCI_CMD_TBL_SZ);
 }
 
 static int waiting_for_cmd_completed(void __iomem *offset,
@@ -491,11 +504,12 @@ static int ahci_init_one(struct ahci_uc_priv *uc_priv, pci_dev_t dev)
 
 #define MAX_DATA_BYTE_COUNT  (4*1024*1024)
 
-static int ahci_fill_sg(struct ahci_uc_priv *uc_priv, u8 port,
+static int ahci_fill_sg(struct ahci_uc_priv *uc_priv, u8 port, int slot,
 			unsigned char *buf, int buf_len)
 {
 	struct ahci_ioports *pp = &(uc_priv->port[port]);
-	struct ahci_sg *ahci_sg = pp->cmd_tbl_sg;
+	struct ahci_sg *ahci_sg = (void *)pp->cmd_tbl_sg +
+				  slot * AHCI_CMD_TBL_SZ;
 	u32 sg_count;
 	int i;
 
@@ -527,14 +541,16 @@ static int ahci_fill_sg(struct ahci_uc_priv *uc_priv, u8 port,
 }
 
 
-static void ahci_fill_cmd_slot(struct ahci_ioports *pp, u32 opts)
+static void ahci_fill_cmd_slot(struct ahci_ioports *pp, int slot, u32 opts)
 {
-	pp->cmd_slot->opts = cpu_to_le32(opts);
-	pp->cmd_slot->status = 0;
-	pp->cmd_slot->tbl_addr = cpu_to_le32((u32)pp->cmd_tbl & 0xffffffff);
+	struct ahci_cmd_hdr *cmd_hdr = &pp->cmd_slot[slot];
+	ulong cmd_tbl = ahci_cmd_tbl(pp, slot);
+
+	cmd_hdr->opts = cpu_to_le32(opts);
+	cmd_hdr->status = 0;
+	cmd_hdr->tbl_addr = cpu_to_le32((u32)cmd_tbl & 0xffffffff);
 #ifdef CONFIG_PHYS_64BIT
-	pp->cmd_slot->tbl_addr_hi =
-	    cpu_to_le32((u32)(((pp->cmd_tbl) >> 16) >> 16));
+	cmd_hdr->tbl_addr_hi = cpu_to_le32((u32)((cmd_tbl >> 16) >> 16));
 #endif
 }
 
@@ -569,13 +585,19 @@ static int ahci_port_start(struct ahci_uc_priv *uc_priv, u8 port)
 		return -1;
 	}
 
-	mem = memalign(2048, AHCI_PORT_PRIV_DMA_SZ);
+	/* NCQ needs a command table for each slot the controller has */
+	if (uc_priv->cap & AHCI_CAP_SNCQ)
+		pp->nr_slots = AHCI_CAP_NCS(uc_priv->cap);
+	else
+		pp->nr_slots = 1;
+
+	mem = memalign(2048, AHCI_PORT_DMA_SZ(pp->nr_slots));
 	if (!mem) {
 		free(pp);
 		printf("%s: No mem for table!\n", __func__);
 		return -ENOMEM;
 	}
-	memset(mem, 0, AHCI_PORT_PRIV_DMA_SZ);
+	memset(mem, 0, AHCI_PORT_DMA_SZ(pp->nr_slots));
 
 	/*
 	 * First item in chunk of DMA memory: 32-slot command table,
@@ -584,7 +606,7 @@ static int ahci_port_start(struct ahci_uc_priv *uc_priv, u8 port)
 	pp->cmd_slot =
 		(struct ahci_cmd_hdr *)(uintptr_t)virt_to_phys((void *)mem);
 	debug("cmd_slot = %p\n", pp->cmd_slot);
-	mem += (AHCI_CMD_SLOT_SZ + 224);
+	mem += AHCI_CMD_SLOT_SZ * AHCI_MAX_CMD_SLOT;
 
 	/*
 	 * Second item: Received-FIS area
@@ -593,8 +615,8 @@ static int ahci_port_start(struct ahci_uc_priv *uc_priv, u8 port)
 	mem += AHCI_RX_FIS_SZ;
 
 	/*
-	 * Third item: data area for storing a single command
-	 * and its scatter-gather table
+	 * Third item: data area for storing the commands and their
+	 * scatter-gather tables, one per slot
 	 */
 	pp->cmd_tbl = virt_to_phys((void *)mem);
 	debug("cmd_tbl_dma = %lx\n", pp->cmd_tbl);
@@ -653,11 +675,11 @@ static int ahci_device_data_io(struct ahci_uc_priv *uc_priv, u8 port, u8 *fis,
 
 	memcpy((unsigned char *)pp->cmd_tbl, fis, fis_len);
 
-	sg_count = ahci_fill_sg(uc_priv, port, buf, buf_len);
+	sg_count = ahci_fill_sg(uc_priv, port, 0, buf, buf_len);
 	opts = (fis_len >> 2) | (sg_count << 16) | (is_write << 6);
-	ahci_fill_cmd_slot(pp, opts);
+	ahci_fill_cmd_slot(pp, 0, opts);
 
-	ahci_dcache_flush_sata_cmd(pp);
+	ahci_dcache_flush_sata_cmd(pp, 0);
 	ahci_dcache_flush_range((unsigned long)buf, (unsigned long)buf_len);
 
 	writel_with_flush(1, port_mmio + PORT_CMD_ISSUE);
@@ -675,6 +697,170 @@ static int ahci_device_data_io(struct ahci_uc_priv *uc_priv, u8 port, u8 *fis,
 	return 0;
 }
 
+/*
+ * Bring a port back to a usable state after a failed command: restart the
+ * command list engine, using a command list override if the device is
+ * still busy, and clear the error status.
+ */
+static int ahci_port_recover(struct ahci_uc_priv *uc_priv, u8 port)
+{
+	void __iomem *port_mmio = uc_priv->port[port].port_mmio;
+	u32 cmd, tmp;
+
+	cmd = readl(port_mmio + PORT_CMD);
+	writel_with_flush(cmd & ~PORT_CMD_START, port_mmio + PORT_CMD);
+	if (waiting_for_cmd_completed(port_mmio + PORT_CMD, 500,
+				      PORT_CMD_LIST_ON))
+		return -ETIMEDOUT;
+
+	tmp = readl(port_mmio + PORT_SCR_ERR);
+	writel(tmp, port_mmio + PORT_SCR_ERR);
+	tmp = readl(port_mmio + PORT_IRQ_STAT);
+	writel(tmp, port_mmio + PORT_IRQ_STAT);
+
+	if (readl(port_mmio + PORT_TFDATA) & (ATA_BUSY | ATA_DRQ)) {
+		if (!(uc_priv->cap & AHCI_CAP_SCLO))
+			return -EIO;
+		writel_with_flush(cmd | PORT_CMD_CLO, port_mmio + PORT_CMD);
+		if (waiting_for_cmd_completed(port_mmio + PORT_CMD, 500,
+					      PORT_CMD_CLO))
+			return -ETIMEDOUT;
+	}
+
+	writel_with_flush(cmd | PORT_CMD_START, port_mmio + PORT_CMD);
+
+	return 0;
+}
+
+/*
+ * The device aborts all queued commands on an NCQ error and only accepts
+ * new ones after the NCQ error log has been read.
+ */
+static int ahci_ncq_clear_error(struct ahci_uc_priv *uc_priv, u8 port)
+{
+	ALLOC_CACHE_ALIGN_BUFFER(u8, log, ATA_SECT_SIZE);
+	u8 fis[20];
+	int ret;
+
+	ret = ahci_port_recover(uc_priv, port);
+	if (ret)
+		return ret;
+
+	memset(fis, 0, sizeof(fis));
+	fis[0] = 0x27;		/* Host to device FIS. */
+	fis[1] = 1 << 7;	/* Command FIS. */
+	fis[2] = ATA_CMD_READ_LOG_EXT;
+	fis[4] = ATA_LOG_SATA_NCQ;
+	fis[12] = 1;		/* one sector */
+
+	if (ahci_device_data_io(uc_priv, port, fis, sizeof(fis), log,
+				ATA_SECT_SIZE, 0))
+		return -EIO;
+
+	debug("%s: port %d: NCQ error on tag %d, status 0x%x error 0x%x\n",
+	      __func__, port, log[0] & 0x1f, log[2], log[3]);
+
+	return 0;
+}
+
+/*
+ * Transfer @blocks sectors with READ/WRITE FPDMA QUEUED commands of up to
+ * MAX_SATA_BLOCKS_READ_WRITE sectors each, keeping up to ncq_depth of them
+ * in flight. The tag of a command is its slot number. A slot is refilled
+ * as soon as the device reports its command done in PxSACT, so the device
+ * always has work queued.
+ */
+static int ahci_ncq_data_io(struct ahci_uc_priv *uc_priv, u8 port,
+			    lbaint_t lba, u32 blocks, u8 *buf, u8 is_write)
+{
+	struct ahci_ioports *pp = &(uc_priv->port[port]);
+	void __iomem *port_mmio = pp->port_mmio;
+	const ulong len = blocks * ATA_SECT_SIZE;
+	u32 busy = 0, issue, active, opts, now_blocks;
+	u8 *data = buf;
+	int tag, sg_count;
+	ulong start;
+	u8 *fis;
+
+	writel(PORT_IRQ_FATAL, port_mmio + PORT_IRQ_STAT);
+	ahci_dcache_flush_range((unsigned long)data, len);
+
+	start = get_timer(0);
+	while (blocks || busy) {
+		issue = 0;
+		for (tag = 0; blocks && tag < pp->ncq_depth; tag++) {
+			if (busy & BIT(tag))
+				continue;
+
+			now_blocks = min_t(u32, MAX_SATA_BLOCKS_READ_WRITE,
+					   blocks);
+
+			fis = (u8 *)ahci_cmd_tbl(pp, tag);
+			memset(fis, 0, 20);
+			fis[0] = 0x27;		/* Host to device FIS. */
+			fis[1] = 1 << 7;	/* Command FIS. */
+			fis[2] = is_write ? ATA_CMD_FPDMA_WRITE :
+					    ATA_CMD_FPDMA_READ;
+			/* The sector count goes in the features field */
+			fis[3] = now_blocks & 0xff;
+			fis[11] = (now_blocks >> 8) & 0xff;
+			fis[4] = lba & 0xff;
+			fis[5] = (lba >> 8) & 0xff;
+			fis[6] = (lba >> 16) & 0xff;
+			fis[7] = 1 << 6; /* device reg: set LBA mode */
+			fis[8] = (lba >> 24) & 0xff;
+			fis[9] = ((u64)lba >> 32) & 0xff;
+			fis[10] = ((u64)lba >> 40) & 0xff;
+			fis[12] = tag << 3;
+
+			sg_count = ahci_fill_sg(uc_priv, port, tag, buf,
+						now_blocks * ATA_SECT_SIZE);
+			if (sg_count < 0)
+				goto err;
+			opts = 5 | (sg_count << 16) | (is_write << 6);
+			ahci_fill_cmd_slot(pp, tag, opts);
+			ahci_dcache_flush_sata_cmd(pp, tag);
+
+			issue |= BIT(tag);
+			buf += now_blocks * ATA_SECT_SIZE;
+			blocks -= now_blocks;
+			lba += now_blocks;
+		}
+
+		if (issue) {
+			busy |= issue;
+			writel(issue, port_mmio + PORT_SCR_ACT);
+			writel_with_flush(issue, port_mmio + PORT_CMD_ISSUE);
+		}
+
+		if (readl(port_mmio + PORT_IRQ_STAT) & PORT_IRQ_FATAL) {
+			debug("%s: port %d: error, PxIS 0x%x PxTFD 0x%x\n",
+			      __func__, port,
+			      readl(port_mmio + PORT_IRQ_STAT),
+			      readl(port_mmio + PORT_TFDATA));
+			goto err;
+		}
+
+		active = readl(port_mmio + PORT_SCR_ACT);
+		if (busy & ~active) {
+			busy &= active;
+			start = get_timer(0);
+		} else if (get_timer(start) > WAIT_MS_DATAIO) {
+			printf("timeout exit!\n");
+			goto err;
+		}
+	}
+
+	ahci_dcache_invalidate_range((unsigned long)data, len);
+
+	return 0;
+
+err:
+	ahci_ncq_clear_error(uc_priv, port);
+
+	return -EIO;
+}
+
 
 static char *ata_id_strcpy(u16 *target, u16 *src, int len)
 {
@@ -700,6 +886,7 @@ static int ata_scsiop_inquiry(struct ahci_uc_priv *uc_priv,
 	u8 fis[20];
 	u16 *idbuf;
 	ALLOC_CACHE_ALIGN_BUFFER(u16, tmpid, ATA_ID_WORDS);
+	struct ahci_ioports *pp;
 	u8 port;
 
 	/* Clean ccb data buffer */
@@ -738,6 +925,16 @@ static int ata_scsiop_inquiry(struct ahci_uc_priv *uc_priv,
 	memcpy(idbuf, tmpid, ATA_ID_WORDS * 2);
 	ata_swap_buf_le16(idbuf, ATA_ID_WORDS);
 
+	/* Queue commands only if both the device and the port can */
+	pp = &uc_priv->port[port];
+	pp->ncq_depth = 0;
+	if (ata_id_has_ncq(idbuf))
+		pp->ncq_depth = min_t(u32, ata_id_queue_depth(idbuf),
+				      pp->nr_slots);
+	if (pp->ncq_depth < 2)
+		pp->ncq_depth = 0;
+	debug("scsi_ahci: port %d NCQ depth %d\n", port, pp->ncq_depth);
+
 	memcpy(&pccb->pdata[8], "ATA     ", 8);
 	ata_id_strcpy((u16 *)&pccb->pdata[16], &idbuf[ATA_ID_PROD], 16);
 	ata_id_strcpy((u16 *)&pccb->pdata[32], &idbuf[ATA_ID_FW_REV], 4);
@@ -750,21 +947,25 @@ static int ata_scsiop_inquiry(struct ahci_uc_priv *uc_priv,
 
 
 /*
- * SCSI READ10/WRITE10 command operation.
+ * SCSI READ10/WRITE10 and READ16/WRITE16 command operation.
  */
 static int ata_scsiop_read_write(struct ahci_uc_priv *uc_priv,
 				 struct scsi_cmd *pccb, u8 is_write)
 {
+	const bool is_16 = pccb->cmd[0] == SCSI_READ16 ||
+			   pccb->cmd[0] == SCSI_WRITE16;
 	lbaint_t lba = 0;
-	u16 blocks = 0;
+	u32 blocks = 0;
 	u8 fis[20];
 	u8 *user_buffer = pccb->pdata;
 	u32 user_buffer_size = pccb->datalen;
 
 	/* Retrieve the base LBA number from the ccb structure. */
-	if (pccb->cmd[0] == SCSI_READ16) {
-		memcpy(&lba, pccb->cmd + 2, 8);
-		lba = be64_to_cpu(lba);
+	if (is_16) {
+		u64 temp;
+
+		memcpy(&temp, pccb->cmd + 2, 8);
+		lba = be64_to_cpu(temp);
 	} else {
 		u32 temp;
 		memcpy(&temp, pccb->cmd + 2, 4);
@@ -782,14 +983,35 @@ static int ata_scsiop_read_write(struct ahci_uc_priv *uc_priv,
 	 *
 	 * WARNING: one or two older ATA drives treat 0 as 0...
 	 */
-	if (pccb->cmd[0] == SCSI_READ16)
-		blocks = (((u16)pccb->cmd[13]) << 8) | ((u16) pccb->cmd[14]);
+	if (is_16)
+		blocks = ((u32)pccb->cmd[10] << 24) |
+			 ((u32)pccb->cmd[11] << 16) |
+			 ((u32)pccb->cmd[12] << 8) | (u32)pccb->cmd[13];
 	else
 		blocks = (((u16)pccb->cmd[7]) << 8) | ((u16) pccb->cmd[8]);
 
 	debug("scsi_ahci: %s %u blocks starting from lba 0x" LBAFU "\n",
 	      is_write ?  "write" : "read", blocks, lba);
 
+	if (uc_priv->port[pccb->target].ncq_depth) {
+		if (blocks * ATA_SECT_SIZE > user_buffer_size) {
+			printf("scsi_ahci: Error: buffer too small.\n");
+			return -EIO;
+		}
+
+		if (!ahci_ncq_data_io(uc_priv, pccb->target, lba, blocks,
+				      user_buffer, is_write)) {
+			if (is_write && ata_io_flush(uc_priv, pccb->target))
+				return -EIO;
+			return 0;
+		}
+
+		/* Redo the whole transfer with non-queued commands */
+		printf("scsi_ahci: NCQ failed on port %d, disabling it\n",
+		       pccb->target);
+		uc_priv->port[pccb->target].ncq_depth = 0;
+	}
+
 	/* Preset the FIS */
 	memset(fis, 0, sizeof(fis));
 	fis[0] = 0x27;		 /* Host to device FIS. */
@@ -801,7 +1023,7 @@ static int ata_scsiop_read_write(struct ahci_uc_priv *uc_priv,
 		u16 now_blocks; /* number of blocks per iteration */
 		u32 transfer_size; /* number of bytes per iteration */
 
-		now_blocks = min((u16)MAX_SATA_BLOCKS_READ_WRITE, blocks);
+		now_blocks = min_t(u32, MAX_SATA_BLOCKS_READ_WRITE, blocks);
 
 		transfer_size = ATA_SECT_SIZE * now_blocks;
 		if (transfer_size > user_buffer_size) {
@@ -820,7 +1042,7 @@ static int ata_scsiop_read_write(struct ahci_uc_priv *uc_priv,
 		fis[7] = 1 << 6; /* device reg: set LBA mode */
 		fis[8] = ((lba >> 24) & 0xff);
 #ifdef CONFIG_SYS_64BIT_LBA
-		if (pccb->cmd[0] == SCSI_READ16) {
+		if (is_16) {
 			fis[9] = ((lba >> 32) & 0xff);
 			fis[10] = ((lba >> 40) & 0xff);
 		}
@@ -944,6 +1166,7 @@ static int ahci_scsi_exec(struct udevice *dev, struct scsi_cmd *pccb)
 	case SCSI_READ10:
 		ret = ata_scsiop_read_write(uc_priv, pccb, 0);
 		break;
+	case SCSI_WRITE16:
 	case SCSI_WRITE10:
 		ret = ata_scsiop_read_write(uc_priv, pccb, 1);
 		break;
@@ -1122,8 +1345,8 @@ static int ata_io_flush(struct ahci_uc_priv *uc_priv, u8 port)
 	fis[2] = ATA_CMD_FLUSH_EXT;
 
 	memcpy((unsigned char *)pp->cmd_tbl, fis, 20);
-	ahci_fill_cmd_slot(pp, cmd_fis_len);
-	ahci_dcache_flush_sata_cmd(pp);
+	ahci_fill_cmd_slot(pp, 0, cmd_fis_len);
+	ahci_dcache_flush_sata_cmd(pp, 0);
 	writel_with_flush(1, port_mmio + PORT_CMD_ISSUE);
 
 	if (waiting_for_cmd_completed(port_mmio + PORT_CMD_ISSUE,
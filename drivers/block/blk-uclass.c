@@ -462,6 +462,106 @@ unsigned long blk_dwrite(struct blk_desc *block_dev, lbaint_t start,
 	return ops->write(dev, start, blkcnt, buffer);
 }
 
+unsigned long blk_dread_sg(struct blk_desc *block_dev, lbaint_t start,
+			   const struct blk_sg *sg, int nsegs)
+{
+	struct udevice *dev = block_dev->bdev;
+	const struct blk_ops *ops = blk_get_ops(dev);
+	ulong blks, total = 0;
+	int i;
+
+	if (ops->read_sg)
+		return ops->read_sg(dev, start, sg, nsegs);
+	if (!ops->read)
+		return -ENOSYS;
+
+	for (i = 0; i < nsegs; i++) {
+		blks = ops->read(dev, start + total, sg[i].blkcnt,
+				 sg[i].buffer);
+		if (IS_ERR_VALUE(blks))
+			return blks;
+		total += blks;
+		if (blks != sg[i].blkcnt)
+			break;
+	}
+
+	return total;
+}
+
+int blk_submit(struct udevice *dev, struct blk_req *req)
+{
+	struct blk_desc *desc = dev_get_uclass_platdata(dev);
+	const struct blk_ops *ops = blk_get_ops(dev);
+	ulong blks;
+
+	req->done = false;
+	req->result = 0;
+	req->submitted = 0;
+	req->inflight = 0;
+
+	if (req->write)
+		blkcache_invalidate(desc->if_type, desc->devnum);
+
+	if (ops->submit)
+		return ops->submit(dev, req);
+
+	if (req->write ? !ops->write : !ops->read)
+		return -ENOSYS;
+
+	if (req->write)
+		blks = ops->write(dev, req->start, req->blkcnt, req->buffer);
+	else
+		blks = ops->read(dev, req->start, req->blkcnt, req->buffer);
+	req->submitted = req->blkcnt;
+	req->result = blks;
+	req->done = true;
+
+	return 0;
+}
+
+int blk_poll(struct udevice *dev)
+{
+	const struct blk_ops *ops = blk_get_ops(dev);
+
+	if (!ops->poll)
+		return 0;
+
+	return ops->poll(dev);
+}
+
+long blk_wait(struct udevice *dev, struct blk_req *req)
+{
+	const struct blk_ops *ops = blk_get_ops(dev);
+	lbaint_t submitted = req->submitted;
+	int inflight = req->inflight;
+	ulong start = get_timer(0);
+	int ret;
+
+	while (!req->done) {
+		ret = blk_poll(dev);
+		if (ret < 0)
+			return ret;
+		/* Nothing left to do, @req was never submitted */
+		if (!ret && !req->done)
+			return -EINVAL;
+
+		if (req->submitted != submitted || req->inflight != inflight) {
+			submitted = req->submitted;
+			inflight = req->inflight;
+			start = get_timer(0);
+		} else if (!req->done &&
+			   get_timer(start) > BLK_WAIT_TIMEOUT_MS) {
+			if (ops->cancel)
+				ops->cancel(dev, req);
+			req->result = -ETIMEDOUT;
+			req->done = true;
+			return -ETIMEDOUT;
+		}
+	}
+
+	return req->result;
+}
+
 unsigned long blk_derase(struct blk_desc *block_dev, lbaint_t start,
 			 lbaint_t blkcnt)
 {
@@ -88,6 +88,64 @@ static unsigned long host_block_write(struct blk_desc *block_dev,
 }
 
 #ifdef CONFIG_BLK
+static int host_block_submit(struct udevice *dev, struct blk_req *req)
+{
+	struct host_block_dev *host_dev = dev_get_platdata(dev);
+
+	list_add_tail(&req->node, &host_dev->reqs);
+	host_dev->nr_reqs++;
+
+	return 0;
+}
+
+/*
+ * Complete one request per call, the last one submitted first, so that
+ * callers can rely neither on the order of completion nor on requests
+ * completing together.
+ */
+static int host_block_poll(struct udevice *dev)
+{
+	struct host_block_dev *host_dev = dev_get_platdata(dev);
+	struct blk_req *req;
+	ulong blks;
+
+	if (list_empty(&host_dev->reqs))
+		return 0;
+
+	req = list_last_entry(&host_dev->reqs, struct blk_req, node);
+	list_del(&req->node);
+	host_dev->nr_reqs--;
+
+	if (req->write)
+		blks = host_block_write(dev, req->start, req->blkcnt,
+					req->buffer);
+	else
+		blks = host_block_read(dev, req->start, req->blkcnt,
+				       req->buffer);
+	req->submitted = req->blkcnt;
+	req->result = blks;
+	req->done = true;
+
+	return host_dev->nr_reqs;
+}
+
+static void host_block_cancel(struct udevice *dev, struct blk_req *req)
+{
+	struct host_block_dev *host_dev = dev_get_platdata(dev);
+
+	list_del(&req->node);
+	host_dev->nr_reqs--;
+}
+
+static int host_block_probe(struct udevice *dev)
+{
+	struct host_block_dev *host_dev = dev_get_platdata(dev);
+
+	INIT_LIST_HEAD(&host_dev->reqs);
+
+	return 0;
+}
+
 int host_dev_bind(int devnum, char *filename)
 {
 	struct host_block_dev *host_dev;
@@ -222,11 +280,15 @@ int host_get_dev_err(int devnum, struct blk_desc **blk_devp)
 static const struct blk_ops sandbox_host_blk_ops = {
 	.read	= host_block_read,
 	.write	= host_block_write,
+	.submit	= host_block_submit,
+	.poll	= host_block_poll,
+	.cancel	= host_block_cancel,
 };
 
 U_BOOT_DRIVER(sandbox_host_blk) = {
 	.name		= "sandbox_host_blk",
 	.id		= UCLASS_BLK,
+	.probe		= host_block_probe,
 	.ops		= &sandbox_host_blk_ops,
 	.platdata_auto_alloc_size = sizeof(struct host_block_dev),
 };
@@ -11,6 +11,7 @@
 #include <command.h>
 #include <dm.h>
 #include <dm/device-internal.h>
+#include <env.h>
 #include <errno.h>
 #include <mmc.h>
 #include <part.h>
@@ -21,6 +22,8 @@
 #include <div64.h>
 #include "mmc_private.h"
 
+DECLARE_GLOBAL_DATA_PTR;
+
 #define DEFAULT_CMD6_TIMEOUT_MS  500
 
 static int mmc_set_signal_voltage(struct mmc *mmc, uint signal_voltage);
@@ -298,6 +301,20 @@ int mmc_set_blocklen(struct mmc *mmc, int len)
 	return err;
 }
 
+int mmc_set_blockcount(struct mmc *mmc, unsigned int blockcount,
+		       bool is_rel_write)
+{
+	struct mmc_cmd cmd = {0};
+
+	cmd.cmdidx = MMC_CMD_SET_BLOCK_COUNT;
+	cmd.cmdarg = blockcount & 0x0000FFFF;
+	if (is_rel_write)
+		cmd.cmdarg |= 1 << 31;
+	cmd.resp_type = MMC_RSP_R1;
+
+	return mmc_send_cmd(mmc, &cmd, NULL);
+}
+
 #ifdef MMC_SUPPORTS_TUNING
 static const u8 tuning_blk_pattern_4bit[] = {
 	0xff, 0x0f, 0xff, 0x00, 0xff, 0xcc, 0xc3, 0xcc,
@@ -368,11 +385,15 @@ int mmc_send_tuning(struct mmc *mmc, u32 opcode, int *cmd_error)
 }
 #endif
 
-static int mmc_read_blocks(struct mmc *mmc, void *dst, lbaint_t start,
-			   lbaint_t blkcnt)
+static int mmc_read_data(struct mmc *mmc, struct mmc_data *data,
+			 lbaint_t start)
 {
 	struct mmc_cmd cmd;
-	struct mmc_data data;
+	lbaint_t blkcnt = data->blocks;
+	bool sbc = mmc_use_cmd23(mmc, blkcnt);
+
+	if (sbc && mmc_set_blockcount(mmc, blkcnt, false))
+		return 0;
 
 	if (blkcnt > 1)
 		cmd.cmdidx = MMC_CMD_READ_MULTIPLE_BLOCK;
@@ -386,15 +407,10 @@ static int mmc_read_blocks(struct mmc *mmc, void *dst, lbaint_t start,
 
 	cmd.resp_type = MMC_RSP_R1;
 
-	data.dest = dst;
-	data.blocks = blkcnt;
-	data.blocksize = mmc->read_bl_len;
-	data.flags = MMC_DATA_READ;
-
-	if (mmc_send_cmd(mmc, &cmd, &data))
+	if (mmc_send_cmd(mmc, &cmd, data))
 		return 0;
 
-	if (blkcnt > 1) {
+	if (blkcnt > 1 && !sbc) {
 		cmd.cmdidx = MMC_CMD_STOP_TRANSMISSION;
 		cmd.cmdarg = 0;
 		cmd.resp_type = MMC_RSP_R1b;
@@ -409,26 +425,29 @@ static int mmc_read_blocks(struct mmc *mmc, void *dst, lbaint_t start,
 	return blkcnt;
 }
 
-#if CONFIG_IS_ENABLED(BLK)
-ulong mmc_bread(struct udevice *dev, lbaint_t start, lbaint_t blkcnt, void *dst)
-#else
-ulong mmc_bread(struct blk_desc *block_dev, lbaint_t start, lbaint_t blkcnt,
-		void *dst)
-#endif
+static int mmc_read_blocks(struct mmc *mmc, void *dst, lbaint_t start,
+			   lbaint_t blkcnt)
 {
-#if CONFIG_IS_ENABLED(BLK)
-	struct blk_desc *block_dev = dev_get_uclass_platdata(dev);
-#endif
-	int dev_num = block_dev->devnum;
-	int err;
-	lbaint_t cur, blocks_todo = blkcnt;
+	struct mmc_data data;
 
-	if (blkcnt == 0)
-		return 0;
+	data.dest = dst;
+	data.blocks = blkcnt;
+	data.blocksize = mmc->read_bl_len;
+	data.flags = MMC_DATA_READ;
+
+	return mmc_read_data(mmc, &data, start);
+}
 
-	struct mmc *mmc = find_mmc_device(dev_num);
+/* Select the hardware partition and check the range before a read */
+static struct mmc *mmc_bread_start(struct blk_desc *block_dev, lbaint_t start,
+				   lbaint_t blkcnt)
+{
+	struct mmc *mmc;
+	int err;
+
+	mmc = find_mmc_device(block_dev->devnum);
 	if (!mmc)
-		return 0;
+		return NULL;
 
 	if (CONFIG_IS_ENABLED(MMC_TINY))
 		err = mmc_switch_part(mmc, block_dev->hwpart);
@@ -436,21 +455,44 @@ ulong mmc_bread(struct blk_desc *block_dev, lbaint_t start, lbaint_t blkcnt,
 		err = blk_dselect_hwpart(block_dev, block_dev->hwpart);
 
 	if (err < 0)
-		return 0;
+		return NULL;
 
 	if ((start + blkcnt) > block_dev->lba) {
 #if !defined(CONFIG_SPL_BUILD) || defined(CONFIG_SPL_LIBCOMMON_SUPPORT)
 		pr_err("MMC: block number 0x" LBAF " exceeds max(0x" LBAF ")\n",
 		       start + blkcnt, block_dev->lba);
 #endif
-		return 0;
+		return NULL;
 	}
 
 	if (mmc_set_blocklen(mmc, mmc->read_bl_len)) {
 		pr_debug("%s: Failed to set blocklen\n", __func__);
-		return 0;
+		return NULL;
 	}
 
+	return mmc;
+}
+
+#if CONFIG_IS_ENABLED(BLK)
+ulong mmc_bread(struct udevice *dev, lbaint_t start, lbaint_t blkcnt, void *dst)
+#else
+ulong mmc_bread(struct blk_desc *block_dev, lbaint_t start, lbaint_t blkcnt,
+		void *dst)
+#endif
+{
+#if CONFIG_IS_ENABLED(BLK)
+	struct blk_desc *block_dev = dev_get_uclass_platdata(dev);
+#endif
+	lbaint_t cur, blocks_todo = blkcnt;
+	struct mmc *mmc;
+
+	if (blkcnt == 0)
+		return 0;
+
+	mmc = mmc_bread_start(block_dev, start, blkcnt);
+	if (!mmc)
+		return 0;
+
 	do {
 		cur = (blocks_todo > mmc->cfg->b_max) ?
 			mmc->cfg->b_max : blocks_todo;
@@ -466,6 +508,58 @@ ulong mmc_bread(struct blk_desc *block_dev, lbaint_t start, lbaint_t blkcnt,
 	return blkcnt;
 }
 
+#if CONFIG_IS_ENABLED(BLK)
+ulong mmc_bread_sg(struct udevice *dev, lbaint_t start,
+		   const struct blk_sg *sg, int nsegs)
+{
+	struct blk_desc *block_dev = dev_get_uclass_platdata(dev);
+	struct mmc *mmc = find_mmc_device(block_dev->devnum);
+	struct mmc_data data;
+	lbaint_t blkcnt = 0;
+	bool gather;
+	int i;
+
+	if (!mmc || nsegs <= 0)
+		return 0;
+
+	gather = (mmc->host_caps & MMC_CAP_SG) && nsegs <= MMC_MAX_SG;
+	for (i = 0; i < nsegs; i++) {
+		if (!sg[i].blkcnt)
+			gather = false;
+		blkcnt += sg[i].blkcnt;
+	}
+
+	/* Hosts without scatter-gather get one transfer per segment */
+	if (!gather || blkcnt > mmc->cfg->b_max) {
+		for (i = 0, blkcnt = 0; i < nsegs; i++) {
+			if (mmc_bread(dev, start + blkcnt, sg[i].blkcnt,
+				      sg[i].buffer) != sg[i].blkcnt)
+				break;
+			blkcnt += sg[i].blkcnt;
+		}
+
+		return blkcnt;
+	}
+
+	mmc = mmc_bread_start(block_dev, start, blkcnt);
+	if (!mmc)
+		return 0;
+
+	data.sg = sg;
+	data.sg_count = nsegs;
+	data.blocks = blkcnt;
+	data.blocksize = mmc->read_bl_len;
+	data.flags = MMC_DATA_READ | MMC_DATA_SG;
+
+	if (mmc_read_data(mmc, &data, start) != blkcnt) {
+		pr_debug("%s: Failed to read blocks\n", __func__);
+		return 0;
+	}
+
+	return blkcnt;
+}
+#endif
+
 static int mmc_go_idle(struct mmc *mmc)
 {
 	struct mmc_cmd cmd;
@@ -890,6 +984,10 @@ static int mmc_get_capabilities(struct mmc *mmc)
 	if (mmc_host_is_spi(mmc))
 		return 0;
 
+	/* SET_BLOCK_COUNT is mandatory since version 3.x */
+	if (mmc->version >= MMC_VERSION_3)
+		mmc->card_caps |= MMC_CAP_CMD23;
+
 	/* Only version 4 supports high-speed */
 	if (mmc->version < MMC_VERSION_4)
 		return 0;
@@ -1296,6 +1394,9 @@ retry_scr:
 	if (mmc->scr[0] & SD_DATA_4BIT)
 		mmc->card_caps |= MMC_MODE_4BIT;
 
+	if (mmc->scr[0] & SD_CMD23_SUPPORT)
+		mmc->card_caps |= MMC_CAP_CMD23;
+
 	/* Version 1.0 doesn't support switching */
 	if (mmc->version == SD_VERSION_1_0)
 		return 0;
@@ -2027,49 +2128,88 @@ static int mmc_select_hs400es(struct mmc *mmc)
 	    ecbv++) \
 		if ((ddr == ecbv->is_ddr) && (caps & ecbv->cap))
 
-static int mmc_select_mode_and_width(struct mmc *mmc, uint card_caps)
+#if CONFIG_IS_ENABLED(MMC_MODE_CACHE)
+static uint mmc_width_cap(uint width)
 {
-	int err;
-	const struct mode_width_tuning *mwt;
-	const struct ext_csd_bus_width *ecbw;
+	switch (width) {
+	case 8:
+		return MMC_MODE_8BIT;
+	case 4:
+		return MMC_MODE_4BIT;
+	case 1:
+		return MMC_MODE_1BIT;
+	default:
+		return 0;
+	}
+}
 
-#ifdef DEBUG
-	mmc_dump_capabilities("mmc", card_caps);
-	mmc_dump_capabilities("host", mmc->host_caps);
-#endif
+/*
+ * The cache entry is "<CID>:<mode>:<width>" in mmcmode<dev>, the CID keeps a
+ * swapped card from using the mode of the previous one.
+ */
+static void mmc_mode_cache_entry(struct mmc *mmc, char *name, char *val,
+				 enum bus_mode mode, uint width)
+{
+	sprintf(name, "mmcmode%d", mmc_get_blk_desc(mmc)->devnum);
+	sprintf(val, "%08x%08x%08x%08x:%d:%d", mmc->cid[0], mmc->cid[1],
+		mmc->cid[2], mmc->cid[3], mode, width);
+}
 
-	if (mmc_host_is_spi(mmc)) {
-		mmc_set_bus_width(mmc, 1);
-		mmc_select_mode(mmc, MMC_LEGACY);
-		mmc_set_clock(mmc, mmc->tran_speed, MMC_CLK_ENABLE);
+/* Return the caps of the cached mode and width if @card_caps allows them */
+static uint mmc_mode_cache_get(struct mmc *mmc, uint card_caps)
+{
+	char name[20], val[48];
+	const char *entry;
+	char *end;
+	uint mode, width, caps;
+
+	if (!(gd->flags & GD_FLG_ENV_READY))
 		return 0;
-	}
 
-	/* Restrict card's capabilities by what the host can do */
-	card_caps &= mmc->host_caps;
+	mmc_mode_cache_entry(mmc, name, val, 0, 0);
+	entry = env_get(name);
+	if (!entry || strncmp(entry, val, 33))
+		return 0;
 
-	/* Only version 4 of MMC supports wider bus widths */
-	if (mmc->version < MMC_VERSION_4)
+	mode = simple_strtoul(entry + 33, &end, 10);
+	if (mode >= MMC_MODES_END || *end != ':')
 		return 0;
+	width = simple_strtoul(end + 1, NULL, 10);
+	caps = MMC_CAP(mode) | mmc_width_cap(width);
 
-	if (!mmc->ext_csd) {
-		pr_debug("No ext_csd found!\n"); /* this should enver happen */
-		return -ENOTSUPP;
-	}
+	return (card_caps & caps) == caps ? caps : 0;
+}
 
-#if CONFIG_IS_ENABLED(MMC_HS200_SUPPORT) || \
-    CONFIG_IS_ENABLED(MMC_HS400_SUPPORT)
-	/*
-	 * In case the eMMC is in HS200/HS400 mode, downgrade to HS mode
-	 * before doing anything else, since a transition from either of
-	 * the HS200/HS400 mode directly to legacy mode is not supported.
-	 */
-	if (mmc->selected_mode == MMC_HS_200 ||
-	    mmc->selected_mode == MMC_HS_400)
-		mmc_set_card_speed(mmc, MMC_HS, true);
-	else
+static void mmc_mode_cache_set(struct mmc *mmc)
+{
+	char name[20], val[48];
+	const char *entry;
+
+	if (!(gd->flags & GD_FLG_ENV_READY))
+		return;
+
+	mmc_mode_cache_entry(mmc, name, val, mmc->selected_mode,
+			     mmc->bus_width);
+	entry = env_get(name);
+	if (!entry || strcmp(entry, val))
+		env_set(name, val);
+}
+#else
+static uint mmc_mode_cache_get(struct mmc *mmc, uint card_caps)
+{
+	return 0;
+}
+
+static void mmc_mode_cache_set(struct mmc *mmc)
+{
+}
 #endif
-		mmc_set_clock(mmc, mmc->legacy_speed, MMC_CLK_ENABLE);
+
+static int mmc_select_mode_and_width_from(struct mmc *mmc, uint card_caps)
+{
+	int err;
+	const struct mode_width_tuning *mwt;
+	const struct ext_csd_bus_width *ecbw;
 
 	for_each_mmc_mode_by_pref(card_caps, mwt) {
 		for_each_supported_width(card_caps & mwt->widths,
@@ -2158,6 +2298,63 @@ error:
 		}
 	}
 
+	return -ENOTSUPP;
+}
+
+static int mmc_select_mode_and_width(struct mmc *mmc, uint card_caps)
+{
+	uint cached_caps;
+
+#ifdef DEBUG
+	mmc_dump_capabilities("mmc", card_caps);
+	mmc_dump_capabilities("host", mmc->host_caps);
+#endif
+
+	if (mmc_host_is_spi(mmc)) {
+		mmc_set_bus_width(mmc, 1);
+		mmc_select_mode(mmc, MMC_LEGACY);
+		mmc_set_clock(mmc, mmc->tran_speed, MMC_CLK_ENABLE);
+		return 0;
+	}
+
+	/* Restrict card's capabilities by what the host can do */
+	card_caps &= mmc->host_caps;
+
+	/* Only version 4 of MMC supports wider bus widths */
+	if (mmc->version < MMC_VERSION_4)
+		return 0;
+
+	if (!mmc->ext_csd) {
+		pr_debug("No ext_csd found!\n"); /* this should enver happen */
+		return -ENOTSUPP;
+	}
+
+#if CONFIG_IS_ENABLED(MMC_HS200_SUPPORT) || \
+    CONFIG_IS_ENABLED(MMC_HS400_SUPPORT)
+	/*
+	 * In case the eMMC is in HS200/HS400 mode, downgrade to HS mode
+	 * before doing anything else, since a transition from either of
+	 * the HS200/HS400 mode directly to legacy mode is not supported.
+	 */
+	if (mmc->selected_mode == MMC_HS_200 ||
+	    mmc->selected_mode == MMC_HS_400)
+		mmc_set_card_speed(mmc, MMC_HS, true);
+	else
+#endif
+		mmc_set_clock(mmc, mmc->legacy_speed, MMC_CLK_ENABLE);
+
+	/* Try the mode that worked last time before searching them all */
+	cached_caps = mmc_mode_cache_get(mmc, card_caps);
+	if (cached_caps && !mmc_select_mode_and_width_from(mmc, cached_caps))
+		return 0;
+
+	if (!mmc_select_mode_and_width_from(mmc, card_caps)) {
+		/* Only remember the best mode, not one for a boot partition */
+		if (card_caps == (mmc->card_caps & mmc->host_caps))
+			mmc_mode_cache_set(mmc);
+		return 0;
+	}
+
 	pr_err("unable to select a mode\n");
 
 	return -ENOTSUPP;
@@ -16,6 +16,18 @@ int mmc_send_status(struct mmc *mmc, unsigned int *status);
 int mmc_poll_for_busy(struct mmc *mmc, int timeout);
 
 int mmc_set_blocklen(struct mmc *mmc, int len);
+int mmc_set_blockcount(struct mmc *mmc, unsigned int blockcount,
+		       bool is_rel_write);
+
+/*
+ * Multiple block transfers of up to 65535 blocks can announce their length
+ * with SET_BLOCK_COUNT instead of being ended by STOP_TRANSMISSION.
+ */
+static inline bool mmc_use_cmd23(struct mmc *mmc, lbaint_t blkcnt)
+{
+	return blkcnt > 1 && blkcnt <= 0xffff &&
+	       (mmc->card_caps & mmc->host_caps & MMC_CAP_CMD23);
+}
 #ifdef CONFIG_FSL_ESDHC_ADAPTER_IDENT
 void mmc_adapter_card_type_ident(void);
 #endif
@@ -23,6 +35,8 @@ void mmc_adapter_card_type_ident(void);
 #if CONFIG_IS_ENABLED(BLK)
 ulong mmc_bread(struct udevice *dev, lbaint_t start, lbaint_t blkcnt,
 		void *dst);
+ulong mmc_bread_sg(struct udevice *dev, lbaint_t start,
+		   const struct blk_sg *sg, int nsegs);
 #else
 ulong mmc_bread(struct blk_desc *block_dev, lbaint_t start, lbaint_t blkcnt,
 		void *dst);
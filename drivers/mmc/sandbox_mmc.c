@@ -16,15 +16,31 @@ struct sandbox_mmc_plat {
 	struct mmc mmc;
 };
 
+/**
+ * struct sandbox_mmc_priv - state of the emulated card
+ *
+ * @blk_count:	block count set by CMD23 for the next transfer, 0 if none
+ * @open_ended:	a multiple-block transfer is waiting for CMD12
+ */
+struct sandbox_mmc_priv {
+	uint blk_count;
+	bool open_ended;
+};
+
 /**
  * sandbox_mmc_send_cmd() - Emulate SD commands
  *
  * This emulate an SD card version 2. Single-block reads result in zero data.
- * Multiple-block reads return a test string.
+ * Multiple-block reads return a test string, at the start of each segment of
+ * a scatter-gather read. A transfer announced with CMD23 must match the block
+ * count and ends without CMD12.
  */
 static int sandbox_mmc_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
 				struct mmc_data *data)
 {
+	struct sandbox_mmc_priv *priv = dev_get_priv(dev);
+	uint i, blocks;
+
 	switch (cmd->cmdidx) {
 	case MMC_CMD_ALL_SEND_CID:
 		memset(cmd->response, '\0', sizeof(cmd->response));
@@ -61,9 +77,28 @@ static int sandbox_mmc_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
 		memset(data->dest, '\0', data->blocksize);
 		break;
 	case MMC_CMD_READ_MULTIPLE_BLOCK:
-		strcpy(data->dest, "this is a test");
+		if (priv->blk_count && priv->blk_count != data->blocks)
+			return -EILSEQ;
+		priv->open_ended = !priv->blk_count;
+		priv->blk_count = 0;
+		if (!(data->flags & MMC_DATA_SG)) {
+			strcpy(data->dest, "this is a test");
+			break;
+		}
+		for (i = 0, blocks = 0; i < data->sg_count; i++) {
+			strcpy(data->sg[i].buffer, "this is a test");
+			blocks += data->sg[i].blkcnt;
+		}
+		if (blocks != data->blocks)
+			return -EINVAL;
+		break;
+	case MMC_CMD_SET_BLOCK_COUNT:
+		priv->blk_count = cmd->cmdarg & 0xffff;
 		break;
 	case MMC_CMD_STOP_TRANSMISSION:
+		if (!priv->open_ended)
+			return -EILSEQ;
+		priv->open_ended = false;
 		break;
 	case SD_CMD_APP_SEND_OP_COND:
 		cmd->response[0] = OCR_BUSY | OCR_HCS;
@@ -78,7 +113,8 @@ static int sandbox_mmc_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
 	case SD_CMD_APP_SEND_SCR: {
 		u32 *scr = (u32 *)data->dest;
 
-		scr[0] = cpu_to_be32(2 << 24 | 1 << 15);  /* SD version 3 */
+		/* SD version 3, supports CMD23 */
+		scr[0] = cpu_to_be32(2 << 24 | 1 << 15 | SD_CMD23_SUPPORT);
 		break;
 	}
 	default:
@@ -118,7 +154,8 @@ int sandbox_mmc_bind(struct udevice *dev)
 	struct mmc_config *cfg = &plat->cfg;
 
 	cfg->name = dev->name;
-	cfg->host_caps = MMC_MODE_HS_52MHz | MMC_MODE_HS | MMC_MODE_8BIT;
+	cfg->host_caps = MMC_MODE_HS_52MHz | MMC_MODE_HS | MMC_MODE_8BIT |
+			 MMC_CAP_CMD23 | MMC_CAP_SG;
 	cfg->voltages = MMC_VDD_165_195 | MMC_VDD_32_33 | MMC_VDD_33_34;
 	cfg->f_min = 1000000;
 	cfg->f_max = 52000000;
@@ -147,5 +184,6 @@ U_BOOT_DRIVER(mmc_sandbox) = {
 	.bind		= sandbox_mmc_bind,
 	.unbind		= sandbox_mmc_unbind,
 	.probe		= sandbox_mmc_probe,
+	.priv_auto_alloc_size = sizeof(struct sandbox_mmc_priv),
 	.platdata_auto_alloc_size = sizeof(struct sandbox_mmc_plat),
 };
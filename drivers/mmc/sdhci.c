@@ -58,7 +58,7 @@ static void sdhci_transfer_pio(struct sdhci_host *host, struct mmc_data *data)
 	char *offs;
 	for (i = 0; i < data->blocksize; i += 4) {
 		offs = data->dest + i;
-		if (data->flags == MMC_DATA_READ)
+		if (data->flags & MMC_DATA_READ)
 			*(u32 *)offs = sdhci_readl(host, SDHCI_BUFFER);
 		else
 			sdhci_writel(host, *(u32 *)offs, SDHCI_BUFFER);
@@ -89,33 +89,116 @@ static void sdhci_adma_desc(struct sdhci_host *host, dma_addr_t dma_addr,
 #endif
 }
 
+/* Return the segments of @data, a plain transfer has a single one */
+static int sdhci_adma_segs(struct mmc_data *data, const struct blk_sg **sgp,
+			   struct blk_sg *single)
+{
+	if (data->flags & MMC_DATA_SG) {
+		*sgp = data->sg;
+		return data->sg_count;
+	}
+
+	single->buffer = (void *)data->src;
+	single->blkcnt = data->blocks;
+	*sgp = single;
+
+	return 1;
+}
+
+/* Number of bytes before the first ADMA aligned address of @buf */
+static uint sdhci_adma_offset(const void *buf)
+{
+	return (ADMA_ALIGN - ((ulong)buf & (ADMA_ALIGN - 1))) &
+	       (ADMA_ALIGN - 1);
+}
+
+/*
+ * ADMA2 addresses must be 32-bit aligned. The few bytes in front of the
+ * first aligned address of a segment go through a slot of the align buffer,
+ * the rest of the segment is transferred in place.
+ */
 static void sdhci_prepare_adma_table(struct sdhci_host *host,
 				     struct mmc_data *data)
 {
-	uint trans_bytes = data->blocksize * data->blocks;
-	uint desc_count = DIV_ROUND_UP(trans_bytes, ADMA_MAX_LEN);
-	int i = desc_count;
-	dma_addr_t dma_addr = host->start_addr;
-
+	char *align = host->adma_align_buffer;
+	const struct blk_sg *sg;
+	struct blk_sg single;
+	dma_addr_t dma_addr;
+	uint len, offset;
+	int i, nsegs;
+	char *buf;
+
+	nsegs = sdhci_adma_segs(data, &sg, &single);
 	host->desc_slot = 0;
 
-	while (--i) {
-		sdhci_adma_desc(host, dma_addr, ADMA_MAX_LEN, false);
-		dma_addr += ADMA_MAX_LEN;
-		trans_bytes -= ADMA_MAX_LEN;
-	}
+	for (i = 0; i < nsegs; i++) {
+		buf = sg[i].buffer;
+		len = sg[i].blkcnt * data->blocksize;
+		offset = sdhci_adma_offset(buf);
+		if (offset) {
+			if (data->flags & MMC_DATA_WRITE)
+				memcpy(align, buf, offset);
+			sdhci_adma_desc(host, (dma_addr_t)align, offset, false);
+			align += ADMA_ALIGN;
+			buf += offset;
+			len -= offset;
+		}
 
-	sdhci_adma_desc(host, dma_addr, trans_bytes, true);
+		dma_addr = dma_map_single(buf, len, mmc_get_dma_dir(data));
+		while (len > ADMA_MAX_LEN) {
+			sdhci_adma_desc(host, dma_addr, ADMA_MAX_LEN, false);
+			dma_addr += ADMA_MAX_LEN;
+			len -= ADMA_MAX_LEN;
+		}
+		sdhci_adma_desc(host, dma_addr, len, i == nsegs - 1);
+	}
 
+	if (align != host->adma_align_buffer)
+		flush_cache((dma_addr_t)host->adma_align_buffer,
+			    ADMA_ALIGN_SZ);
 	flush_cache((dma_addr_t)host->adma_desc_table,
-		    ROUND(desc_count * sizeof(struct sdhci_adma_desc),
-			  ARCH_DMA_MINALIGN));
+		    ROUND((host->desc_slot + 1) *
+			  sizeof(struct sdhci_adma_desc), ARCH_DMA_MINALIGN));
+}
+
+/* Unmap the segments and copy the bytes read into the align buffer */
+static void sdhci_adma_done(struct sdhci_host *host, struct mmc_data *data)
+{
+	char *align = host->adma_align_buffer;
+	const struct blk_sg *sg;
+	struct blk_sg single;
+	uint len, offset;
+	int i, nsegs;
+	char *buf;
+
+	nsegs = sdhci_adma_segs(data, &sg, &single);
+	if (data->flags & MMC_DATA_READ)
+		dma_unmap_single((dma_addr_t)align, ADMA_ALIGN_SZ,
+				 DMA_FROM_DEVICE);
+
+	for (i = 0; i < nsegs; i++) {
+		buf = sg[i].buffer;
+		len = sg[i].blkcnt * data->blocksize;
+		offset = sdhci_adma_offset(buf);
+		if (offset) {
+			if (data->flags & MMC_DATA_READ)
+				memcpy(buf, align, offset);
+			align += ADMA_ALIGN;
+		}
+
+		dma_unmap_single((dma_addr_t)(buf + offset), len - offset,
+				 mmc_get_dma_dir(data));
+	}
 }
-#elif defined(CONFIG_MMC_SDHCI_SDMA)
+#else
+static void sdhci_adma_done(struct sdhci_host *host, struct mmc_data *data)
+{}
+#if defined(CONFIG_MMC_SDHCI_SDMA)
 static void sdhci_prepare_adma_table(struct sdhci_host *host,
 				     struct mmc_data *data)
 {}
 #endif
+#endif
 #if (defined(CONFIG_MMC_SDHCI_SDMA) || CONFIG_IS_ENABLED(MMC_SDHCI_ADMA))
 static void sdhci_prepare_dma(struct sdhci_host *host, struct mmc_data *data,
 			      int *is_aligned, int trans_bytes)
@@ -123,7 +206,7 @@ static void sdhci_prepare_dma(struct sdhci_host *host, struct mmc_data *data,
 	unsigned char ctrl;
 	void *buf;
 
-	if (data->flags == MMC_DATA_READ)
+	if (data->flags & MMC_DATA_READ)
 		buf = data->dest;
 	else
 		buf = (void *)data->src;
@@ -141,15 +224,14 @@ static void sdhci_prepare_dma(struct sdhci_host *host, struct mmc_data *data,
 	     (host->quirks & SDHCI_QUIRK_32BIT_DMA_ADDR &&
 	      ((unsigned long)buf & 0x7) != 0x0))) {
 		*is_aligned = 0;
-		if (data->flags != MMC_DATA_READ)
+		if (!(data->flags & MMC_DATA_READ))
 			memcpy(host->align_buffer, buf, trans_bytes);
 		buf = host->align_buffer;
 	}
 
-	host->start_addr = dma_map_single(buf, trans_bytes,
-					  mmc_get_dma_dir(data));
-
 	if (host->flags & USE_SDMA) {
+		host->start_addr = dma_map_single(buf, trans_bytes,
+						  mmc_get_dma_dir(data));
 		sdhci_writel(host, host->start_addr, SDHCI_DMA_ADDRESS);
 	} else if (host->flags & (USE_ADMA | USE_ADMA64)) {
 		sdhci_prepare_adma_table(host, data);
@@ -216,8 +298,12 @@ static int sdhci_transfer_data(struct sdhci_host *host, struct mmc_data *data)
 		}
 	} while (!(stat & SDHCI_INT_DATA_END));
 
-	dma_unmap_single(host->start_addr, data->blocks * data->blocksize,
-			 mmc_get_dma_dir(data));
+	if (host->flags & (USE_ADMA | USE_ADMA64))
+		sdhci_adma_done(host, data);
+	else
+		dma_unmap_single(host->start_addr,
+				 data->blocks * data->blocksize,
+				 mmc_get_dma_dir(data));
 
 	return 0;
 }
@@ -316,7 +402,7 @@ static int sdhci_send_command(struct mmc *mmc, struct mmc_cmd *cmd,
 		if (data->blocks > 1)
 			mode |= SDHCI_TRNS_MULTI;
 
-		if (data->flags == MMC_DATA_READ)
+		if (data->flags & MMC_DATA_READ)
 			mode |= SDHCI_TRNS_READ;
 
 		if (host->flags & USE_DMA) {
@@ -368,7 +454,7 @@ static int sdhci_send_command(struct mmc *mmc, struct mmc_cmd *cmd,
 	sdhci_writel(host, SDHCI_INT_ALL_MASK, SDHCI_INT_STATUS);
 	if (!ret) {
 		if ((host->quirks & SDHCI_QUIRK_32BIT_DMA_ADDR) &&
-				!is_aligned && (data->flags == MMC_DATA_READ))
+				!is_aligned && (data->flags & MMC_DATA_READ))
 			memcpy(data->dest, host->align_buffer, trans_bytes);
 		return 0;
 	}
@@ -754,6 +840,7 @@ int sdhci_setup_cfg(struct mmc_config *cfg, struct sdhci_host *host,
 		return -EINVAL;
 	}
 	host->adma_desc_table = memalign(ARCH_DMA_MINALIGN, ADMA_TABLE_SZ);
+	host->adma_align_buffer = memalign(ARCH_DMA_MINALIGN, ADMA_ALIGN_SZ);
 
 	host->adma_addr = (dma_addr_t)host->adma_desc_table;
 #ifdef CONFIG_DMA_ADDR_T_64BIT
@@ -828,6 +915,13 @@ int sdhci_setup_cfg(struct mmc_config *cfg, struct sdhci_host *host,
 
 	cfg->host_caps |= MMC_MODE_HS | MMC_MODE_HS_52MHz | MMC_MODE_4BIT;
 
+	/* CMD23 is an ordinary command, no Auto CMD12 is ever enabled */
+	cfg->host_caps |= MMC_CAP_CMD23;
+
+	/* An ADMA descriptor table can point at any number of buffers */
+	if (host->flags & (USE_ADMA | USE_ADMA64))
+		cfg->host_caps |= MMC_CAP_SG;
+
 	/* Since Host Controller Version3.0 */
 	if (SDHCI_GET_VERSION(host) >= SDHCI_SPEC_300) {
 		if (!(caps & SDHCI_CAN_DO_8BIT))
@@ -2294,6 +2294,169 @@ static int nand_setup_read_retry(struct mtd_info *mtd, int retry_mode)
 	return chip->setup_read_retry(mtd, retry_mode);
 }
 
+#if CONFIG_IS_ENABLED(NAND_PAGE_CACHE)
+/**
+ * struct nand_page_cache - recently read pages
+ * @page: page held by each slot, -1 if the slot is empty
+ * @bitflips: bitflips corrected when the page of each slot was read
+ * @data: the page data, one page per slot
+ * @next: slot to replace next
+ *
+ * Holds ECC corrected pages that were read through the bounce buffer, so
+ * small reads going back and forth between a few pages do not read and
+ * correct them again. The single page kept in chip->buffers->databuf is
+ * lost as soon as another page is read.
+ */
+struct nand_page_cache {
+	int page[CONFIG_NAND_PAGE_CACHE_ENTRIES];
+	unsigned int bitflips[CONFIG_NAND_PAGE_CACHE_ENTRIES];
+	uint8_t *data;
+	unsigned int next;
+};
+
+static void nand_page_cache_init(struct mtd_info *mtd)
+{
+	struct nand_chip *chip = mtd_to_nand(mtd);
+	struct nand_page_cache *pc;
+	int i;
+
+	if (chip->page_cache)
+		return;
+
+	pc = kzalloc(sizeof(*pc), GFP_KERNEL);
+	if (!pc)
+		return;
+
+	/* The cache is optional, go on without it */
+	pc->data = kmalloc(CONFIG_NAND_PAGE_CACHE_ENTRIES * mtd->writesize,
+			   GFP_KERNEL);
+	if (!pc->data) {
+		kfree(pc);
+		return;
+	}
+
+	for (i = 0; i < CONFIG_NAND_PAGE_CACHE_ENTRIES; i++)
+		pc->page[i] = -1;
+
+	chip->page_cache = pc;
+}
+
+static uint8_t *nand_page_cache_get(struct nand_chip *chip, int page,
+				    unsigned int *bitflips)
+{
+	struct nand_page_cache *pc = chip->page_cache;
+	int i;
+
+	if (!pc)
+		return NULL;
+
+	for (i = 0; i < CONFIG_NAND_PAGE_CACHE_ENTRIES; i++) {
+		if (pc->page[i] == page) {
+			*bitflips = pc->bitflips[i];
+			return pc->data + i * nand_to_mtd(chip)->writesize;
+		}
+	}
+
+	return NULL;
+}
+
+static void nand_page_cache_put(struct nand_chip *chip, int page,
+				const uint8_t *buf, unsigned int bitflips)
+{
+	struct nand_page_cache *pc = chip->page_cache;
+	struct mtd_info *mtd = nand_to_mtd(chip);
+	unsigned int i;
+
+	if (!pc)
+		return;
+
+	i = pc->next;
+	pc->next = (i + 1) % CONFIG_NAND_PAGE_CACHE_ENTRIES;
+	pc->page[i] = page;
+	pc->bitflips[i] = bitflips;
+	memcpy(pc->data + i * mtd->writesize, buf, mtd->writesize);
+}
+
+static void nand_page_cache_invalidate(struct nand_chip *chip, int page,
+				       int pages)
+{
+	struct nand_page_cache *pc = chip->page_cache;
+	int i;
+
+	if (!pc)
+		return;
+
+	for (i = 0; i < CONFIG_NAND_PAGE_CACHE_ENTRIES; i++)
+		if (pc->page[i] >= page && pc->page[i] < page + pages)
+			pc->page[i] = -1;
+}
+#else
+static inline void nand_page_cache_init(struct mtd_info *mtd)
+{
+}
+
+static inline uint8_t *nand_page_cache_get(struct nand_chip *chip, int page,
+					   unsigned int *bitflips)
+{
+	return NULL;
+}
+
+static inline void nand_page_cache_put(struct nand_chip *chip, int page,
+				       const uint8_t *buf,
+				       unsigned int bitflips)
+{
+}
+
+static inline void nand_page_cache_invalidate(struct nand_chip *chip,
+					      int page, int pages)
+{
+}
+#endif
+
+/**
+ * nand_read_cache_pages - number of pages to read in a read cache sequence
+ * @mtd: MTD device structure
+ * @page: first page of the sequence
+ * @readlen: number of bytes left to read, starting at @page
+ *
+ * A sequence stops at the end of the eraseblock, so the chip never reads
+ * ahead into a block which might be bad. Returns 0 if a sequence is not
+ * worth it.
+ */
+static int nand_read_cache_pages(struct mtd_info *mtd, int page,
+				 uint32_t readlen)
+{
+	struct nand_chip *chip = mtd_to_nand(mtd);
+	int ppb = 1 << (chip->phys_erase_shift - chip->page_shift);
+	int pages = readlen >> chip->page_shift;
+
+	pages = min(pages, ppb - (page & (ppb - 1)));
+
+	return pages > 1 ? pages : 0;
+}
+
+/**
+ * nand_read_cache_op - load a page of a read cache sequence
+ * @chip: The NAND chip
+ * @page: the page to load
+ * @first: @page starts the sequence
+ * @last: @page ends the sequence
+ *
+ * READ CACHE SEQUENTIAL moves the page to the cache register and lets the
+ * chip load the next page from the array while the host transfers this
+ * one. READ CACHE END moves the last page without loading another one.
+ */
+static void nand_read_cache_op(struct nand_chip *chip, int page, bool first,
+			       bool last)
+{
+	struct mtd_info *mtd = nand_to_mtd(chip);
+
+	if (first)
+		chip->cmdfunc(mtd, NAND_CMD_READ0, 0, page);
+	chip->cmdfunc(mtd, last ? NAND_CMD_READCACHEEND : NAND_CMD_READCACHESEQ,
+		      -1, -1);
+}
+
 /**
  * nand_do_read_ops - [INTERN] Read data with ECC
  * @mtd: MTD device structure
@@ -2312,10 +2475,12 @@ static int nand_do_read_ops(struct mtd_info *mtd, loff_t from,
 	uint32_t oobreadlen = ops->ooblen;
 	uint32_t max_oobsize = mtd_oobavail(mtd, ops);
 
-	uint8_t *bufpoi, *oob, *buf;
+	uint8_t *bufpoi, *oob, *buf, *cached;
 	int use_bufpoi;
-	unsigned int max_bitflips = 0;
+	unsigned int max_bitflips = 0, cached_bitflips;
 	int retry_mode = 0;
+	int seq = 0;
+	bool seq_first = false;
 	bool ecc_fail = false;
 
 	chipnr = (int)(from >> chip->chip_shift);
@@ -2345,8 +2510,26 @@ static int nand_do_read_ops(struct mtd_info *mtd, loff_t from,
 		else
 			use_bufpoi = 0;
 
-		/* Is the current page in the buffer? */
-		if (realpage != chip->pagebuf || oob) {
+		cached = NULL;
+		if (!seq && !oob && ops->mode != MTD_OPS_RAW &&
+		    realpage != chip->pagebuf) {
+			cached = nand_page_cache_get(chip, realpage,
+						     &cached_bitflips);
+
+			/* Stream the following full pages of the block */
+			if (!cached && aligned && NAND_HAS_READ_CACHE(chip)) {
+				seq = nand_read_cache_pages(mtd, page, readlen);
+				seq_first = true;
+			}
+		}
+
+		if (cached) {
+			memcpy(buf, cached + col, bytes);
+			buf += bytes;
+			max_bitflips = max_t(unsigned int, max_bitflips,
+					     cached_bitflips);
+		} else if (realpage != chip->pagebuf || oob || seq) {
+			/* The current page is not in the buffer */
 			bufpoi = use_bufpoi ? chip->buffers->databuf : buf;
 
 			if (use_bufpoi && aligned)
@@ -2354,7 +2537,12 @@ static int nand_do_read_ops(struct mtd_info *mtd, loff_t from,
 						 __func__, buf);
 
 read_retry:
-			if (nand_standard_page_accessors(&chip->ecc)) {
+			if (nand_standard_page_accessors(&chip->ecc) && seq) {
+				nand_read_cache_op(chip, page, seq_first,
+						   seq == 1);
+				seq_first = false;
+				seq--;
+			} else if (nand_standard_page_accessors(&chip->ecc)) {
 				ret = nand_read_page_op(chip, page, 0, NULL, 0);
 				if (ret)
 					break;
@@ -2392,6 +2580,8 @@ read_retry:
 				    (ops->mode != MTD_OPS_RAW)) {
 					chip->pagebuf = realpage;
 					chip->pagebuf_bitflips = ret;
+					nand_page_cache_put(chip, realpage,
+							    bufpoi, ret);
 				} else {
 					/* Invalidate page cache */
 					chip->pagebuf = -1;
@@ -2419,6 +2609,13 @@ read_retry:
 
 			if (mtd->ecc_stats.failed - ecc_failures) {
 				if (retry_mode + 1 < chip->read_retries) {
+					/* Read the page again on its own */
+					if (seq) {
+						nand_read_cache_op(chip, page,
+								   false, true);
+						seq = 0;
+					}
+
 					retry_mode++;
 					ret = nand_setup_read_retry(mtd,
 							retry_mode);
@@ -2468,6 +2665,11 @@ read_retry:
 			chip->select_chip(mtd, chipnr);
 		}
 	}
+
+	/* Do not leave the chip in the middle of a read cache sequence */
+	if (seq)
+		nand_read_cache_op(chip, page, false, true);
+
 	chip->select_chip(mtd, -1);
 
 	ops->retlen = ops->len - (size_t) readlen;
@@ -3233,6 +3435,9 @@ static int nand_do_write_ops(struct mtd_info *mtd, loff_t to,
 	if (to <= ((loff_t)chip->pagebuf << chip->page_shift) &&
 	    ((loff_t)chip->pagebuf << chip->page_shift) < (to + ops->len))
 		chip->pagebuf = -1;
+	nand_page_cache_invalidate(chip, realpage,
+				   ((to + ops->len - 1) >> chip->page_shift) -
+				   realpage + 1);
 
 	/* Don't allow multipage oob writes with offset */
 	if (oob && ops->ooboffs && (ops->ooboffs + ops->ooblen > oobmaxlen)) {
@@ -3408,6 +3613,7 @@ static int nand_do_write_oob(struct mtd_info *mtd, loff_t to,
 	/* Invalidate the page cache, if we write to the cached page */
 	if (page == chip->pagebuf)
 		chip->pagebuf = -1;
+	nand_page_cache_invalidate(chip, page, 1);
 
 	nand_fill_oob(mtd, ops->oobbuf, ops->ooblen, ops);
 
@@ -3565,6 +3771,7 @@ int nand_erase_nand(struct mtd_info *mtd, struct erase_info *instr,
 		if (page <= chip->pagebuf && chip->pagebuf <
 		    (page + pages_per_block))
 			chip->pagebuf = -1;
+		nand_page_cache_invalidate(chip, page, pages_per_block);
 
 		status = chip->erase(mtd, page & chip->pagemask);
 
@@ -3990,6 +4197,9 @@ static int nand_flash_detect_onfi(struct mtd_info *mtd, struct nand_chip *chip,
 		pr_warn("Could not retrieve ONFI ECC requirements\n");
 	}
 
+	if (le16_to_cpu(p->opt_cmd) & ONFI_OPT_CMD_READ_CACHE)
+		chip->options |= NAND_READ_CACHE;
+
 	if (p->jedec_id == NAND_MFR_MICRON)
 		nand_onfi_detect_micron(chip, p);
 
@@ -5246,6 +5456,7 @@ int nand_scan_tail(struct mtd_info *mtd)
 
 	/* Invalidate the pagebuffer reference */
 	chip->pagebuf = -1;
+	nand_page_cache_init(mtd);
 
 	/* Large page NAND with SOFT_ECC should support subpage reads */
 	switch (ecc->mode) {
@@ -5259,6 +5470,19 @@ int nand_scan_tail(struct mtd_info *mtd)
 		break;
 	}
 
+	/*
+	 * Read cache sequences need the core to issue the commands and the
+	 * ECC page accessors to only transfer the page data.
+	 */
+	if (!IS_ENABLED(CONFIG_NAND_READ_CACHE) ||
+	    chip->cmdfunc != nand_command_lp ||
+	    !nand_standard_page_accessors(ecc) ||
+	    ecc->read_page_raw != nand_read_page_raw ||
+	    (ecc->read_page != nand_read_page_swecc &&
+	     ecc->read_page != nand_read_page_hwecc &&
+	     ecc->read_page != nand_read_page_raw))
+		chip->options &= ~NAND_READ_CACHE;
+
 	/* Fill in remaining MTD driver data */
 	mtd->type = nand_is_slc(chip) ? MTD_NANDFLASH : MTD_MLCNANDFLASH;
 	mtd->flags = (chip->options & NAND_ROM) ? MTD_CAP_ROM :
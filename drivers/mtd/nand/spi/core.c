@@ -237,6 +237,13 @@ static int spinand_load_page_op(struct spinand_device *spinand,
 	return spi_mem_exec_op(spinand->slave, &op);
 }
 
+static int spinand_cache_seq_read_op(struct spinand_device *spinand, bool last)
+{
+	struct spi_mem_op op = SPINAND_PAGE_READ_CACHE_SEQ_OP(last);
+
+	return spi_mem_exec_op(spinand->slave, &op);
+}
+
 static int spinand_read_from_cache_op(struct spinand_device *spinand,
 				      const struct nand_page_io_req *req)
 {
@@ -507,20 +514,49 @@ static int spinand_check_ecc_status(struct spinand_device *spinand, u8 status)
 	return -EINVAL;
 }
 
+/**
+ * spinand_read_page() - Read a page, possibly as part of a cache read sequence
+ * @spinand: the spinand device
+ * @req: the page to read
+ * @ecc_enabled: whether the on-die ECC status should be checked
+ * @loaded: a previous call already started loading @req into the data
+ *	    register with @load_next
+ * @load_next: start loading the next page while @req is transferred. Only
+ *	       for chips with SPINAND_HAS_CACHE_SEQ_READ, and the next page
+ *	       must be read by a call with @loaded set
+ *
+ * Return: the number of corrected bitflips, or a negative error code.
+ */
 static int spinand_read_page(struct spinand_device *spinand,
 			     const struct nand_page_io_req *req,
-			     bool ecc_enabled)
+			     bool ecc_enabled, bool loaded, bool load_next)
 {
 	u8 status;
 	int ret;
 
-	ret = spinand_load_page_op(spinand, req);
-	if (ret)
-		return ret;
+	if (!loaded) {
+		ret = spinand_load_page_op(spinand, req);
+		if (ret)
+			return ret;
 
-	ret = spinand_wait(spinand, &status);
-	if (ret < 0)
-		return ret;
+		ret = spinand_wait(spinand, &status);
+		if (ret < 0)
+			return ret;
+	}
+
+	/*
+	 * Move the page to the cache register, which also gives the ECC
+	 * status of that page, and let the array load the next one.
+	 */
+	if (loaded || load_next) {
+		ret = spinand_cache_seq_read_op(spinand, !load_next);
+		if (ret)
+			return ret;
+
+		ret = spinand_wait(spinand, &status);
+		if (ret < 0)
+			return ret;
+	}
 
 	ret = spinand_read_from_cache_op(spinand, req);
 	if (ret)
@@ -557,6 +593,87 @@ static int spinand_write_page(struct spinand_device *spinand,
 	return ret;
 }
 
+/*
+ * Number of pages, starting with the one of @iter, that can be read with a
+ * single continuous read. Continuous reads are kept inside an eraseblock,
+ * since the callers handle bad blocks one block at a time, and they are
+ * bounded by what the controller transfers in one operation. Returns 0 if
+ * the continuous read mode should not be used.
+ */
+static unsigned int spinand_cont_read_pages(struct spinand_device *spinand,
+					    const struct nand_io_iter *iter)
+{
+	struct nand_device *nand = spinand_to_nand(spinand);
+	struct spi_mem_op op = *spinand->op_templates.read_cache;
+	unsigned int pagesize = nanddev_page_size(nand);
+	unsigned int npages, nbytes;
+
+	if (!spinand->set_cont_read || iter->oobleft || iter->req.dataoffs)
+		return 0;
+
+	/* The data goes straight to the caller, without the bounce buffer */
+	if (!IS_ALIGNED((uintptr_t)iter->req.databuf.in, ARCH_DMA_MINALIGN))
+		return 0;
+
+	npages = min_t(unsigned int, DIV_ROUND_UP(iter->dataleft, pagesize),
+		       nand->memorg.pages_per_eraseblock - iter->req.pos.page);
+	if (npages < 2)
+		return 0;
+
+	nbytes = min(iter->dataleft, npages * pagesize);
+	op.data.nbytes = nbytes;
+	if (spi_mem_adjust_op_size(spinand->slave, &op))
+		return 0;
+
+	/* Only the last page of the request may be transferred partially */
+	if (op.data.nbytes < nbytes)
+		npages = op.data.nbytes / pagesize;
+
+	return npages < 2 ? 0 : npages;
+}
+
+/*
+ * Read @len bytes starting at the page of @req in continuous read mode. The
+ * chip reports a single ECC status for all the pages transferred.
+ */
+static int spinand_cont_read(struct spinand_device *spinand,
+			     const struct nand_page_io_req *req,
+			     unsigned int len, bool ecc_enabled)
+{
+	struct spi_mem_op op = *spinand->op_templates.read_cache;
+	u8 status;
+	int ret, ret2;
+
+	ret = spinand->set_cont_read(spinand, true);
+	if (ret)
+		return ret;
+
+	ret = spinand_load_page_op(spinand, req);
+	if (!ret)
+		ret = spinand_wait(spinand, &status);
+
+	if (!ret) {
+		op.addr.val = 0;
+		op.data.buf.in = req->databuf.in;
+		op.data.nbytes = len;
+		ret = spi_mem_exec_op(spinand->slave, &op);
+	}
+
+	if (!ret)
+		ret = spinand_read_status(spinand, &status);
+
+	ret2 = spinand->set_cont_read(spinand, false);
+	if (ret)
+		return ret;
+	if (ret2)
+		return ret2;
+
+	if (!ecc_enabled)
+		return 0;
+
+	return spinand_check_ecc_status(spinand, status);
+}
+
 static int spinand_mtd_read(struct mtd_info *mtd, loff_t from,
 			    struct mtd_oob_ops *ops)
 {
@@ -564,8 +681,12 @@ static int spinand_mtd_read(struct mtd_info *mtd, loff_t from,
 	struct nand_device *nand = mtd_to_nanddev(mtd);
 	unsigned int max_bitflips = 0;
 	struct nand_io_iter iter;
+	unsigned int npages, len, i;
 	bool enable_ecc = false;
 	bool ecc_failed = false;
+	bool cont_read = true;
+	bool loaded = false;
+	bool load_next;
 	int ret = 0;
 
 	if (ops->mode != MTD_OPS_RAW && spinand->eccinfo.ooblayout)
@@ -584,7 +705,49 @@ static int spinand_mtd_read(struct mtd_info *mtd, loff_t from,
 		if (ret)
 			break;
 
-		ret = spinand_read_page(spinand, &iter.req, enable_ecc);
+		npages = 0;
+		if (cont_read && !loaded)
+			npages = spinand_cont_read_pages(spinand, &iter);
+		if (npages) {
+			len = min_t(unsigned int, iter.dataleft,
+				    npages * nanddev_page_size(nand));
+			ret = spinand_cont_read(spinand, &iter.req, len,
+						enable_ecc);
+			if (ret < 0 && ret != -EBADMSG)
+				break;
+
+			/*
+			 * The status does not tell which page failed, read
+			 * them again one by one to find out.
+			 */
+			if (ret == -EBADMSG) {
+				cont_read = false;
+				npages = 0;
+			}
+
+			/* The last page is accounted for below */
+			for (i = 1; i < npages; i++) {
+				ops->retlen += iter.req.datalen;
+				nanddev_io_iter_next_page(nand, &iter);
+			}
+		}
+
+		if (!npages) {
+			/*
+			 * Pipeline cache reads as long as the next page is in
+			 * the same eraseblock.
+			 */
+			load_next = (spinand->flags &
+				     SPINAND_HAS_CACHE_SEQ_READ) &&
+				    (iter.dataleft > iter.req.datalen ||
+				     iter.oobleft > iter.req.ooblen) &&
+				    iter.req.pos.page + 1 <
+				    nand->memorg.pages_per_eraseblock;
+
+			ret = spinand_read_page(spinand, &iter.req, enable_ecc,
+						loaded, load_next);
+			loaded = load_next;
+		}
 		if (ret < 0 && ret != -EBADMSG)
 			break;
 
@@ -601,6 +764,10 @@ static int spinand_mtd_read(struct mtd_info *mtd, loff_t from,
 		ops->oobretlen += iter.req.ooblen;
 	}
 
+	/* Do not leave the chip busy loading a page nobody will read */
+	if (loaded && !spinand_cache_seq_read_op(spinand, true))
+		spinand_wait(spinand, NULL);
+
 #ifndef __UBOOT__
 	mutex_unlock(&spinand->lock);
 #endif
@@ -667,7 +834,7 @@ static bool spinand_isbad(struct nand_device *nand, const struct nand_pos *pos)
 	if (ret)
 		return ret;
 
-	ret = spinand_read_page(spinand, &req, false);
+	ret = spinand_read_page(spinand, &req, false, false, false);
 	if (ret)
 		return ret;
 
@@ -939,6 +1106,7 @@ int spinand_match_and_init(struct spinand_device *spinand,
 		spinand->eccinfo = table[i].eccinfo;
 		spinand->flags = table[i].flags;
 		spinand->select_target = table[i].select_target;
+		spinand->set_cont_read = table[i].set_cont_read;
 
 		op = spinand_select_op_variant(spinand,
 					       info->op_variants.read_cache);
@@ -77,6 +77,12 @@ static int w25m02gv_select_target(struct spinand_device *spinand,
 	return spi_mem_exec_op(spinand->slave, &op);
 }
 
+static int w25n01gv_set_cont_read(struct spinand_device *spinand, bool enable)
+{
+	return spinand_upd_cfg(spinand, WINBOND_CFG_BUF_READ,
+			       enable ? 0 : WINBOND_CFG_BUF_READ);
+}
+
 static const struct spinand_info winbond_spinand_table[] = {
 	SPINAND_INFO("W25M02GV", 0xAB,
 		     NAND_MEMORG(1, 2048, 64, 64, 1024, 1, 1, 2),
@@ -86,7 +92,8 @@ static const struct spinand_info winbond_spinand_table[] = {
 					      &update_cache_variants),
 		     0,
 		     SPINAND_ECCINFO(&w25m02gv_ooblayout, NULL),
-		     SPINAND_SELECT_TARGET(w25m02gv_select_target)),
+		     SPINAND_SELECT_TARGET(w25m02gv_select_target)
+		     SPINAND_CONT_READ(w25n01gv_set_cont_read)),
 	SPINAND_INFO("W25N01GV", 0xAA,
 		     NAND_MEMORG(1, 2048, 64, 64, 1024, 1, 1, 1),
 		     NAND_ECCREQ(1, 512),
@@ -94,7 +101,8 @@ static const struct spinand_info winbond_spinand_table[] = {
 					      &write_cache_variants,
 					      &update_cache_variants),
 		     0,
-		     SPINAND_ECCINFO(&w25m02gv_ooblayout, NULL)),
+		     SPINAND_ECCINFO(&w25m02gv_ooblayout, NULL),
+		     SPINAND_CONT_READ(w25n01gv_set_cont_read)),
 };
 
 /**
@@ -129,7 +137,8 @@ static int winbond_spinand_init(struct spinand_device *spinand)
 
 	/*
 	 * Make sure all dies are in buffer read mode and not continuous read
-	 * mode.
+	 * mode. The core only switches to continuous read mode for the
+	 * duration of a multi-page read.
 	 */
 	for (i = 0; i < nand->memorg.ntargets; i++) {
 		spinand_select_target(spinand, i);
@@ -879,6 +879,29 @@ static int stm_is_locked(struct spi_nor *nor, loff_t ofs, uint64_t len)
 }
 #endif /* CONFIG_SPI_FLASH_STMICRO */
 
+#if CONFIG_IS_ENABLED(SPI_FLASH_SFDP_SUPPORT)
+/*
+ * Parts missing from spi_nor_ids[] are described by their SFDP tables only.
+ * Each device gets a copy holding its ID, so that the manufacturer specific
+ * code still applies.
+ */
+static const struct flash_info spi_nor_generic_info = {
+	.name = "spi-nor-generic",
+	.id_len = 3,
+	.page_size = 256,
+};
+
+static bool spi_nor_is_generic(const struct flash_info *info)
+{
+	return info->name == spi_nor_generic_info.name;
+}
+#else
+static bool spi_nor_is_generic(const struct flash_info *info)
+{
+	return false;
+}
+#endif
+
 static const struct flash_info *spi_nor_read_id(struct spi_nor *nor)
 {
 	int			tmp;
@@ -899,6 +922,20 @@ static const struct flash_info *spi_nor_read_id(struct spi_nor *nor)
 		}
 	}
 
+#if CONFIG_IS_ENABLED(SPI_FLASH_SFDP_SUPPORT)
+	/* Let spi_nor_init_params() try to describe the part from SFDP */
+	if (id[0] && id[0] != 0xff) {
+		struct flash_info *generic;
+
+		generic = devm_kmalloc(nor->dev, sizeof(*generic), GFP_KERNEL);
+		if (!generic)
+			return ERR_PTR(-ENOMEM);
+		memcpy(generic, &spi_nor_generic_info, sizeof(*generic));
+		memcpy(generic->id, id, SPI_NOR_MAX_ID_LEN);
+		return generic;
+	}
+#endif
+
 	dev_err(nor->dev, "unrecognized JEDEC id bytes: %02x, %02x, %02x\n",
 		id[0], id[1], id[2]);
 	return ERR_PTR(-ENODEV);
@@ -1495,6 +1532,20 @@ enum spi_nor_pp_command_index {
 	SNOR_CMD_PP_MAX
 };
 
+#define SNOR_ERASE_TYPE_MAX	4
+
+/**
+ * struct spi_nor_erase_type - Sector Erase command described by SFDP
+ * @size:	size of the sector erased by the command, 0 if not supported
+ * @opcode:	op code of the command with 3-byte addresses
+ * @opcode_4b:	op code of the command with 4-byte addresses, 0 if unknown
+ */
+struct spi_nor_erase_type {
+	u32	size;
+	u8	opcode;
+	u8	opcode_4b;
+};
+
 struct spi_nor_flash_parameter {
 	u64				size;
 	u32				page_size;
@@ -1503,6 +1554,11 @@ struct spi_nor_flash_parameter {
 	struct spi_nor_read_command	reads[SNOR_CMD_READ_MAX];
 	struct spi_nor_pp_command	page_programs[SNOR_CMD_PP_MAX];
 
+	/* Uniform erase types from the BFPT, in the BFPT order */
+	struct spi_nor_erase_type	erase_types[SNOR_ERASE_TYPE_MAX];
+	/* Read and Page Program hwcaps having a 4-byte address op code */
+	u32				hwcaps_4b;
+
 	int (*quad_enable)(struct spi_nor *nor);
 };
 
@@ -1600,6 +1656,7 @@ struct sfdp_parameter_header {
 
 #define SFDP_BFPT_ID		0xff00	/* Basic Flash Parameter Table */
 #define SFDP_SECTOR_MAP_ID	0xff81	/* Sector Map Table */
+#define SFDP_4BAIT_ID		0xff84	/* 4-byte Address Instruction Table */
 #define SFDP_SST_ID		0x01bf	/* Manufacturer specific Table */
 
 #define SFDP_SIGNATURE		0x50444653U
@@ -1840,7 +1897,6 @@ static int spi_nor_parse_bfpt(struct spi_nor *nor,
 			      const struct sfdp_parameter_header *bfpt_header,
 			      struct spi_nor_flash_parameter *params)
 {
-	struct mtd_info *mtd = &nor->mtd;
 	struct sfdp_bfpt bfpt;
 	size_t len;
 	int i, cmd, err;
@@ -1914,32 +1970,23 @@ static int spi_nor_parse_bfpt(struct spi_nor *nor,
 		spi_nor_set_read_settings_from_bfpt(read, half, rd->proto);
 	}
 
-	/* Sector Erase settings. */
+	/*
+	 * Sector Erase settings. The one to use is only picked by
+	 * spi_nor_select_erase(), once we know which of them the SPI
+	 * controller can send.
+	 */
 	for (i = 0; i < ARRAY_SIZE(sfdp_bfpt_erases); i++) {
 		const struct sfdp_bfpt_erase *er = &sfdp_bfpt_erases[i];
-		u32 erasesize;
-		u8 opcode;
+		struct spi_nor_erase_type *erase = &params->erase_types[i];
 
 		half = bfpt.dwords[er->dword] >> er->shift;
-		erasesize = half & 0xff;
 
 		/* erasesize == 0 means this Erase Type is not supported. */
-		if (!erasesize)
+		if (!(half & 0xff))
 			continue;
 
-		erasesize = 1U << erasesize;
-		opcode = (half >> 8) & 0xff;
-#ifdef CONFIG_SPI_FLASH_USE_4K_SECTORS
-		if (erasesize == SZ_4K) {
-			nor->erase_opcode = opcode;
-			mtd->erasesize = erasesize;
-			break;
-		}
-#endif
-		if (!mtd->erasesize || mtd->erasesize < erasesize) {
-			nor->erase_opcode = opcode;
-			mtd->erasesize = erasesize;
-		}
+		erase->size = 1U << (half & 0xff);
+		erase->opcode = (half >> 8) & 0xff;
 	}
 
 	/* Stop here if not JESD216 rev A or later. */
@@ -2008,6 +2055,91 @@ spi_nor_parse_microchip_sfdp(struct spi_nor *nor,
 	return ret;
 }
 
+struct sfdp_4bait {
+	/* The hardware capability. */
+	u32		hwcaps;
+
+	/*
+	 * The <supported_bit> bit in DWORD1 of the 4BAIT tells us whether
+	 * the associated 4-byte address op code is supported.
+	 */
+	u32		supported_bit;
+};
+
+/**
+ * spi_nor_parse_4bait() - parse the 4-Byte Address Instruction Table.
+ * @nor:		pointer to a 'struct spi_nor'.
+ * @param_header:	pointer to the SFDP parameter header describing the
+ *			4BAIT table.
+ * @params:		pointer to the 'struct spi_nor_flash_parameter' to be
+ *			filled
+ *
+ * The 4BAIT tells which (Fast) Read, Page Program and Sector Erase commands
+ * have a variant taking a 4-byte address. Using those op codes lets us
+ * address more than 16MiB without switching the memory to its stateful
+ * 4-byte address mode, see spi_nor_use_4bait().
+ *
+ * Return: 0 on success, -errno otherwise.
+ */
+static int spi_nor_parse_4bait(struct spi_nor *nor,
+			       const struct sfdp_parameter_header *param_header,
+			       struct spi_nor_flash_parameter *params)
+{
+	static const struct sfdp_4bait reads[] = {
+		{ SNOR_HWCAPS_READ,		BIT(0) },
+		{ SNOR_HWCAPS_READ_FAST,	BIT(1) },
+		{ SNOR_HWCAPS_READ_1_1_2,	BIT(2) },
+		{ SNOR_HWCAPS_READ_1_2_2,	BIT(3) },
+		{ SNOR_HWCAPS_READ_1_1_4,	BIT(4) },
+		{ SNOR_HWCAPS_READ_1_4_4,	BIT(5) },
+		{ SNOR_HWCAPS_READ_1_1_1_DTR,	BIT(13) },
+		{ SNOR_HWCAPS_READ_1_2_2_DTR,	BIT(14) },
+		{ SNOR_HWCAPS_READ_1_4_4_DTR,	BIT(15) },
+	};
+	static const struct sfdp_4bait programs[] = {
+		{ SNOR_HWCAPS_PP,		BIT(6) },
+		{ SNOR_HWCAPS_PP_1_1_4,		BIT(7) },
+		{ SNOR_HWCAPS_PP_1_4_4,		BIT(8) },
+	};
+	/* Erase Type i is supported with 4-byte addresses if BIT(9 + i) */
+	const u32 erase_shift = 9;
+	u32 dwords[2], hwcaps_4b = 0;
+	u32 addr;
+	int i, err;
+
+	if (param_header->major != SFDP_JESD216_MAJOR ||
+	    param_header->length < ARRAY_SIZE(dwords))
+		return -EINVAL;
+
+	addr = SFDP_PARAM_HEADER_PTP(param_header);
+	err = spi_nor_read_sfdp(nor, addr, sizeof(dwords), dwords);
+	if (err < 0)
+		return err;
+
+	for (i = 0; i < ARRAY_SIZE(dwords); i++)
+		dwords[i] = le32_to_cpu(dwords[i]);
+
+	for (i = 0; i < ARRAY_SIZE(reads); i++)
+		if (dwords[0] & reads[i].supported_bit)
+			hwcaps_4b |= reads[i].hwcaps;
+
+	for (i = 0; i < ARRAY_SIZE(programs); i++)
+		if (dwords[0] & programs[i].supported_bit)
+			hwcaps_4b |= programs[i].hwcaps;
+
+	/* DWORD2 gives the 4-byte address op code of each Erase Type */
+	for (i = 0; i < SNOR_ERASE_TYPE_MAX; i++) {
+		struct spi_nor_erase_type *erase = &params->erase_types[i];
+
+		if (erase->size && dwords[0] & BIT(erase_shift + i))
+			erase->opcode_4b = (dwords[1] >> (i * 8)) & 0xff;
+	}
+
+	params->hwcaps_4b = hwcaps_4b;
+
+	return 0;
+}
+
 /**
  * spi_nor_parse_sfdp() - parse the Serial Flash Discoverable Parameters.
  * @nor:		pointer to a 'struct spi_nor'
@@ -2108,6 +2240,10 @@ static int spi_nor_parse_sfdp(struct spi_nor *nor,
 			err = spi_nor_parse_microchip_sfdp(nor, param_header);
 			break;
 
+		case SFDP_4BAIT_ID:
+			err = spi_nor_parse_4bait(nor, param_header, params);
+			break;
+
 		default:
 			break;
 		}
@@ -2218,7 +2354,8 @@ static int spi_nor_init_params(struct spi_nor *nor,
 	/* Override the parameters with data read from SFDP tables. */
 	nor->addr_width = 0;
 	nor->mtd.erasesize = 0;
-	if ((info->flags & (SPI_NOR_DUAL_READ | SPI_NOR_QUAD_READ)) &&
+	if (((info->flags & (SPI_NOR_DUAL_READ | SPI_NOR_QUAD_READ)) ||
+	     spi_nor_is_generic(info)) &&
 	    !(info->flags & SPI_NOR_SKIP_SFDP)) {
 		struct spi_nor_flash_parameter sfdp_params;
 
@@ -2231,6 +2368,13 @@ static int spi_nor_init_params(struct spi_nor *nor,
 		}
 	}
 
+	/* Without a table entry, SFDP is all we know about the memory */
+	if (spi_nor_is_generic(info) && !params->size) {
+		dev_err(nor->dev, "unrecognized JEDEC id bytes: %02x, %02x, %02x\n",
+			info->id[0], info->id[1], info->id[2]);
+		return -ENODEV;
+	}
+
 	return 0;
 }
 
@@ -2285,6 +2429,105 @@ static int spi_nor_hwcaps_pp2cmd(u32 hwcaps)
 				  ARRAY_SIZE(hwcaps_pp2cmd));
 }
 
+/*
+ * The address width is only chosen once the protocols are selected: the
+ * controller must accept both 3 and 4-byte addresses, unless the memory is
+ * small enough to be always addressed with 3 bytes.
+ */
+static bool spi_nor_spimem_check_op(struct spi_nor *nor,
+				    struct spi_mem_op *op)
+{
+	op->addr.nbytes = 4;
+	if (!spi_mem_supports_op(nor->spi, op)) {
+		if (nor->mtd.size > SZ_16M)
+			return false;
+
+		op->addr.nbytes = 3;
+		if (!spi_mem_supports_op(nor->spi, op))
+			return false;
+	}
+
+	return true;
+}
+
+static bool
+spi_nor_spimem_check_readop(struct spi_nor *nor,
+			    const struct spi_nor_read_command *read)
+{
+	struct spi_mem_op op = SPI_MEM_OP(SPI_MEM_OP_CMD(read->opcode, 1),
+					  SPI_MEM_OP_ADDR(3, 0, 1),
+					  SPI_MEM_OP_DUMMY(0, 1),
+					  SPI_MEM_OP_DATA_IN(1, NULL, 1));
+
+	op.cmd.buswidth = spi_nor_get_protocol_inst_nbits(read->proto);
+	op.addr.buswidth = spi_nor_get_protocol_addr_nbits(read->proto);
+	op.dummy.buswidth = op.addr.buswidth;
+	op.data.buswidth = spi_nor_get_protocol_data_nbits(read->proto);
+	op.dummy.nbytes = (read->num_mode_clocks + read->num_wait_states) *
+			  op.dummy.buswidth / 8;
+
+	return spi_nor_spimem_check_op(nor, &op);
+}
+
+static bool spi_nor_spimem_check_pp(struct spi_nor *nor,
+				    const struct spi_nor_pp_command *pp)
+{
+	struct spi_mem_op op = SPI_MEM_OP(SPI_MEM_OP_CMD(pp->opcode, 1),
+					  SPI_MEM_OP_ADDR(3, 0, 1),
+					  SPI_MEM_OP_NO_DUMMY,
+					  SPI_MEM_OP_DATA_OUT(1, NULL, 1));
+
+	op.cmd.buswidth = spi_nor_get_protocol_inst_nbits(pp->proto);
+	op.addr.buswidth = spi_nor_get_protocol_addr_nbits(pp->proto);
+	op.data.buswidth = spi_nor_get_protocol_data_nbits(pp->proto);
+
+	return spi_nor_spimem_check_op(nor, &op);
+}
+
+static bool spi_nor_spimem_check_erase(struct spi_nor *nor, u8 opcode)
+{
+	struct spi_mem_op op = SPI_MEM_OP(SPI_MEM_OP_CMD(opcode, 1),
+					  SPI_MEM_OP_ADDR(3, 0, 1),
+					  SPI_MEM_OP_NO_DUMMY,
+					  SPI_MEM_OP_NO_DATA);
+
+	return spi_nor_spimem_check_op(nor, &op);
+}
+
+/**
+ * spi_nor_spimem_adjust_hwcaps() - drop the hwcaps the controller can't do
+ * @nor:	pointer to a 'struct spi_nor'
+ * @params:	the memory parameters, with the op codes and dummy cycles
+ * @hwcaps:	hwcaps supported by both the memory and the SPI bus mode
+ *
+ * The SPI mode bits only tell how many lines are wired. Ask the controller
+ * about the actual (Fast) Read and Page Program operations, so that the
+ * fastest protocol it can really send is picked.
+ */
+static void
+spi_nor_spimem_adjust_hwcaps(struct spi_nor *nor,
+			     const struct spi_nor_flash_parameter *params,
+			     u32 *hwcaps)
+{
+	unsigned int cap;
+	int cmd;
+
+	for (cap = 0; cap < sizeof(*hwcaps) * BITS_PER_BYTE; cap++) {
+		if (!(*hwcaps & BIT(cap)))
+			continue;
+
+		cmd = spi_nor_hwcaps_read2cmd(BIT(cap));
+		if (cmd >= 0 &&
+		    !spi_nor_spimem_check_readop(nor, &params->reads[cmd]))
+			*hwcaps &= ~BIT(cap);
+
+		cmd = spi_nor_hwcaps_pp2cmd(BIT(cap));
+		if (cmd >= 0 &&
+		    !spi_nor_spimem_check_pp(nor, &params->page_programs[cmd]))
+			*hwcaps &= ~BIT(cap);
+	}
+}
+
 static int spi_nor_select_read(struct spi_nor *nor,
 			       const struct spi_nor_flash_parameter *params,
 			       u32 shared_hwcaps)
@@ -2338,13 +2581,42 @@ static int spi_nor_select_pp(struct spi_nor *nor,
 }
 
 static int spi_nor_select_erase(struct spi_nor *nor,
-				const struct flash_info *info)
+				const struct flash_info *info,
+				const struct spi_nor_flash_parameter *params)
 {
+	const struct spi_nor_erase_type *erase, *best = NULL;
 	struct mtd_info *mtd = &nor->mtd;
+	int i;
 
-	/* Do nothing if already configured from SFDP. */
-	if (mtd->erasesize)
+	/*
+	 * Prefer the SFDP erase types: the largest one the controller can
+	 * send, or the 4KiB one if small sectors were asked for.
+	 */
+	for (i = 0; i < SNOR_ERASE_TYPE_MAX; i++) {
+		erase = &params->erase_types[i];
+		if (!erase->size ||
+		    !spi_nor_spimem_check_erase(nor, erase->opcode))
+			continue;
+
+#ifdef CONFIG_SPI_FLASH_USE_4K_SECTORS
+		if (erase->size == SZ_4K) {
+			best = erase;
+			break;
+		}
+#endif
+		if (!best || best->size < erase->size)
+			best = erase;
+	}
+
+	if (best) {
+		nor->erase_opcode = best->opcode;
+		mtd->erasesize = best->size;
 		return 0;
+	}
+
+	/* The generic part only has what SFDP told us */
+	if (!info->sector_size)
+		return -EINVAL;
 
 #ifdef CONFIG_SPI_FLASH_USE_4K_SECTORS
 	/* prefer "small sector" erase if possible */
@@ -2389,6 +2661,8 @@ static int spi_nor_setup(struct spi_nor *nor, const struct flash_info *info,
 		shared_mask &= ~ignored_mask;
 	}
 
+	spi_nor_spimem_adjust_hwcaps(nor, params, &shared_mask);
+
 	/* Select the (Fast) Read command. */
 	err = spi_nor_select_read(nor, params, shared_mask);
 	if (err) {
@@ -2406,7 +2680,7 @@ static int spi_nor_setup(struct spi_nor *nor, const struct flash_info *info,
 	}
 
 	/* Select the Sector Erase command. */
-	err = spi_nor_select_erase(nor, info);
+	err = spi_nor_select_erase(nor, info, params);
 	if (err) {
 		dev_dbg(nor->dev,
 			"can't select erase settings supported by both the SPI controller and memory.\n");
@@ -2424,6 +2698,75 @@ static int spi_nor_setup(struct spi_nor *nor, const struct flash_info *info,
 	return 0;
 }
 
+#if CONFIG_IS_ENABLED(SPI_FLASH_SFDP_SUPPORT)
+/* Check whether the 4BAIT lists a 4-byte address variant of a command */
+static bool spi_nor_has_4bait(const struct spi_nor_flash_parameter *params,
+			      bool read, u8 opcode, enum spi_nor_protocol proto)
+{
+	unsigned int cap;
+	int cmd;
+
+	for (cap = 0; cap < sizeof(params->hwcaps_4b) * BITS_PER_BYTE; cap++) {
+		if (!(params->hwcaps_4b & BIT(cap)))
+			continue;
+
+		if (read) {
+			cmd = spi_nor_hwcaps_read2cmd(BIT(cap));
+			if (cmd >= 0 && params->reads[cmd].opcode == opcode &&
+			    params->reads[cmd].proto == proto)
+				return true;
+		} else {
+			cmd = spi_nor_hwcaps_pp2cmd(BIT(cap));
+			if (cmd >= 0 &&
+			    params->page_programs[cmd].opcode == opcode &&
+			    params->page_programs[cmd].proto == proto)
+				return true;
+		}
+	}
+
+	return false;
+}
+
+/**
+ * spi_nor_use_4bait() - use the 4-byte address op codes listed in SFDP
+ * @nor:	pointer to a 'struct spi_nor'
+ * @params:	the memory parameters, as parsed from SFDP
+ *
+ * If the selected Read, Page Program and Sector Erase commands all have a
+ * 4-byte address variant, use them rather than entering the 4-byte address
+ * mode. That mode is stateful and a reset leaves the boot ROM unable to
+ * read the memory unless the RESET# pin is wired.
+ */
+static void spi_nor_use_4bait(struct spi_nor *nor,
+			      const struct spi_nor_flash_parameter *params)
+{
+	const struct spi_nor_erase_type *erase = NULL;
+	int i;
+
+	for (i = 0; i < SNOR_ERASE_TYPE_MAX; i++)
+		if (params->erase_types[i].size == nor->mtd.erasesize &&
+		    params->erase_types[i].opcode == nor->erase_opcode)
+			erase = &params->erase_types[i];
+
+	if (!erase || !erase->opcode_4b ||
+	    !spi_nor_has_4bait(params, true, nor->read_opcode,
+			       nor->read_proto) ||
+	    !spi_nor_has_4bait(params, false, nor->program_opcode,
+			       nor->write_proto))
+		return;
+
+	nor->read_opcode = spi_nor_convert_3to4_read(nor->read_opcode);
+	nor->program_opcode = spi_nor_convert_3to4_program(nor->program_opcode);
+	nor->erase_opcode = erase->opcode_4b;
+	nor->flags |= SNOR_F_4B_OPCODES;
+}
+#else
+static void spi_nor_use_4bait(struct spi_nor *nor,
+			      const struct spi_nor_flash_parameter *params)
+{
+}
+#endif /* SPI_FLASH_SFDP_SUPPORT */
+
 static int spi_nor_init(struct spi_nor *nor)
 {
 	int err;
@@ -2451,7 +2794,8 @@ static int spi_nor_init(struct spi_nor *nor)
 
 	if (nor->addr_width == 4 &&
 	    (JEDEC_MFR(nor->info) != SNOR_MFR_SPANSION) &&
-	    !(nor->info->flags & SPI_NOR_4B_OPCODES)) {
+	    !(nor->info->flags & SPI_NOR_4B_OPCODES) &&
+	    !(nor->flags & SNOR_F_4B_OPCODES)) {
 		/*
 		 * If the RESET# pin isn't hooked up properly, or the system
 		 * otherwise doesn't perform a reset command in the boot
@@ -2590,6 +2934,8 @@ int spi_nor_scan(struct spi_nor *nor)
 
 	if (nor->addr_width) {
 		/* already configured from SFDP */
+		if (nor->addr_width == 4)
+			spi_nor_use_4bait(nor, &params);
 	} else if (info->addr_width) {
 		nor->addr_width = info->addr_width;
 	} else if (mtd->size > SZ_16M) {
@@ -2599,6 +2945,8 @@ int spi_nor_scan(struct spi_nor *nor)
 		if (JEDEC_MFR(info) == SNOR_MFR_SPANSION ||
 		    info->flags & SPI_NOR_4B_OPCODES)
 			spi_nor_set_4byte_opcodes(nor, info);
+		else
+			spi_nor_use_4bait(nor, &params);
 #else
 	/* Configure the BAR - discover bank cmds and read current bank */
 	nor->addr_width = 3;
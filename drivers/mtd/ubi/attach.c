@@ -830,6 +830,8 @@ static int scan_peb(struct ubi_device *ubi, struct ubi_attach_info *ai,
 		return 0;
 	}
 
+	ubi_io_read_hdrs(ubi, pnum);
+
 	err = ubi_io_read_ec_hdr(ubi, pnum, ech, 0);
 	if (err < 0)
 		return err;
@@ -1399,11 +1401,16 @@ int ubi_attach(struct ubi_device *ubi, int force_scan)
 {
 	int err;
 	struct ubi_attach_info *ai;
+	unsigned long start = get_timer(0);
 
 	ai = alloc_ai();
 	if (!ai)
 		return -ENOMEM;
 
+	err = ubi_io_hdr_window_init(ubi);
+	if (err)
+		goto out_ai;
+
 #ifdef CONFIG_MTD_UBI_FASTMAP
 	/* On small flash devices we disable fastmap in any case. */
 	if ((int)mtd_div_by_eb(ubi->mtd->size, ubi->mtd) <= UBI_FM_MAX_START) {
@@ -1419,8 +1426,10 @@ int ubi_attach(struct ubi_device *ubi, int force_scan)
 			if (err != UBI_NO_FASTMAP) {
 				destroy_ai(ai);
 				ai = alloc_ai();
-				if (!ai)
+				if (!ai) {
+					ubi_io_hdr_window_free(ubi);
 					return -ENOMEM;
+				}
 
 				err = scan_all(ubi, ai, 0);
 			} else {
@@ -1477,6 +1486,10 @@ int ubi_attach(struct ubi_device *ubi, int force_scan)
 	}
 #endif
 
+	dbg_gen("attach: %d PEBs scanned, %llu bytes in %u reads (%u header reads merged), %lu ms",
+		ubi->hdr_win->pebs, ubi->hdr_win->bytes, ubi->hdr_win->reads,
+		ubi->hdr_win->hits, get_timer(start));
+	ubi_io_hdr_window_free(ubi);
 	destroy_ai(ai);
 	return 0;
 
@@ -1486,6 +1499,7 @@ out_vtbl:
 	ubi_free_internal_volumes(ubi);
 	vfree(ubi->vtbl);
 out_ai:
+	ubi_io_hdr_window_free(ubi);
 	destroy_ai(ai);
 	return err;
 }
@@ -0,0 +1,178 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Read-only fastmap layout parser, shared by UBI and UBISPL.
+ *
+ * Copyright (c) 2012 Linutronix GmbH
+ * Copyright (c) 2014 sigma star gmbh
+ * Author: Richard Weinberger <richard@nod.at>
+ */
+
+#include <common.h>
+#include <errno.h>
+#include <asm/byteorder.h>
+
+#include "fastmap-parse.h"
+
+#define fm_err(fmt, ...) printf("UBI error: fastmap: " fmt "\n", ##__VA_ARGS__)
+
+static int check_pool(const struct ubi_fm_scan_pool *fmpl, const char *name)
+{
+	if (be32_to_cpu(fmpl->magic) != UBI_FM_POOL_MAGIC) {
+		fm_err("bad %s magic: 0x%x, expected: 0x%x", name,
+		       be32_to_cpu(fmpl->magic), UBI_FM_POOL_MAGIC);
+		return -EINVAL;
+	}
+
+	if (be16_to_cpu(fmpl->size) > UBI_FM_MAX_POOL_SIZE) {
+		fm_err("bad %s size: %i", name, be16_to_cpu(fmpl->size));
+		return -EINVAL;
+	}
+
+	if (be16_to_cpu(fmpl->max_size) > UBI_FM_MAX_POOL_SIZE) {
+		fm_err("bad maximal %s size: %i", name,
+		       be16_to_cpu(fmpl->max_size));
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+/**
+ * ubi_fm_parse - walk a fastmap and validate its layout.
+ * @fm_raw: the fastmap, starting with its super block
+ * @fm_size: size of @fm_raw in bytes
+ * @ops: callbacks invoked for the entries of the fastmap
+ * @priv: passed to the callbacks
+ * @fmp: filled with the header and the pools
+ *
+ * The walk only reads @fm_raw, it does not touch the flash. Validating the
+ * PEBs the fastmap points to is up to the caller.
+ *
+ * Returns 0 on success, -EINVAL if the fastmap is malformed, or the first
+ * non-zero value returned by a callback.
+ */
+int ubi_fm_parse(const void *fm_raw, size_t fm_size,
+		 const struct ubi_fm_parse_ops *ops, void *priv,
+		 struct ubi_fm_parsed *fmp)
+{
+	const struct ubi_fm_hdr *fmhdr;
+	const struct ubi_fm_volhdr *fmvhdr;
+	const struct ubi_fm_eba *fm_eba;
+	const struct ubi_fm_ec *fmec;
+	size_t fm_pos = sizeof(struct ubi_fm_sb);
+	u32 counts[UBI_FM_LIST_ERASE + 1];
+	u32 i, j, reserved;
+	int ret;
+
+	if (fm_pos >= fm_size)
+		return -EINVAL;
+
+	fmhdr = fm_raw + fm_pos;
+	fm_pos += sizeof(*fmhdr);
+	if (fm_pos >= fm_size)
+		return -EINVAL;
+
+	if (be32_to_cpu(fmhdr->magic) != UBI_FM_HDR_MAGIC) {
+		fm_err("bad header magic: 0x%x, expected: 0x%x",
+		       be32_to_cpu(fmhdr->magic), UBI_FM_HDR_MAGIC);
+		return -EINVAL;
+	}
+
+	fmp->hdr = fmhdr;
+
+	fmp->pool = fm_raw + fm_pos;
+	fm_pos += sizeof(*fmp->pool);
+	if (fm_pos >= fm_size)
+		return -EINVAL;
+	if (check_pool(fmp->pool, "pool"))
+		return -EINVAL;
+
+	fmp->wl_pool = fm_raw + fm_pos;
+	fm_pos += sizeof(*fmp->wl_pool);
+	if (fm_pos >= fm_size)
+		return -EINVAL;
+	if (check_pool(fmp->wl_pool, "WL pool"))
+		return -EINVAL;
+
+	fmp->pool_size = be16_to_cpu(fmp->pool->size);
+	fmp->wl_pool_size = be16_to_cpu(fmp->wl_pool->size);
+	fmp->max_pool_size = be16_to_cpu(fmp->pool->max_size);
+	fmp->max_wl_pool_size = be16_to_cpu(fmp->wl_pool->max_size);
+
+	counts[UBI_FM_LIST_FREE] = be32_to_cpu(fmhdr->free_peb_count);
+	counts[UBI_FM_LIST_USED] = be32_to_cpu(fmhdr->used_peb_count);
+	counts[UBI_FM_LIST_SCRUB] = be32_to_cpu(fmhdr->scrub_peb_count);
+	counts[UBI_FM_LIST_ERASE] = be32_to_cpu(fmhdr->erase_peb_count);
+
+	/* The EC lists follow the pools back to back */
+	for (i = UBI_FM_LIST_FREE; i <= UBI_FM_LIST_ERASE; i++) {
+		for (j = 0; j < counts[i]; j++) {
+			fmec = fm_raw + fm_pos;
+			fm_pos += sizeof(*fmec);
+			if (fm_pos >= fm_size)
+				return -EINVAL;
+
+			if (!ops->ec)
+				continue;
+			ret = ops->ec(priv, i, be32_to_cpu(fmec->pnum),
+				      be32_to_cpu(fmec->ec));
+			if (ret)
+				return ret;
+		}
+	}
+
+	/* Iterate over all volumes and their EBA tables */
+	for (i = 0; i < be32_to_cpu(fmhdr->vol_count); i++) {
+		fmvhdr = fm_raw + fm_pos;
+		fm_pos += sizeof(*fmvhdr);
+		if (fm_pos >= fm_size)
+			return -EINVAL;
+
+		if (be32_to_cpu(fmvhdr->magic) != UBI_FM_VHDR_MAGIC) {
+			fm_err("bad vol header magic: 0x%x, expected: 0x%x",
+			       be32_to_cpu(fmvhdr->magic), UBI_FM_VHDR_MAGIC);
+			return -EINVAL;
+		}
+
+		fm_eba = fm_raw + fm_pos;
+		fm_pos += sizeof(*fm_eba);
+		if (fm_pos >= fm_size)
+			return -EINVAL;
+
+		reserved = be32_to_cpu(fm_eba->reserved_pebs);
+		if (reserved > (fm_size - fm_pos) / sizeof(__be32))
+			return -EINVAL;
+		fm_pos += sizeof(__be32) * reserved;
+		if (fm_pos >= fm_size)
+			return -EINVAL;
+
+		if (be32_to_cpu(fm_eba->magic) != UBI_FM_EBA_MAGIC) {
+			fm_err("bad EBA header magic: 0x%x, expected: 0x%x",
+			       be32_to_cpu(fm_eba->magic), UBI_FM_EBA_MAGIC);
+			return -EINVAL;
+		}
+
+		if (ops->vol) {
+			ret = ops->vol(priv, fmvhdr, fm_eba);
+			if (ret)
+				return ret;
+		}
+
+		if (!ops->eba)
+			continue;
+
+		for (j = 0; j < reserved; j++) {
+			int pnum = be32_to_cpu(fm_eba->pnum[j]);
+
+			/* Unmapped LEB */
+			if (pnum < 0)
+				continue;
+
+			ret = ops->eba(priv, fmvhdr, j, pnum);
+			if (ret)
+				return ret;
+		}
+	}
+
+	return 0;
+}
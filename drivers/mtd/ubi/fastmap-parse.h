@@ -0,0 +1,67 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Read-only fastmap layout parser, shared by UBI and UBISPL.
+ *
+ * Copyright (c) 2012 Linutronix GmbH
+ * Copyright (c) 2014 sigma star gmbh
+ * Author: Richard Weinberger <richard@nod.at>
+ */
+
+#ifndef __UBI_FASTMAP_PARSE_H__
+#define __UBI_FASTMAP_PARSE_H__
+
+#include <linux/types.h>
+#include "ubi-media.h"
+
+/*
+ * The fastmap lists holding erase counters, in on-flash order.
+ */
+enum ubi_fm_list {
+	UBI_FM_LIST_FREE,
+	UBI_FM_LIST_USED,
+	UBI_FM_LIST_SCRUB,
+	UBI_FM_LIST_ERASE,
+};
+
+/**
+ * struct ubi_fm_parse_ops - fastmap parser callbacks
+ * @ec: called for every erase counter entry of @list
+ * @vol: called for every volume header, before its EBA entries
+ * @eba: called for every mapped LEB of the volume described by @fmvhdr
+ *
+ * Any callback may be NULL. A non-zero return value stops the walk and is
+ * returned by ubi_fm_parse(); -EINVAL means the fastmap is unusable.
+ */
+struct ubi_fm_parse_ops {
+	int (*ec)(void *priv, enum ubi_fm_list list, int pnum, int ec);
+	int (*vol)(void *priv, const struct ubi_fm_volhdr *fmvhdr,
+		   const struct ubi_fm_eba *fm_eba);
+	int (*eba)(void *priv, const struct ubi_fm_volhdr *fmvhdr, int lnum,
+		   int pnum);
+};
+
+/**
+ * struct ubi_fm_parsed - fastmap fields needed after the walk
+ * @hdr: the fastmap header
+ * @pool: the user pool
+ * @wl_pool: the wear-leveling pool
+ * @pool_size: number of PEBs in @pool
+ * @wl_pool_size: number of PEBs in @wl_pool
+ * @max_pool_size: maximal size of @pool
+ * @max_wl_pool_size: maximal size of @wl_pool
+ */
+struct ubi_fm_parsed {
+	const struct ubi_fm_hdr *hdr;
+	const struct ubi_fm_scan_pool *pool;
+	const struct ubi_fm_scan_pool *wl_pool;
+	int pool_size;
+	int wl_pool_size;
+	int max_pool_size;
+	int max_wl_pool_size;
+};
+
+int ubi_fm_parse(const void *fm_raw, size_t fm_size,
+		 const struct ubi_fm_parse_ops *ops, void *priv,
+		 struct ubi_fm_parsed *fmp);
+
+#endif /* __UBI_FASTMAP_PARSE_H__ */
@@ -20,6 +20,7 @@
 #include <linux/compat.h>
 #include <linux/math64.h>
 #include "ubi.h"
+#include "fastmap-parse.h"
 
 /**
  * init_seen - allocate memory for used for debugging.
@@ -596,228 +597,172 @@ static int count_fastmap_pebs(struct ubi_attach_info *ai)
 }
 
 /**
- * ubi_attach_fastmap - creates ubi_attach_info from a fastmap.
+ * struct fm_attach - state of ubi_attach_fastmap() while parsing the fastmap.
  * @ubi: UBI device object
  * @ai: UBI attach info object
- * @fm: the fastmap to be attached
- *
- * Returns 0 on success, UBI_BAD_FASTMAP if the found fastmap was unusable.
- * < 0 indicates an internal error.
+ * @used: list of the used and scrub PEBs not yet assigned to a volume
+ * @used_pebs: the entries of @used, indexed by PEB number
+ * @av: the volume whose EBA table is being parsed
  */
-static int ubi_attach_fastmap(struct ubi_device *ubi,
-			      struct ubi_attach_info *ai,
-			      struct ubi_fastmap_layout *fm)
-{
-	struct list_head used, free;
+struct fm_attach {
+	struct ubi_device *ubi;
+	struct ubi_attach_info *ai;
+	struct list_head *used;
+	struct ubi_ainf_peb **used_pebs;
 	struct ubi_ainf_volume *av;
-	struct ubi_ainf_peb *aeb, *tmp_aeb, *_tmp_aeb;
-	struct ubi_fm_sb *fmsb;
-	struct ubi_fm_hdr *fmhdr;
-	struct ubi_fm_scan_pool *fmpl, *fmpl_wl;
-	struct ubi_fm_ec *fmec;
-	struct ubi_fm_volhdr *fmvhdr;
-	struct ubi_fm_eba *fm_eba;
-	int ret, i, j, pool_size, wl_pool_size;
-	size_t fm_pos = 0, fm_size = ubi->fm_size;
-	unsigned long long max_sqnum = 0;
-	void *fm_raw = ubi->fm_buf;
-
-	INIT_LIST_HEAD(&used);
-	INIT_LIST_HEAD(&free);
-	ai->min_ec = UBI_MAX_ERASECOUNTER;
-
-	fmsb = (struct ubi_fm_sb *)(fm_raw);
-	ai->max_sqnum = fmsb->sqnum;
-	fm_pos += sizeof(struct ubi_fm_sb);
-	if (fm_pos >= fm_size)
-		goto fail_bad;
-
-	fmhdr = (struct ubi_fm_hdr *)(fm_raw + fm_pos);
-	fm_pos += sizeof(*fmhdr);
-	if (fm_pos >= fm_size)
-		goto fail_bad;
-
-	if (be32_to_cpu(fmhdr->magic) != UBI_FM_HDR_MAGIC) {
-		ubi_err(ubi, "bad fastmap header magic: 0x%x, expected: 0x%x",
-			be32_to_cpu(fmhdr->magic), UBI_FM_HDR_MAGIC);
-		goto fail_bad;
-	}
+};
 
-	fmpl = (struct ubi_fm_scan_pool *)(fm_raw + fm_pos);
-	fm_pos += sizeof(*fmpl);
-	if (fm_pos >= fm_size)
-		goto fail_bad;
-	if (be32_to_cpu(fmpl->magic) != UBI_FM_POOL_MAGIC) {
-		ubi_err(ubi, "bad fastmap pool magic: 0x%x, expected: 0x%x",
-			be32_to_cpu(fmpl->magic), UBI_FM_POOL_MAGIC);
-		goto fail_bad;
-	}
-
-	fmpl_wl = (struct ubi_fm_scan_pool *)(fm_raw + fm_pos);
-	fm_pos += sizeof(*fmpl_wl);
-	if (fm_pos >= fm_size)
-		goto fail_bad;
-	if (be32_to_cpu(fmpl_wl->magic) != UBI_FM_POOL_MAGIC) {
-		ubi_err(ubi, "bad fastmap WL pool magic: 0x%x, expected: 0x%x",
-			be32_to_cpu(fmpl_wl->magic), UBI_FM_POOL_MAGIC);
-		goto fail_bad;
-	}
-
-	pool_size = be16_to_cpu(fmpl->size);
-	wl_pool_size = be16_to_cpu(fmpl_wl->size);
-	fm->max_pool_size = be16_to_cpu(fmpl->max_size);
-	fm->max_wl_pool_size = be16_to_cpu(fmpl_wl->max_size);
+static int fm_attach_ec(void *priv, enum ubi_fm_list list, int pnum, int ec)
+{
+	struct fm_attach *fa = priv;
+	struct ubi_attach_info *ai = fa->ai;
+	int ret;
 
-	if (pool_size > UBI_FM_MAX_POOL_SIZE || pool_size < 0) {
-		ubi_err(ubi, "bad pool size: %i", pool_size);
-		goto fail_bad;
+	switch (list) {
+	case UBI_FM_LIST_FREE:
+		return add_aeb(ai, &ai->free, pnum, ec, 0);
+	case UBI_FM_LIST_ERASE:
+		return add_aeb(ai, &ai->erase, pnum, ec, 1);
+	default:
+		break;
 	}
 
-	if (wl_pool_size > UBI_FM_MAX_POOL_SIZE || wl_pool_size < 0) {
-		ubi_err(ubi, "bad WL pool size: %i", wl_pool_size);
-		goto fail_bad;
+	if (pnum < 0 || pnum >= fa->ubi->peb_count) {
+		ubi_err(fa->ubi, "bad PEB %i in used list", pnum);
+		return -EINVAL;
 	}
 
+	ret = add_aeb(ai, fa->used, pnum, ec, list == UBI_FM_LIST_SCRUB);
+	if (ret)
+		return ret;
 
-	if (fm->max_pool_size > UBI_FM_MAX_POOL_SIZE ||
-	    fm->max_pool_size < 0) {
-		ubi_err(ubi, "bad maximal pool size: %i", fm->max_pool_size);
-		goto fail_bad;
-	}
+	fa->used_pebs[pnum] = list_last_entry(fa->used, struct ubi_ainf_peb,
+					      u.list);
+	return 0;
+}
 
-	if (fm->max_wl_pool_size > UBI_FM_MAX_POOL_SIZE ||
-	    fm->max_wl_pool_size < 0) {
-		ubi_err(ubi, "bad maximal WL pool size: %i",
-			fm->max_wl_pool_size);
-		goto fail_bad;
-	}
+static int fm_attach_vol(void *priv, const struct ubi_fm_volhdr *fmvhdr,
+			 const struct ubi_fm_eba *fm_eba)
+{
+	struct fm_attach *fa = priv;
+	struct ubi_attach_info *ai = fa->ai;
+	struct ubi_ainf_volume *av;
 
-	/* read EC values from free list */
-	for (i = 0; i < be32_to_cpu(fmhdr->free_peb_count); i++) {
-		fmec = (struct ubi_fm_ec *)(fm_raw + fm_pos);
-		fm_pos += sizeof(*fmec);
-		if (fm_pos >= fm_size)
-			goto fail_bad;
+	av = add_vol(ai, be32_to_cpu(fmvhdr->vol_id),
+		     be32_to_cpu(fmvhdr->used_ebs),
+		     be32_to_cpu(fmvhdr->data_pad),
+		     fmvhdr->vol_type,
+		     be32_to_cpu(fmvhdr->last_eb_bytes));
 
-		add_aeb(ai, &ai->free, be32_to_cpu(fmec->pnum),
-			be32_to_cpu(fmec->ec), 0);
+	if (!av)
+		return -EINVAL;
+	if (PTR_ERR(av) == -EINVAL) {
+		ubi_err(fa->ubi, "volume (ID %i) already exists",
+			be32_to_cpu(fmvhdr->vol_id));
+		return -EINVAL;
 	}
 
-	/* read EC values from used list */
-	for (i = 0; i < be32_to_cpu(fmhdr->used_peb_count); i++) {
-		fmec = (struct ubi_fm_ec *)(fm_raw + fm_pos);
-		fm_pos += sizeof(*fmec);
-		if (fm_pos >= fm_size)
-			goto fail_bad;
+	ai->vols_found++;
+	if (ai->highest_vol_id < be32_to_cpu(fmvhdr->vol_id))
+		ai->highest_vol_id = be32_to_cpu(fmvhdr->vol_id);
 
-		add_aeb(ai, &used, be32_to_cpu(fmec->pnum),
-			be32_to_cpu(fmec->ec), 0);
-	}
-
-	/* read EC values from scrub list */
-	for (i = 0; i < be32_to_cpu(fmhdr->scrub_peb_count); i++) {
-		fmec = (struct ubi_fm_ec *)(fm_raw + fm_pos);
-		fm_pos += sizeof(*fmec);
-		if (fm_pos >= fm_size)
-			goto fail_bad;
+	fa->av = av;
+	return 0;
+}
 
-		add_aeb(ai, &used, be32_to_cpu(fmec->pnum),
-			be32_to_cpu(fmec->ec), 1);
-	}
+static int fm_attach_eba(void *priv, const struct ubi_fm_volhdr *fmvhdr,
+			 int lnum, int pnum)
+{
+	struct fm_attach *fa = priv;
+	struct ubi_ainf_volume *av = fa->av;
+	struct ubi_ainf_peb *aeb = NULL;
 
-	/* read EC values from erase list */
-	for (i = 0; i < be32_to_cpu(fmhdr->erase_peb_count); i++) {
-		fmec = (struct ubi_fm_ec *)(fm_raw + fm_pos);
-		fm_pos += sizeof(*fmec);
-		if (fm_pos >= fm_size)
-			goto fail_bad;
+	if (pnum < fa->ubi->peb_count)
+		aeb = fa->used_pebs[pnum];
 
-		add_aeb(ai, &ai->erase, be32_to_cpu(fmec->pnum),
-			be32_to_cpu(fmec->ec), 1);
+	if (!aeb) {
+		ubi_err(fa->ubi, "PEB %i is in EBA but not in used list", pnum);
+		return -EINVAL;
 	}
 
-	ai->mean_ec = div_u64(ai->ec_sum, ai->ec_count);
-	ai->bad_peb_count = be32_to_cpu(fmhdr->bad_peb_count);
-
-	/* Iterate over all volumes and read their EBA table */
-	for (i = 0; i < be32_to_cpu(fmhdr->vol_count); i++) {
-		fmvhdr = (struct ubi_fm_volhdr *)(fm_raw + fm_pos);
-		fm_pos += sizeof(*fmvhdr);
-		if (fm_pos >= fm_size)
-			goto fail_bad;
-
-		if (be32_to_cpu(fmvhdr->magic) != UBI_FM_VHDR_MAGIC) {
-			ubi_err(ubi, "bad fastmap vol header magic: 0x%x, expected: 0x%x",
-				be32_to_cpu(fmvhdr->magic), UBI_FM_VHDR_MAGIC);
-			goto fail_bad;
-		}
+	/* Each used PEB backs a single LEB */
+	fa->used_pebs[pnum] = NULL;
+	aeb->lnum = lnum;
 
-		av = add_vol(ai, be32_to_cpu(fmvhdr->vol_id),
-			     be32_to_cpu(fmvhdr->used_ebs),
-			     be32_to_cpu(fmvhdr->data_pad),
-			     fmvhdr->vol_type,
-			     be32_to_cpu(fmvhdr->last_eb_bytes));
-
-		if (!av)
-			goto fail_bad;
-		if (PTR_ERR(av) == -EINVAL) {
-			ubi_err(ubi, "volume (ID %i) already exists",
-				fmvhdr->vol_id);
-			goto fail_bad;
-		}
+	if (av->highest_lnum <= aeb->lnum)
+		av->highest_lnum = aeb->lnum;
 
-		ai->vols_found++;
-		if (ai->highest_vol_id < be32_to_cpu(fmvhdr->vol_id))
-			ai->highest_vol_id = be32_to_cpu(fmvhdr->vol_id);
+	assign_aeb_to_av(fa->ai, aeb, av);
 
-		fm_eba = (struct ubi_fm_eba *)(fm_raw + fm_pos);
-		fm_pos += sizeof(*fm_eba);
-		fm_pos += (sizeof(__be32) * be32_to_cpu(fm_eba->reserved_pebs));
-		if (fm_pos >= fm_size)
-			goto fail_bad;
-
-		if (be32_to_cpu(fm_eba->magic) != UBI_FM_EBA_MAGIC) {
-			ubi_err(ubi, "bad fastmap EBA header magic: 0x%x, expected: 0x%x",
-				be32_to_cpu(fm_eba->magic), UBI_FM_EBA_MAGIC);
-			goto fail_bad;
-		}
+	dbg_bld("inserting PEB:%i (LEB %i) to vol %i",
+		aeb->pnum, aeb->lnum, av->vol_id);
+	return 0;
+}
 
-		for (j = 0; j < be32_to_cpu(fm_eba->reserved_pebs); j++) {
-			int pnum = be32_to_cpu(fm_eba->pnum[j]);
+static const struct ubi_fm_parse_ops fm_attach_ops = {
+	.ec	= fm_attach_ec,
+	.vol	= fm_attach_vol,
+	.eba	= fm_attach_eba,
+};
 
-			if ((int)be32_to_cpu(fm_eba->pnum[j]) < 0)
-				continue;
+/**
+ * ubi_attach_fastmap - creates ubi_attach_info from a fastmap.
+ * @ubi: UBI device object
+ * @ai: UBI attach info object
+ * @fm: the fastmap to be attached
+ *
+ * Returns 0 on success, UBI_BAD_FASTMAP if the found fastmap was unusable.
+ * < 0 indicates an internal error.
+ */
+static int ubi_attach_fastmap(struct ubi_device *ubi,
+			      struct ubi_attach_info *ai,
+			      struct ubi_fastmap_layout *fm)
+{
+	struct list_head used, free;
+	struct ubi_ainf_peb *tmp_aeb, *_tmp_aeb;
+	struct ubi_fm_sb *fmsb;
+	struct ubi_fm_parsed fmp;
+	struct fm_attach fa;
+	int ret;
+	unsigned long long max_sqnum = 0;
+	void *fm_raw = ubi->fm_buf;
 
-			aeb = NULL;
-			list_for_each_entry(tmp_aeb, &used, u.list) {
-				if (tmp_aeb->pnum == pnum) {
-					aeb = tmp_aeb;
-					break;
-				}
-			}
+	INIT_LIST_HEAD(&used);
+	INIT_LIST_HEAD(&free);
+	ai->min_ec = UBI_MAX_ERASECOUNTER;
 
-			if (!aeb) {
-				ubi_err(ubi, "PEB %i is in EBA but not in used list", pnum);
-				goto fail_bad;
-			}
+	fmsb = (struct ubi_fm_sb *)(fm_raw);
+	ai->max_sqnum = fmsb->sqnum;
 
-			aeb->lnum = j;
+	fa.ubi = ubi;
+	fa.ai = ai;
+	fa.used = &used;
+	fa.av = NULL;
+	fa.used_pebs = kcalloc(ubi->peb_count, sizeof(*fa.used_pebs),
+			       GFP_KERNEL);
+	if (!fa.used_pebs)
+		return -ENOMEM;
 
-			if (av->highest_lnum <= aeb->lnum)
-				av->highest_lnum = aeb->lnum;
+	ret = ubi_fm_parse(fm_raw, ubi->fm_size, &fm_attach_ops, &fa, &fmp);
+	kfree(fa.used_pebs);
+	if (ret == -EINVAL)
+		goto fail_bad;
+	if (ret)
+		goto fail;
 
-			assign_aeb_to_av(ai, aeb, av);
+	fm->max_pool_size = fmp.max_pool_size;
+	fm->max_wl_pool_size = fmp.max_wl_pool_size;
 
-			dbg_bld("inserting PEB:%i (LEB %i) to vol %i",
-				aeb->pnum, aeb->lnum, av->vol_id);
-		}
-	}
+	ai->mean_ec = div_u64(ai->ec_sum, ai->ec_count);
+	ai->bad_peb_count = be32_to_cpu(fmp.hdr->bad_peb_count);
 
-	ret = scan_pool(ubi, ai, fmpl->pebs, pool_size, &max_sqnum, &free);
+	ret = scan_pool(ubi, ai, (__be32 *)fmp.pool->pebs, fmp.pool_size,
+			&max_sqnum, &free);
 	if (ret)
 		goto fail;
 
-	ret = scan_pool(ubi, ai, fmpl_wl->pebs, wl_pool_size, &max_sqnum, &free);
+	ret = scan_pool(ubi, ai, (__be32 *)fmp.wl_pool->pebs,
+			fmp.wl_pool_size, &max_sqnum, &free);
 	if (ret)
 		goto fail;
 
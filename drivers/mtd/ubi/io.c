@@ -135,6 +135,18 @@ int ubi_io_read(const struct ubi_device *ubi, void *buf, int pnum, int offset,
 	if (err)
 		return err;
 
+	if (ubi->hdr_win && ubi->hdr_win->pnum == pnum &&
+	    offset + len <= ubi->hdr_win->len) {
+		memcpy(buf, ubi->hdr_win->buf + offset, len);
+		ubi->hdr_win->hits++;
+		return 0;
+	}
+
+	if (ubi->hdr_win) {
+		ubi->hdr_win->reads++;
+		ubi->hdr_win->bytes += len;
+	}
+
 	/*
 	 * Deliberately corrupt the buffer to improve robustness. Indeed, if we
 	 * do not do this, the following may happen:
@@ -246,6 +258,9 @@ int ubi_io_write(struct ubi_device *ubi, const void *buf, int pnum, int offset,
 		return -EROFS;
 	}
 
+	if (ubi->hdr_win && ubi->hdr_win->pnum == pnum)
+		ubi->hdr_win->pnum = -1;
+
 	err = self_check_not_bad(ubi, pnum);
 	if (err)
 		return err;
@@ -338,6 +353,9 @@ static int do_sync_erase(struct ubi_device *ubi, int pnum)
 		return -EROFS;
 	}
 
+	if (ubi->hdr_win && ubi->hdr_win->pnum == pnum)
+		ubi->hdr_win->pnum = -1;
+
 retry:
 	init_waitqueue_head(&wq);
 	memset(&ei, 0, sizeof(struct erase_info));
@@ -1113,6 +1131,73 @@ int ubi_io_write_vid_hdr(struct ubi_device *ubi, int pnum,
 	return err;
 }
 
+/**
+ * ubi_io_hdr_window_init - start reading EC and VID headers at once.
+ * @ubi: UBI device description object
+ *
+ * This function allocates @ubi->hdr_win, used by ubi_io_read_hdrs(). It also
+ * starts counting the MTD reads, for the attach report. Returns zero in case
+ * of success and %-ENOMEM in case of failure.
+ */
+int ubi_io_hdr_window_init(struct ubi_device *ubi)
+{
+	struct ubi_hdr_window *win;
+
+	win = kzalloc(sizeof(*win), GFP_KERNEL);
+	if (!win)
+		return -ENOMEM;
+
+	win->len = ubi->vid_hdr_aloffset + ubi->vid_hdr_alsize;
+	win->buf = kmalloc(win->len, GFP_KERNEL);
+	if (!win->buf) {
+		kfree(win);
+		return -ENOMEM;
+	}
+
+	win->pnum = -1;
+	ubi->hdr_win = win;
+
+	return 0;
+}
+
+/**
+ * ubi_io_hdr_window_free - stop reading EC and VID headers at once.
+ * @ubi: UBI device description object
+ */
+void ubi_io_hdr_window_free(struct ubi_device *ubi)
+{
+	if (!ubi->hdr_win)
+		return;
+
+	kfree(ubi->hdr_win->buf);
+	kfree(ubi->hdr_win);
+	ubi->hdr_win = NULL;
+}
+
+/**
+ * ubi_io_read_hdrs - read the EC and VID headers of a PEB at once.
+ * @ubi: UBI device description object
+ * @pnum: physical eraseblock to read from
+ *
+ * This function reads the whole headers area of PEB @pnum with a single MTD
+ * operation. The 'ubi_io_read_ec_hdr()' and 'ubi_io_read_vid_hdr()' calls
+ * which follow are then served from memory. If the read was not clean, the
+ * window is left empty and the headers are read again one by one, so that
+ * errors and bit-flips are reported as precisely as before.
+ */
+void ubi_io_read_hdrs(struct ubi_device *ubi, int pnum)
+{
+	struct ubi_hdr_window *win = ubi->hdr_win;
+
+	if (!win)
+		return;
+
+	win->pnum = -1;
+	win->pebs++;
+	if (!ubi_io_read(ubi, win->buf, pnum, 0, win->len))
+		win->pnum = pnum;
+}
+
 /**
  * self_check_not_bad - ensure that a physical eraseblock is not bad.
  * @ubi: UBI device description object
@@ -527,6 +527,7 @@ struct ubi_debug_info {
  * @peb_buf: a buffer of PEB size used for different purposes
  * @buf_mutex: protects @peb_buf
  * @ckvol_mutex: serializes static volume checking when opening
+ * @hdr_win: header read window and read counters, only set while attaching
  *
  * @dbg: debugging information for this UBI device
  */
@@ -626,10 +627,36 @@ struct ubi_device {
 	void *peb_buf;
 	struct mutex buf_mutex;
 	struct mutex ckvol_mutex;
+	struct ubi_hdr_window *hdr_win;
 
 	struct ubi_debug_info dbg;
 };
 
+/**
+ * struct ubi_hdr_window - EC and VID headers of a PEB read at once.
+ * @buf: the headers area of PEB @pnum, @len bytes starting at offset 0
+ * @pnum: PEB held in @buf, %-1 if none
+ * @len: size of the headers area, up to the end of the VID header
+ * @pebs: number of PEBs whose headers were read through the window
+ * @reads: number of MTD reads done
+ * @bytes: number of bytes read from the MTD device
+ * @hits: number of header reads served from @buf
+ *
+ * Attaching reads the EC and the VID header of every PEB. Reading both with
+ * a single MTD operation halves the number of reads done by the scan. The
+ * window is only filled when the read gave no error nor bit-flip, so that
+ * the separate header reads still report those exactly.
+ */
+struct ubi_hdr_window {
+	void *buf;
+	int pnum;
+	int len;
+	int pebs;
+	unsigned int reads;
+	unsigned long long bytes;
+	unsigned int hits;
+};
+
 /**
  * struct ubi_ainf_peb - attach information about a physical eraseblock.
  * @ec: erase counter (%UBI_UNKNOWN if it is unknown)
@@ -898,6 +925,9 @@ int ubi_io_read_vid_hdr(struct ubi_device *ubi, int pnum,
 			struct ubi_vid_hdr *vid_hdr, int verbose);
 int ubi_io_write_vid_hdr(struct ubi_device *ubi, int pnum,
 			 struct ubi_vid_hdr *vid_hdr);
+int ubi_io_hdr_window_init(struct ubi_device *ubi);
+void ubi_io_hdr_window_free(struct ubi_device *ubi);
+void ubi_io_read_hdrs(struct ubi_device *ubi, int pnum);
 
 /* build.c */
 int ubi_attach_mtd_dev(struct mtd_info *mtd, int ubi_num,
@@ -15,6 +15,7 @@
 #include <linux/crc32.h>
 
 #include "ubispl.h"
+#include "../ubi/fastmap-parse.h"
 
 /**
  * ubi_calc_fm_size - calculates the fastmap size in bytes for an UBI device.
@@ -413,27 +414,48 @@ static int ubi_scan_vid_hdr(struct ubi_scan_info *ubi, struct ubi_vid_hdr *vh,
 	return ubi_add_peb_to_vol(ubi, vh, vol_id, pnum, lnum);
 }
 
+/*
+ * Record a LEB of the fastmap EBA table. The VID header is not read here,
+ * ubi_load_block() validates the block when it is loaded and falls back to
+ * a full scan if the fastmap turns out to be stale. So the attach time does
+ * not depend on the size of the volumes.
+ */
 static int assign_aeb_to_av(struct ubi_scan_info *ubi, u32 pnum, u32 lnum,
 			     u32 vol_id, u32 vol_type, u32 used)
 {
-	struct ubi_vid_hdr *vh;
+	struct ubi_vol_info *vi;
 
 	if (ubi_io_is_bad(ubi, pnum))
 		return -EINVAL;
 
 	ubi->fastmap_pebs++;
 
-#ifndef CONFIG_SPL_UBI_LOAD_BY_VOLNAME
+#ifdef CONFIG_SPL_UBI_LOAD_BY_VOLNAME
+	/* The volume table is needed to look up the names, read it now */
+	if (vol_id == UBI_LAYOUT_VOLUME_ID)
+		return ubi_scan_vid_hdr(ubi, ubi->blockinfo + pnum, pnum);
+#endif
+
 	if (vol_id >= UBI_SPL_VOL_IDS || vol_type != UBI_STATIC_VOLUME)
 		return 0;
 
+#ifndef CONFIG_SPL_UBI_LOAD_BY_VOLNAME
 	/* We are only interested in the volumes to load */
 	if (!test_bit(vol_id, ubi->toload))
 		return 0;
 #endif
-	vh = ubi->blockinfo + pnum;
+	if (lnum >= UBI_MAX_VOL_LEBS) {
+		ubi_warn("Vol: %u LEB %d > %d", vol_id, lnum, UBI_MAX_VOL_LEBS);
+		return -EINVAL;
+	}
 
-	return ubi_scan_vid_hdr(ubi, vh, pnum);
+	vi = ubi->volinfo + vol_id;
+	vi->lebs_to_pebs[lnum] = pnum;
+	generic_set_bit(lnum, vi->found);
+	if (lnum > vi->last_block)
+		vi->last_block = lnum;
+
+	return 0;
 }
 
 static int scan_pool(struct ubi_scan_info *ubi, __be32 *pebs, int pool_size)
@@ -470,214 +492,68 @@ struct ubi_attach_info {
 	int i;
 };
 
-static int ubi_attach_fastmap(struct ubi_scan_info *ubi,
-			      struct ubi_attach_info *ai,
-			      struct ubi_fastmap_layout *fm)
+static int fm_attach_ec(void *priv, enum ubi_fm_list list, int pnum, int ec)
 {
-	struct ubi_fm_hdr *fmhdr;
-	struct ubi_fm_scan_pool *fmpl1, *fmpl2;
-	struct ubi_fm_ec *fmec;
-	struct ubi_fm_volhdr *fmvhdr;
-	struct ubi_fm_eba *fm_eba;
-	int ret, i, j, pool_size, wl_pool_size;
-	size_t fm_pos = 0, fm_size = ubi->fm_size;
-	void *fm_raw = ubi->fm_buf;
-
-	memset(ubi->fm_used, 0, sizeof(ubi->fm_used));
-
-	fm_pos += sizeof(struct ubi_fm_sb);
-	if (fm_pos >= fm_size)
-		goto fail_bad;
-
-	fmhdr = (struct ubi_fm_hdr *)(fm_raw + fm_pos);
-	fm_pos += sizeof(*fmhdr);
-	if (fm_pos >= fm_size)
-		goto fail_bad;
-
-	if (be32_to_cpu(fmhdr->magic) != UBI_FM_HDR_MAGIC) {
-		ubi_err("bad fastmap header magic: 0x%x, expected: 0x%x",
-			be32_to_cpu(fmhdr->magic), UBI_FM_HDR_MAGIC);
-		goto fail_bad;
-	}
-
-	fmpl1 = (struct ubi_fm_scan_pool *)(fm_raw + fm_pos);
-	fm_pos += sizeof(*fmpl1);
-	if (fm_pos >= fm_size)
-		goto fail_bad;
-	if (be32_to_cpu(fmpl1->magic) != UBI_FM_POOL_MAGIC) {
-		ubi_err("bad fastmap pool magic: 0x%x, expected: 0x%x",
-			be32_to_cpu(fmpl1->magic), UBI_FM_POOL_MAGIC);
-		goto fail_bad;
-	}
-
-	fmpl2 = (struct ubi_fm_scan_pool *)(fm_raw + fm_pos);
-	fm_pos += sizeof(*fmpl2);
-	if (fm_pos >= fm_size)
-		goto fail_bad;
-	if (be32_to_cpu(fmpl2->magic) != UBI_FM_POOL_MAGIC) {
-		ubi_err("bad fastmap pool magic: 0x%x, expected: 0x%x",
-			be32_to_cpu(fmpl2->magic), UBI_FM_POOL_MAGIC);
-		goto fail_bad;
-	}
-
-	pool_size = be16_to_cpu(fmpl1->size);
-	wl_pool_size = be16_to_cpu(fmpl2->size);
-	fm->max_pool_size = be16_to_cpu(fmpl1->max_size);
-	fm->max_wl_pool_size = be16_to_cpu(fmpl2->max_size);
-
-	if (pool_size > UBI_FM_MAX_POOL_SIZE || pool_size < 0) {
-		ubi_err("bad pool size: %i", pool_size);
-		goto fail_bad;
-	}
-
-	if (wl_pool_size > UBI_FM_MAX_POOL_SIZE || wl_pool_size < 0) {
-		ubi_err("bad WL pool size: %i", wl_pool_size);
-		goto fail_bad;
-	}
-
-	if (fm->max_pool_size > UBI_FM_MAX_POOL_SIZE ||
-	    fm->max_pool_size < 0) {
-		ubi_err("bad maximal pool size: %i", fm->max_pool_size);
-		goto fail_bad;
-	}
-
-	if (fm->max_wl_pool_size > UBI_FM_MAX_POOL_SIZE ||
-	    fm->max_wl_pool_size < 0) {
-		ubi_err("bad maximal WL pool size: %i", fm->max_wl_pool_size);
-		goto fail_bad;
-	}
-
-	/* read EC values from free list */
-	for (i = 0; i < be32_to_cpu(fmhdr->free_peb_count); i++) {
-		fmec = (struct ubi_fm_ec *)(fm_raw + fm_pos);
-		fm_pos += sizeof(*fmec);
-		if (fm_pos >= fm_size)
-			goto fail_bad;
-	}
-
-	/* read EC values from used list */
-	for (i = 0; i < be32_to_cpu(fmhdr->used_peb_count); i++) {
-		fmec = (struct ubi_fm_ec *)(fm_raw + fm_pos);
-		fm_pos += sizeof(*fmec);
-		if (fm_pos >= fm_size)
-			goto fail_bad;
-
-		generic_set_bit(be32_to_cpu(fmec->pnum), ubi->fm_used);
-	}
+	struct ubi_scan_info *ubi = priv;
 
-	/* read EC values from scrub list */
-	for (i = 0; i < be32_to_cpu(fmhdr->scrub_peb_count); i++) {
-		fmec = (struct ubi_fm_ec *)(fm_raw + fm_pos);
-		fm_pos += sizeof(*fmec);
-		if (fm_pos >= fm_size)
-			goto fail_bad;
-	}
-
-	/* read EC values from erase list */
-	for (i = 0; i < be32_to_cpu(fmhdr->erase_peb_count); i++) {
-		fmec = (struct ubi_fm_ec *)(fm_raw + fm_pos);
-		fm_pos += sizeof(*fmec);
-		if (fm_pos >= fm_size)
-			goto fail_bad;
-	}
-
-	/* Iterate over all volumes and read their EBA table */
-	for (i = 0; i < be32_to_cpu(fmhdr->vol_count); i++) {
-		u32 vol_id, vol_type, used, reserved;
-
-		fmvhdr = (struct ubi_fm_volhdr *)(fm_raw + fm_pos);
-		fm_pos += sizeof(*fmvhdr);
-		if (fm_pos >= fm_size)
-			goto fail_bad;
-
-		if (be32_to_cpu(fmvhdr->magic) != UBI_FM_VHDR_MAGIC) {
-			ubi_err("bad fastmap vol header magic: 0x%x, " \
-				"expected: 0x%x",
-				be32_to_cpu(fmvhdr->magic), UBI_FM_VHDR_MAGIC);
-			goto fail_bad;
-		}
+	if (list == UBI_FM_LIST_USED && !ubi_io_is_bad(ubi, pnum))
+		generic_set_bit(pnum, ubi->fm_used);
+	return 0;
+}
 
-		vol_id = be32_to_cpu(fmvhdr->vol_id);
-		vol_type = fmvhdr->vol_type;
-		used = be32_to_cpu(fmvhdr->used_ebs);
-
-		fm_eba = (struct ubi_fm_eba *)(fm_raw + fm_pos);
-		fm_pos += sizeof(*fm_eba);
-		fm_pos += (sizeof(__be32) * be32_to_cpu(fm_eba->reserved_pebs));
-		if (fm_pos >= fm_size)
-			goto fail_bad;
-
-		if (be32_to_cpu(fm_eba->magic) != UBI_FM_EBA_MAGIC) {
-			ubi_err("bad fastmap EBA header magic: 0x%x, " \
-				"expected: 0x%x",
-				be32_to_cpu(fm_eba->magic), UBI_FM_EBA_MAGIC);
-			goto fail_bad;
-		}
+static int fm_attach_eba(void *priv, const struct ubi_fm_volhdr *fmvhdr,
+			 int lnum, int pnum)
+{
+	struct ubi_scan_info *ubi = priv;
+	u32 vol_id = be32_to_cpu(fmvhdr->vol_id);
+	u32 used = be32_to_cpu(fmvhdr->used_ebs);
 
-		reserved = be32_to_cpu(fm_eba->reserved_pebs);
-		ubi_dbg("FA: vol %u used %u res: %u", vol_id, used, reserved);
-		for (j = 0; j < reserved; j++) {
-			int pnum = be32_to_cpu(fm_eba->pnum[j]);
+	if (ubi_io_is_bad(ubi, pnum) || !__test_and_clear_bit(pnum, ubi->fm_used))
+		return 0;
 
-			if ((int)be32_to_cpu(fm_eba->pnum[j]) < 0)
-				continue;
+	/*
+	 * We only handle static volumes so used_ebs needs to be handed
+	 * in. And we do not assign the reserved blocks
+	 */
+	if (lnum >= used)
+		return 0;
 
-			if (!__test_and_clear_bit(pnum, ubi->fm_used))
-				continue;
+	ubi_dbg("FA: vol %u LEB %d PEB %d", vol_id, lnum, pnum);
+	return assign_aeb_to_av(ubi, pnum, lnum, vol_id, fmvhdr->vol_type,
+				used);
+}
 
-			/*
-			 * We only handle static volumes so used_ebs
-			 * needs to be handed in. And we do not assign
-			 * the reserved blocks
-			 */
-			if (j >= used)
-				continue;
+static const struct ubi_fm_parse_ops fm_attach_ops = {
+	.ec	= fm_attach_ec,
+	.eba	= fm_attach_eba,
+};
 
-			ret = assign_aeb_to_av(ubi, pnum, j, vol_id,
-					       vol_type, used);
-			if (!ret)
-				continue;
+static int ubi_attach_fastmap(struct ubi_scan_info *ubi,
+			      struct ubi_attach_info *ai,
+			      struct ubi_fastmap_layout *fm)
+{
+	struct ubi_fm_parsed fmp;
+	int ret;
 
-			/*
-			 * Nasty: The fastmap claims that the volume
-			 * has one block more than it, but that block
-			 * is always empty and the other blocks have
-			 * the correct number of total LEBs in the
-			 * headers. Deal with it.
-			 */
-			if (ret != UBI_IO_FF && j != used - 1)
-				goto fail_bad;
-			ubi_dbg("FA: Vol: %u Ignoring empty LEB %d of %d",
-				vol_id, j, used);
-		}
-	}
+	memset(ubi->fm_used, 0, sizeof(ubi->fm_used));
 
-	ret = scan_pool(ubi, fmpl1->pebs, pool_size);
+	ret = ubi_fm_parse(ubi->fm_buf, ubi->fm_size, &fm_attach_ops, ubi,
+			   &fmp);
 	if (ret)
-		goto fail;
+		return UBI_BAD_FASTMAP;
 
-	ret = scan_pool(ubi, fmpl2->pebs, wl_pool_size);
-	if (ret)
-		goto fail;
+	fm->max_pool_size = fmp.max_pool_size;
+	fm->max_wl_pool_size = fmp.max_wl_pool_size;
 
-#ifdef CHECKME
 	/*
-	 * If fastmap is leaking PEBs (must not happen), raise a
-	 * fat warning and fall back to scanning mode.
-	 * We do this here because in ubi_wl_init() it's too late
-	 * and we cannot fall back to scanning.
+	 * The pools are bounded by UBI_FM_MAX_POOL_SIZE. Their blocks may
+	 * hold newer copies of the LEBs recorded above, so they are read.
 	 */
-	if (WARN_ON(count_fastmap_pebs(ai) != ubi->peb_count -
-		    ai->bad_peb_count - fm->used_blocks))
-		goto fail_bad;
-#endif
-
-	return 0;
+	ret = scan_pool(ubi, (__be32 *)fmp.pool->pebs, fmp.pool_size);
+	if (ret)
+		return ret;
 
-fail_bad:
-	ret = UBI_BAD_FASTMAP;
-fail:
-	return ret;
+	return scan_pool(ubi, (__be32 *)fmp.wl_pool->pebs, fmp.wl_pool_size);
 }
 
 static int ubi_scan_fastmap(struct ubi_scan_info *ubi,
@@ -1046,6 +922,20 @@ static int ipl_load(struct ubi_scan_info *ubi, const u32 vol_id, uint8_t *laddr)
 	vi = ubi->volinfo + vol_id;
 	last = vi->last_block + 1;
 
+	/*
+	 * Nasty: The fastmap may claim that the volume has one block
+	 * more than it, but that block is always empty. The VID header
+	 * of the first block has the correct number of total LEBs.
+	 */
+	if (last > 1 && test_bit(0, vi->found)) {
+		u32 pnum = vi->lebs_to_pebs[0];
+		struct ubi_vid_hdr *vh = ubi->blockinfo + pnum;
+
+		if (!ubi_rescan_fm_vid_hdr(ubi, vh, pnum, vol_id, 0) &&
+		    be32_to_cpu(vh->used_ebs) < last)
+			last = be32_to_cpu(vh->used_ebs);
+	}
+
 	/* Read the blocks to RAM, check CRC */
 	for (lnum = 0 ; lnum < last; lnum++) {
 		int res = ubi_load_block(ubi, laddr, vi, vol_id, lnum, last);
@@ -16,13 +16,14 @@
 #include <linux/compat.h>
 #include "nvme.h"
 
-#define NVME_Q_DEPTH		2
+#define NVME_Q_DEPTH		16
 #define NVME_AQ_DEPTH		2
 #define NVME_SQ_SIZE(depth)	(depth * sizeof(struct nvme_command))
 #define NVME_CQ_SIZE(depth)	(depth * sizeof(struct nvme_completion))
 #define ADMIN_TIMEOUT		60
 #define IO_TIMEOUT		30
-#define MAX_PRP_POOL		512
+/* Largest I/O command, bigger requests are split and queued */
+#define MAX_TRANSFER_SHIFT	20
 
 enum nvme_queue_id {
 	NVME_ADMIN_Q,
@@ -30,6 +31,21 @@ enum nvme_queue_id {
 	NVME_Q_NUM,
 };
 
+/*
+ * An I/O command slot. The command id of the command is the index of the
+ * slot, and each slot owns a PRP list large enough for the largest command.
+ */
+struct nvme_io_cmd {
+	bool busy;
+	struct blk_req *req;	/* NULL once given up on */
+	struct nvme_ns *ns;
+	void *buf;
+	u32 len;
+	lbaint_t blkcnt;
+	ulong start;
+	u64 *prp_list;
+};
+
 /*
  * An NVM Express queue. Each device has at least two (one for admin
  * commands and one for I/O commands).
@@ -48,6 +64,8 @@ struct nvme_queue {
 	u16 qid;
 	u8 cq_phase;
 	u8 cqe_seen;
+	struct nvme_io_cmd *cmds;
+	int nr_cmds;
 	unsigned long cmdid_data[];
 };
 
@@ -69,7 +87,7 @@ static int nvme_wait_ready(struct nvme_dev *dev, bool enabled)
 	return -ETIME;
 }
 
-static int nvme_setup_prps(struct nvme_dev *dev, u64 *prp2,
+static int nvme_setup_prps(struct nvme_dev *dev, u64 *prp_list, u64 *prp2,
 			   int total_len, u64 dma_addr)
 {
 	u32 page_size = dev->page_size;
@@ -77,8 +95,6 @@ static int nvme_setup_prps(struct nvme_dev *dev, u64 *prp2,
 	u64 *prp_pool;
 	int length = total_len;
 	int i, nprps;
-	u32 prps_per_page = (page_size >> 3) - 1;
-	u32 num_pages;
 
 	length -= (page_size - offset);
 
@@ -96,39 +112,25 @@ static int nvme_setup_prps(struct nvme_dev *dev, u64 *prp2,
 	}
 
 	nprps = DIV_ROUND_UP(length, page_size);
-	num_pages = DIV_ROUND_UP(nprps, prps_per_page);
 
-	if (nprps > dev->prp_entry_num) {
-		free(dev->prp_pool);
-		/*
-		 * Always increase in increments of pages.  It doesn't waste
-		 * much memory and reduces the number of allocations.
-		 */
-		dev->prp_pool = memalign(page_size, num_pages * page_size);
-		if (!dev->prp_pool) {
-			printf("Error: malloc prp_pool fail\n");
-			return -ENOMEM;
-		}
-		dev->prp_entry_num = prps_per_page * num_pages;
-	}
-
-	prp_pool = dev->prp_pool;
+	prp_pool = prp_list;
 	i = 0;
 	while (nprps) {
 		if (i == ((page_size >> 3) - 1)) {
 			*(prp_pool + i) = cpu_to_le64((ulong)prp_pool +
 					page_size);
 			i = 0;
-			prp_pool += page_size;
+			prp_pool += page_size >> 3;
 		}
 		*(prp_pool + i++) = cpu_to_le64(dma_addr);
 		dma_addr += page_size;
 		nprps--;
 	}
-	*prp2 = (ulong)dev->prp_pool;
+	*prp2 = (ulong)prp_list;
 
-	flush_dcache_range((ulong)dev->prp_pool, (ulong)dev->prp_pool +
-			   dev->prp_entry_num * sizeof(u64));
+	/* The list is page aligned, only its end needs rounding up */
+	flush_dcache_range((ulong)prp_list,
+			   ALIGN((ulong)(prp_pool + i), ARCH_DMA_MINALIGN));
 
 	return 0;
 }
@@ -151,12 +153,12 @@ static u16 nvme_read_completion_status(struct nvme_queue *nvmeq, u16 index)
 }
 
 /**
- * nvme_submit_cmd() - copy a command into a queue and ring the doorbell
+ * nvme_queue_cmd() - copy a command into a queue, without ringing the doorbell
  *
  * @nvmeq:	The queue to use
  * @cmd:	The command to send
  */
-static void nvme_submit_cmd(struct nvme_queue *nvmeq, struct nvme_command *cmd)
+static void nvme_queue_cmd(struct nvme_queue *nvmeq, struct nvme_command *cmd)
 {
 	u16 tail = nvmeq->sq_tail;
 
@@ -166,10 +168,21 @@ static void nvme_submit_cmd(struct nvme_queue *nvmeq, struct nvme_command *cmd)
 
 	if (++tail == nvmeq->q_depth)
 		tail = 0;
-	writel(tail, nvmeq->q_db);
 	nvmeq->sq_tail = tail;
 }
 
+/**
+ * nvme_submit_cmd() - copy a command into a queue and ring the doorbell
+ *
+ * @nvmeq:	The queue to use
+ * @cmd:	The command to send
+ */
+static void nvme_submit_cmd(struct nvme_queue *nvmeq, struct nvme_command *cmd)
+{
+	nvme_queue_cmd(nvmeq, cmd);
+	writel(nvmeq->sq_tail, nvmeq->q_db);
+}
+
 static int nvme_submit_sync_cmd(struct nvme_queue *nvmeq,
 				struct nvme_command *cmd,
 				u32 *result, unsigned timeout)
@@ -310,6 +323,9 @@ static int nvme_disable_ctrl(struct nvme_dev *dev)
 
 static void nvme_free_queue(struct nvme_queue *nvmeq)
 {
+	if (nvmeq->cmds)
+		free(nvmeq->cmds[0].prp_list);
+	free(nvmeq->cmds);
 	free((void *)nvmeq->cqes);
 	free(nvmeq->sq_cmds);
 	free(nvmeq);
@@ -607,7 +623,8 @@ static int nvme_get_info_from_identify(struct nvme_dev *dev)
 	memcpy(dev->model, ctrl->mn, sizeof(ctrl->mn));
 	memcpy(dev->firmware_rev, ctrl->fr, sizeof(ctrl->fr));
 	if (ctrl->mdts)
-		dev->max_transfer_shift = (ctrl->mdts + shift);
+		dev->max_transfer_shift = min(ctrl->mdts + shift,
+					      MAX_TRANSFER_SHIFT);
 	else {
 		/*
 		 * Maximum Data Transfer Size (MDTS) field indicates the maximum
@@ -625,9 +642,10 @@ static int nvme_get_info_from_identify(struct nvme_dev *dev)
 		 *
 		 * In order for lbas not to overflow, the maximum number is 15
 		 * which means dev->max_transfer_shift = 15 + 9 (ns->lba_shift).
-		 * Let's use 20 which provides 1MB size.
+		 * Let's use 20 which provides 1MB size. Larger commands gain
+		 * little once several of them are queued.
 		 */
-		dev->max_transfer_shift = 20;
+		dev->max_transfer_shift = MAX_TRANSFER_SHIFT;
 	}
 
 	free(ctrl);
@@ -680,6 +698,7 @@ static int nvme_blk_probe(struct udevice *udev)
 
 	memset(ns, 0, sizeof(*ns));
 	ns->dev = ndev;
+	INIT_LIST_HEAD(&ns->reqs);
 	/* extract the namespace id from the block device name */
 	ns->ns_id = trailing_strtol(udev->name) + 1;
 	if (nvme_identify(ndev, ns->ns_id, 0, (dma_addr_t)(long)id)) {
@@ -708,64 +727,299 @@ static int nvme_blk_probe(struct udevice *udev)
 	return 0;
 }
 
-static ulong nvme_blk_rw(struct udevice *udev, lbaint_t blknr,
-			 lbaint_t blkcnt, void *buffer, bool read)
+/*
+ * Give every I/O command slot a PRP list for the largest command. A queue
+ * of depth n holds at most n - 1 commands.
+ */
+static int nvme_alloc_io_cmds(struct nvme_dev *dev)
+{
+	struct nvme_queue *nvmeq = dev->queues[NVME_IO_Q];
+	u32 page_size = dev->page_size;
+	u32 prps_per_page = (page_size >> 3) - 1;
+	u32 nprps, prp_size;
+	u8 *prp_lists;
+	int i;
+
+	nprps = DIV_ROUND_UP(1 << dev->max_transfer_shift, page_size);
+	prp_size = DIV_ROUND_UP(nprps, prps_per_page) * page_size;
+
+	nvmeq->nr_cmds = nvmeq->q_depth - 1;
+	nvmeq->cmds = calloc(nvmeq->nr_cmds, sizeof(*nvmeq->cmds));
+	if (!nvmeq->cmds)
+		return -ENOMEM;
+
+	prp_lists = memalign(page_size, nvmeq->nr_cmds * prp_size);
+	if (!prp_lists) {
+		free(nvmeq->cmds);
+		nvmeq->cmds = NULL;
+		return -ENOMEM;
+	}
+
+	for (i = 0; i < nvmeq->nr_cmds; i++)
+		nvmeq->cmds[i].prp_list = (u64 *)(prp_lists + i * prp_size);
+
+	return 0;
+}
+
+static struct nvme_io_cmd *nvme_get_io_cmd(struct nvme_queue *nvmeq)
+{
+	int i;
+
+	for (i = 0; i < nvmeq->nr_cmds; i++)
+		if (!nvmeq->cmds[i].busy)
+			return &nvmeq->cmds[i];
+
+	return NULL;
+}
+
+static void nvme_put_io_cmd(struct nvme_io_cmd *cmd, int err)
+{
+	struct blk_req *req = cmd->req;
+
+	cmd->busy = false;
+	cmd->req = NULL;
+	if (!req)
+		return;
+
+	if (err)
+		req->result = err;
+	else if (req->result >= 0)
+		req->result += cmd->blkcnt;
+
+	if (!--req->inflight && req->submitted == req->blkcnt) {
+		req->done = true;
+		cmd->ns->nr_reqs--;
+	}
+}
+
+/*
+ * Every slot is taken by a command which timed out and was not completed
+ * even after being aborted, so the controller is not going to free one.
+ */
+static bool nvme_io_stuck(struct nvme_queue *nvmeq)
+{
+	int i;
+
+	for (i = 0; i < nvmeq->nr_cmds; i++)
+		if (!nvmeq->cmds[i].busy || nvmeq->cmds[i].req)
+			return false;
+
+	return true;
+}
+
+/*
+ * Start commands for the queued requests of a namespace, as long as there
+ * are free command slots. The doorbell is rung once for all of them.
+ */
+static void nvme_io_start(struct nvme_ns *ns)
 {
-	struct nvme_ns *ns = dev_get_priv(udev);
 	struct nvme_dev *dev = ns->dev;
+	struct nvme_queue *nvmeq = dev->queues[NVME_IO_Q];
+	u32 max_lbas = 1 << (dev->max_transfer_shift - ns->lba_shift);
+	u16 tail = nvmeq->sq_tail;
+	struct blk_req *req, *next;
+	struct nvme_io_cmd *cmd;
 	struct nvme_command c;
-	struct blk_desc *desc = dev_get_uclass_platdata(udev);
-	int status;
+	lbaint_t lbas;
 	u64 prp2;
-	u64 total_len = blkcnt << desc->log2blksz;
-	u64 temp_len = total_len;
-
-	u64 slba = blknr;
-	u16 lbas = 1 << (dev->max_transfer_shift - ns->lba_shift);
-	u64 total_lbas = blkcnt;
-
-	flush_dcache_range((unsigned long)buffer,
-			   (unsigned long)buffer + total_len);
-
-	c.rw.opcode = read ? nvme_cmd_read : nvme_cmd_write;
-	c.rw.flags = 0;
-	c.rw.nsid = cpu_to_le32(ns->ns_id);
-	c.rw.control = 0;
-	c.rw.dsmgmt = 0;
-	c.rw.reftag = 0;
-	c.rw.apptag = 0;
-	c.rw.appmask = 0;
-	c.rw.metadata = 0;
-
-	while (total_lbas) {
-		if (total_lbas < lbas) {
-			lbas = (u16)total_lbas;
-			total_lbas = 0;
-		} else {
-			total_lbas -= lbas;
+
+	list_for_each_entry_safe(req, next, &ns->reqs, node) {
+		while (req->submitted < req->blkcnt) {
+			/* Drop the rest of a failed request */
+			if (req->result < 0) {
+				req->submitted = req->blkcnt;
+				break;
+			}
+
+			cmd = nvme_get_io_cmd(nvmeq);
+			if (!cmd) {
+				if (!nvme_io_stuck(nvmeq))
+					goto ring;
+				req->result = -ETIMEDOUT;
+				continue;
+			}
+
+			lbas = min_t(lbaint_t, req->blkcnt - req->submitted,
+				     max_lbas);
+			cmd->buf = req->buffer +
+				   (req->submitted << ns->lba_shift);
+			cmd->len = lbas << ns->lba_shift;
+			if (nvme_setup_prps(dev, cmd->prp_list, &prp2, cmd->len,
+					    (ulong)cmd->buf)) {
+				req->result = -EIO;
+				continue;
+			}
+			flush_dcache_range((ulong)cmd->buf,
+					   (ulong)cmd->buf + cmd->len);
+
+			memset(&c, 0, sizeof(c));
+			c.rw.opcode = req->write ? nvme_cmd_write :
+				      nvme_cmd_read;
+			c.rw.command_id = cpu_to_le16(cmd - nvmeq->cmds);
+			c.rw.nsid = cpu_to_le32(ns->ns_id);
+			c.rw.slba = cpu_to_le64(req->start + req->submitted);
+			c.rw.length = cpu_to_le16(lbas - 1);
+			c.rw.prp1 = cpu_to_le64((ulong)cmd->buf);
+			c.rw.prp2 = cpu_to_le64(prp2);
+
+			cmd->busy = true;
+			cmd->req = req;
+			cmd->ns = ns;
+			cmd->blkcnt = lbas;
+			cmd->start = get_timer(0);
+			req->submitted += lbas;
+			req->inflight++;
+			nvme_queue_cmd(nvmeq, &c);
 		}
 
-		if (nvme_setup_prps(dev, &prp2,
-				    lbas << ns->lba_shift, (ulong)buffer))
-			return -EIO;
-		c.rw.slba = cpu_to_le64(slba);
-		slba += lbas;
-		c.rw.length = cpu_to_le16(lbas - 1);
-		c.rw.prp1 = cpu_to_le64((ulong)buffer);
-		c.rw.prp2 = cpu_to_le64(prp2);
-		status = nvme_submit_sync_cmd(dev->queues[NVME_IO_Q],
-				&c, NULL, IO_TIMEOUT);
-		if (status)
+		list_del(&req->node);
+		if (!req->inflight) {
+			req->done = true;
+			ns->nr_reqs--;
+		}
+	}
+
+ring:
+	if (nvmeq->sq_tail != tail)
+		writel(nvmeq->sq_tail, nvmeq->q_db);
+}
+
+static void nvme_io_abort(struct nvme_queue *nvmeq, u16 cid)
+{
+	struct nvme_command c;
+
+	memset(&c, 0, sizeof(c));
+	c.abort.opcode = nvme_admin_abort_cmd;
+	c.abort.sqid = cpu_to_le16(nvmeq->qid);
+	c.abort.cid = cpu_to_le16(cid);
+
+	if (nvme_submit_admin_cmd(nvmeq->dev, &c, NULL))
+		printf("ERROR: abort failed, cid = %d\n", cid);
+}
+
+/*
+ * Reap the completions of the I/O queue. Commands of every namespace are
+ * completed, their requests are done once all their commands are.
+ */
+static void nvme_io_reap(struct nvme_queue *nvmeq)
+{
+	u16 head = nvmeq->cq_head;
+	u16 phase = nvmeq->cq_phase;
+	struct nvme_io_cmd *cmd;
+	u16 status, cid;
+	int i;
+
+	for (;;) {
+		status = nvme_read_completion_status(nvmeq, head);
+		if ((status & 0x01) != phase)
 			break;
-		temp_len -= (u32)lbas << ns->lba_shift;
-		buffer += lbas << ns->lba_shift;
+
+		cid = le16_to_cpu(readw(&nvmeq->cqes[head].command_id));
+		status >>= 1;
+		if (cid < nvmeq->nr_cmds && nvmeq->cmds[cid].busy) {
+			cmd = &nvmeq->cmds[cid];
+			if (status)
+				printf("ERROR: status = %x, cid = %d\n", status,
+				       cid);
+			else if (cmd->req && !cmd->req->write)
+				invalidate_dcache_range((ulong)cmd->buf,
+							(ulong)cmd->buf +
+							cmd->len);
+			nvme_put_io_cmd(cmd, status ? -EIO : 0);
+		}
+
+		if (++head == nvmeq->q_depth) {
+			head = 0;
+			phase = !phase;
+		}
 	}
 
-	if (read)
-		invalidate_dcache_range((unsigned long)buffer,
-					(unsigned long)buffer + total_len);
+	if (head != nvmeq->cq_head || phase != nvmeq->cq_phase) {
+		writel(head, nvmeq->q_db + nvmeq->dev->db_stride);
+		nvmeq->cq_head = head;
+		nvmeq->cq_phase = phase;
+	}
 
-	return (total_len - temp_len) >> desc->log2blksz;
+	/*
+	 * Give up on commands taking too long and ask the controller to abort
+	 * them. Their slots stay busy, without a request, until the controller
+	 * completes them, which frees the slot above.
+	 */
+	for (i = 0; i < nvmeq->nr_cmds; i++) {
+		cmd = &nvmeq->cmds[i];
+		if (cmd->busy && cmd->req &&
+		    get_timer(cmd->start) > IO_TIMEOUT * 1000) {
+			printf("ERROR: timeout, cid = %d\n", i);
+			nvme_put_io_cmd(cmd, -ETIMEDOUT);
+			cmd->busy = true;
+			nvme_io_abort(nvmeq, i);
+		}
+	}
+}
+
+static int nvme_blk_submit(struct udevice *udev, struct blk_req *req)
+{
+	struct nvme_ns *ns = dev_get_priv(udev);
+	struct nvme_queue *nvmeq = ns->dev->queues[NVME_IO_Q];
+
+	if (!nvmeq || !nvmeq->cmds)
+		return -ENODEV;
+
+	list_add_tail(&req->node, &ns->reqs);
+	ns->nr_reqs++;
+	nvme_io_start(ns);
+
+	return 0;
+}
+
+static int nvme_blk_poll(struct udevice *udev)
+{
+	struct nvme_ns *ns = dev_get_priv(udev);
+
+	nvme_io_reap(ns->dev->queues[NVME_IO_Q]);
+	nvme_io_start(ns);
+
+	return ns->nr_reqs;
+}
+
+static void nvme_blk_cancel(struct udevice *udev, struct blk_req *req)
+{
+	struct nvme_ns *ns = dev_get_priv(udev);
+	struct nvme_queue *nvmeq = ns->dev->queues[NVME_IO_Q];
+	struct blk_req *r;
+	int i;
+
+	list_for_each_entry(r, &ns->reqs, node) {
+		if (r == req) {
+			list_del(&req->node);
+			break;
+		}
+	}
+
+	/* Commands still running complete into an abandoned slot */
+	for (i = 0; i < nvmeq->nr_cmds; i++)
+		if (nvmeq->cmds[i].req == req)
+			nvmeq->cmds[i].req = NULL;
+
+	ns->nr_reqs--;
+}
+
+static ulong nvme_blk_rw(struct udevice *udev, lbaint_t blknr,
+			 lbaint_t blkcnt, void *buffer, bool read)
+{
+	struct blk_req req = {
+		.write = !read,
+		.start = blknr,
+		.blkcnt = blkcnt,
+		.buffer = buffer,
+	};
+	int ret;
+
+	ret = blk_submit(udev, &req);
+	if (ret)
+		return ret;
+
+	return blk_wait(udev, &req);
 }
 
 static ulong nvme_blk_read(struct udevice *udev, lbaint_t blknr,
@@ -783,6 +1037,9 @@ static ulong nvme_blk_write(struct udevice *udev, lbaint_t blknr,
 static const struct blk_ops nvme_blk_ops = {
 	.read	= nvme_blk_read,
 	.write	= nvme_blk_write,
+	.submit	= nvme_blk_submit,
+	.poll	= nvme_blk_poll,
+	.cancel	= nvme_blk_cancel,
 };
 
 U_BOOT_DRIVER(nvme_blk) = {
@@ -836,21 +1093,16 @@ static int nvme_probe(struct udevice *udev)
 	if (ret)
 		goto free_queue;
 
-	/* Allocate after the page size is known */
-	ndev->prp_pool = memalign(ndev->page_size, MAX_PRP_POOL);
-	if (!ndev->prp_pool) {
-		ret = -ENOMEM;
-		printf("Error: %s: Out of memory!\n", udev->name);
-		goto free_nvme;
-	}
-	ndev->prp_entry_num = MAX_PRP_POOL >> 3;
-
 	ret = nvme_setup_io_queues(ndev);
 	if (ret)
 		goto free_queue;
 
 	nvme_get_info_from_identify(ndev);
 
+	/* Allocate once the page size and the transfer size are known */
+	if (ndev->queues[NVME_IO_Q] && nvme_alloc_io_cmds(ndev))
+		printf("Error: %s: Out of memory!\n", udev->name);
+
 	return 0;
 
 free_queue:
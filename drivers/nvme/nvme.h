@@ -624,8 +624,6 @@ struct nvme_dev {
 	u32 stripe_size;
 	u32 page_size;
 	u8 vwc;
-	u64 *prp_pool;
-	u32 prp_entry_num;
 	u32 nn;
 };
 
@@ -643,6 +641,8 @@ struct nvme_ns {
 	u8 flbas;
 	u64 mode_select_num_blocks;
 	u32 mode_select_block_len;
+	struct list_head reqs;
+	int nr_reqs;
 };
 
 #endif /* __DRIVER_NVME_H__ */
@@ -53,36 +53,6 @@ static void scsi_print_error(struct scsi_cmd *pccb)
 	/* Dummy function that could print an error for debugging */
 }
 
-#ifdef CONFIG_SYS_64BIT_LBA
-void scsi_setup_read16(struct scsi_cmd *pccb, lbaint_t start,
-		       unsigned long blocks)
-{
-	pccb->cmd[0] = SCSI_READ16;
-	pccb->cmd[1] = pccb->lun << 5;
-	pccb->cmd[2] = (unsigned char)(start >> 56) & 0xff;
-	pccb->cmd[3] = (unsigned char)(start >> 48) & 0xff;
-	pccb->cmd[4] = (unsigned char)(start >> 40) & 0xff;
-	pccb->cmd[5] = (unsigned char)(start >> 32) & 0xff;
-	pccb->cmd[6] = (unsigned char)(start >> 24) & 0xff;
-	pccb->cmd[7] = (unsigned char)(start >> 16) & 0xff;
-	pccb->cmd[8] = (unsigned char)(start >> 8) & 0xff;
-	pccb->cmd[9] = (unsigned char)start & 0xff;
-	pccb->cmd[10] = 0;
-	pccb->cmd[11] = (unsigned char)(blocks >> 24) & 0xff;
-	pccb->cmd[12] = (unsigned char)(blocks >> 16) & 0xff;
-	pccb->cmd[13] = (unsigned char)(blocks >> 8) & 0xff;
-	pccb->cmd[14] = (unsigned char)blocks & 0xff;
-	pccb->cmd[15] = 0;
-	pccb->cmdlen = 16;
-	pccb->msgout[0] = SCSI_IDENTIFY; /* NOT USED */
-	debug("scsi_setup_read16: cmd: %02X %02X startblk %02X%02X%02X%02X%02X%02X%02X%02X blccnt %02X%02X%02X%02X\n",
-	      pccb->cmd[0], pccb->cmd[1],
-	      pccb->cmd[2], pccb->cmd[3], pccb->cmd[4], pccb->cmd[5],
-	      pccb->cmd[6], pccb->cmd[7], pccb->cmd[8], pccb->cmd[9],
-	      pccb->cmd[11], pccb->cmd[12], pccb->cmd[13], pccb->cmd[14]);
-}
-#endif
-
 static void scsi_setup_inquiry(struct scsi_cmd *pccb)
 {
 	pccb->cmd[0] = SCSI_INQUIRY;
@@ -142,15 +112,53 @@ static void scsi_setup_write_ext(struct scsi_cmd *pccb, lbaint_t start,
 	      pccb->cmd[7], pccb->cmd[8]);
 }
 
+/*
+ * READ(16)/WRITE(16) are used when the LBA does not fit READ(10) or when the
+ * controller takes more than SCSI_MAX_BLK blocks per request.
+ */
+static bool scsi_need_ext16(lbaint_t start, lbaint_t blocks)
+{
+	return start > SCSI_LBA48_READ || blocks > SCSI_MAX_BLK;
+}
+
+static void scsi_setup_ext16(struct scsi_cmd *pccb, unsigned char opcode,
+			     lbaint_t start, unsigned long blocks)
+{
+	u64 lba = start;
+
+	pccb->cmd[0] = opcode;
+	pccb->cmd[1] = pccb->lun << 5;
+	pccb->cmd[2] = (unsigned char)(lba >> 56) & 0xff;
+	pccb->cmd[3] = (unsigned char)(lba >> 48) & 0xff;
+	pccb->cmd[4] = (unsigned char)(lba >> 40) & 0xff;
+	pccb->cmd[5] = (unsigned char)(lba >> 32) & 0xff;
+	pccb->cmd[6] = (unsigned char)(lba >> 24) & 0xff;
+	pccb->cmd[7] = (unsigned char)(lba >> 16) & 0xff;
+	pccb->cmd[8] = (unsigned char)(lba >> 8) & 0xff;
+	pccb->cmd[9] = (unsigned char)lba & 0xff;
+	pccb->cmd[10] = (unsigned char)(blocks >> 24) & 0xff;
+	pccb->cmd[11] = (unsigned char)(blocks >> 16) & 0xff;
+	pccb->cmd[12] = (unsigned char)(blocks >> 8) & 0xff;
+	pccb->cmd[13] = (unsigned char)blocks & 0xff;
+	pccb->cmd[14] = 0;
+	pccb->cmd[15] = 0;
+	pccb->cmdlen = 16;
+	pccb->msgout[0] = SCSI_IDENTIFY; /* NOT USED */
+	debug("%s: cmd: %02X %02X startblk %02X%02X%02X%02X%02X%02X%02X%02X blccnt %02X%02X%02X%02X\n",
+	      __func__, pccb->cmd[0], pccb->cmd[1],
+	      pccb->cmd[2], pccb->cmd[3], pccb->cmd[4], pccb->cmd[5],
+	      pccb->cmd[6], pccb->cmd[7], pccb->cmd[8], pccb->cmd[9],
+	      pccb->cmd[10], pccb->cmd[11], pccb->cmd[12], pccb->cmd[13]);
+}
+
 static ulong scsi_read(struct udevice *dev, lbaint_t blknr, lbaint_t blkcnt,
 		       void *buffer)
 {
 	struct blk_desc *block_dev = dev_get_uclass_platdata(dev);
 	struct udevice *bdev = dev->parent;
 	struct scsi_platdata *uc_plat = dev_get_uclass_platdata(bdev);
-	lbaint_t start, blks, max_blks;
+	lbaint_t start, blks, max_blks, blocks = 0;
 	uintptr_t buf_addr;
-	unsigned short smallblks = 0;
 	struct scsi_cmd *pccb = (struct scsi_cmd *)&tempccb;
 
 	/* Setup device */
@@ -170,32 +178,17 @@ static ulong scsi_read(struct udevice *dev, lbaint_t blknr, lbaint_t blkcnt,
 	do {
 		pccb->pdata = (unsigned char *)buf_addr;
 		pccb->dma_dir = DMA_FROM_DEVICE;
-#ifdef CONFIG_SYS_64BIT_LBA
-		if (start > SCSI_LBA48_READ) {
-			unsigned long blocks;
-			blocks = min_t(lbaint_t, blks, max_blks);
-			pccb->datalen = block_dev->blksz * blocks;
-			scsi_setup_read16(pccb, start, blocks);
-			start += blocks;
-			blks -= blocks;
-		} else
-#endif
-		if (blks > max_blks) {
-			pccb->datalen = block_dev->blksz * max_blks;
-			smallblks = max_blks;
-			scsi_setup_read_ext(pccb, start, smallblks);
-			start += max_blks;
-			blks -= max_blks;
-		} else {
-			pccb->datalen = block_dev->blksz * blks;
-			smallblks = (unsigned short)blks;
-			scsi_setup_read_ext(pccb, start, smallblks);
-			start += blks;
-			blks = 0;
-		}
+		blocks = min(blks, max_blks);
+		pccb->datalen = block_dev->blksz * blocks;
+		if (scsi_need_ext16(start, blocks))
+			scsi_setup_ext16(pccb, SCSI_READ16, start, blocks);
+		else
+			scsi_setup_read_ext(pccb, start, blocks);
+		start += blocks;
+		blks -= blocks;
 		debug("scsi_read_ext: startblk " LBAF
-		      ", blccnt %x buffer %lX\n",
-		      start, smallblks, buf_addr);
+		      ", blccnt " LBAF " buffer %lX\n",
+		      start, blocks, buf_addr);
 		if (scsi_exec(bdev, pccb)) {
 			scsi_print_error(pccb);
 			blkcnt -= blks;
@@ -204,7 +197,7 @@ static ulong scsi_read(struct udevice *dev, lbaint_t blknr, lbaint_t blkcnt,
 		buf_addr += pccb->datalen;
 	} while (blks != 0);
 	debug("scsi_read_ext: end startblk " LBAF
-	      ", blccnt %x buffer %lX\n", start, smallblks, buf_addr);
+	      ", blccnt " LBAF " buffer %lX\n", start, blocks, buf_addr);
 	return blkcnt;
 }
 
@@ -218,9 +211,8 @@ static ulong scsi_write(struct udevice *dev, lbaint_t blknr, lbaint_t blkcnt,
 	struct blk_desc *block_dev = dev_get_uclass_platdata(dev);
 	struct udevice *bdev = dev->parent;
 	struct scsi_platdata *uc_plat = dev_get_uclass_platdata(bdev);
-	lbaint_t start, blks, max_blks;
+	lbaint_t start, blks, max_blks, blocks = 0;
 	uintptr_t buf_addr;
-	unsigned short smallblks;
 	struct scsi_cmd *pccb = (struct scsi_cmd *)&tempccb;
 
 	/* Setup device */
@@ -239,21 +231,16 @@ static ulong scsi_write(struct udevice *dev, lbaint_t blknr, lbaint_t blkcnt,
 	do {
 		pccb->pdata = (unsigned char *)buf_addr;
 		pccb->dma_dir = DMA_TO_DEVICE;
-		if (blks > max_blks) {
-			pccb->datalen = block_dev->blksz * max_blks;
-			smallblks = max_blks;
-			scsi_setup_write_ext(pccb, start, smallblks);
-			start += max_blks;
-			blks -= max_blks;
-		} else {
-			pccb->datalen = block_dev->blksz * blks;
-			smallblks = (unsigned short)blks;
-			scsi_setup_write_ext(pccb, start, smallblks);
-			start += blks;
-			blks = 0;
-		}
-		debug("%s: startblk " LBAF ", blccnt %x buffer %lx\n",
-		      __func__, start, smallblks, buf_addr);
+		blocks = min(blks, max_blks);
+		pccb->datalen = block_dev->blksz * blocks;
+		if (scsi_need_ext16(start, blocks))
+			scsi_setup_ext16(pccb, SCSI_WRITE16, start, blocks);
+		else
+			scsi_setup_write_ext(pccb, start, blocks);
+		start += blocks;
+		blks -= blocks;
+		debug("%s: startblk " LBAF ", blccnt " LBAF " buffer %lx\n",
+		      __func__, start, blocks, buf_addr);
 		if (scsi_exec(bdev, pccb)) {
 			scsi_print_error(pccb);
 			blkcnt -= blks;
@@ -261,8 +248,8 @@ static ulong scsi_write(struct udevice *dev, lbaint_t blknr, lbaint_t blkcnt,
 		}
 		buf_addr += pccb->datalen;
 	} while (blks != 0);
-	debug("%s: end startblk " LBAF ", blccnt %x buffer %lX\n",
-	      __func__, start, smallblks, buf_addr);
+	debug("%s: end startblk " LBAF ", blccnt " LBAF " buffer %lX\n",
+	      __func__, start, blocks, buf_addr);
 	return blkcnt;
 }
 #endif
@@ -624,6 +611,7 @@ int scsi_scan(bool verbose)
 {
 	struct uclass *uc;
 	struct udevice *dev; /* SCSI controller */
+	ulong start;
 	int ret;
 
 	if (verbose)
@@ -635,13 +623,18 @@ int scsi_scan(bool verbose)
 	if (ret)
 		return ret;
 
+	start = get_timer(0);
+	bootstage_start(BOOTSTAGE_ID_ACCUM_SCSI, "scsi");
 	uclass_foreach_dev(dev, uc) {
 		ret = scsi_scan_dev(dev, verbose);
 		if (ret)
-			return ret;
+			break;
 	}
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_SCSI);
+	if (verbose)
+		printf("scan took %lu ms\n", get_timer(start));
 
-	return 0;
+	return ret;
 }
 #else
 int scsi_scan(bool verbose)
@@ -9,22 +9,49 @@
 #include <dm.h>
 #include <malloc.h>
 #include <spi.h>
+#include <spi-mem.h>
 #include <clk.h>
 #include <wait_bit.h>
 #include <asm/io.h>
+#include <asm/unaligned.h>
 #include <dm/device_compat.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
+/* ctrl register */
 #define MVEBU_SPI_A3700_XFER_RDY		BIT(1)
-#define MVEBU_SPI_A3700_FIFO_FLUSH		BIT(9)
+#define MVEBU_SPI_A3700_RFIFO_RDY		BIT(2)
+#define MVEBU_SPI_A3700_WFIFO_RDY		BIT(3)
+#define MVEBU_SPI_A3700_RFIFO_EMPTY		BIT(4)
+#define MVEBU_SPI_A3700_WFIFO_EMPTY		BIT(6)
+#define MVEBU_SPI_A3700_WFIFO_FULL		BIT(7)
+#define MVEBU_SPI_A3700_SPI_EN_0		BIT(16)
+
+/* cfg register */
+#define MVEBU_SPI_A3700_CLK_PRESCALE_MASK	0x1f
 #define MVEBU_SPI_A3700_BYTE_LEN		BIT(5)
 #define MVEBU_SPI_A3700_CLK_PHA			BIT(6)
 #define MVEBU_SPI_A3700_CLK_POL			BIT(7)
+#define MVEBU_SPI_A3700_RW_EN			BIT(8)
+#define MVEBU_SPI_A3700_FIFO_FLUSH		BIT(9)
+#define MVEBU_SPI_A3700_DATA_PIN0		BIT(10)
+#define MVEBU_SPI_A3700_DATA_PIN1		BIT(11)
+#define MVEBU_SPI_A3700_ADDR_PIN		BIT(12)
+#define MVEBU_SPI_A3700_INST_PIN		BIT(13)
+#define MVEBU_SPI_A3700_XFER_STOP		BIT(14)
+#define MVEBU_SPI_A3700_XFER_START		BIT(15)
 #define MVEBU_SPI_A3700_FIFO_EN			BIT(17)
-#define MVEBU_SPI_A3700_SPI_EN_0		BIT(16)
-#define MVEBU_SPI_A3700_CLK_PRESCALE_MASK	0x1f
+#define MVEBU_SPI_A3700_RFIFO_THRS_SHIFT	24
+#define MVEBU_SPI_A3700_WFIFO_THRS_SHIFT	28
+#define MVEBU_SPI_A3700_FIFO_THRS_MASK		0x7
+
+/* hdr_cnt register */
+#define MVEBU_SPI_A3700_INSTR_CNT_SHIFT		0
+#define MVEBU_SPI_A3700_ADDR_CNT_SHIFT		4
+#define MVEBU_SPI_A3700_DUMMY_CNT_SHIFT		12
+#define MVEBU_SPI_A3700_DUMMY_CNT_MAX		7
 
+#define MVEBU_SPI_A3700_TIMEOUT_MS		100
 
 /* SPI registers */
 struct spi_reg {
@@ -32,6 +59,11 @@ struct spi_reg {
 	u32 cfg;	/* 0x10604 */
 	u32 dout;	/* 0x10608 */
 	u32 din;	/* 0x1060c */
+	u32 inst;	/* 0x10610 */
+	u32 addr;	/* 0x10614 */
+	u32 rmode;	/* 0x10618 */
+	u32 hdr_cnt;	/* 0x1061c */
+	u32 din_cnt;	/* 0x10620 */
 };
 
 struct mvebu_spi_platdata {
@@ -173,6 +205,231 @@ static int mvebu_spi_xfer(struct udevice *dev, unsigned int bitlen,
 	return 0;
 }
 
+static int mvebu_spi_fifo_flush(struct spi_reg *reg)
+{
+	setbits_le32(&reg->cfg, MVEBU_SPI_A3700_FIFO_FLUSH);
+
+	return wait_for_bit_le32(&reg->cfg, MVEBU_SPI_A3700_FIFO_FLUSH,
+				 false, 1000, false);
+}
+
+/*
+ * Switch between the legacy mode used by mvebu_spi_xfer(), which shifts one
+ * byte per register access on a single data line, and the FIFO mode used for
+ * spi-mem operations, which moves 4 bytes per access and sends the command,
+ * address and dummy bytes from the header registers.
+ */
+static void mvebu_spi_set_fifo_mode(struct spi_reg *reg, bool enable)
+{
+	u32 data = readl(&reg->cfg);
+
+	data &= ~(MVEBU_SPI_A3700_FIFO_EN | MVEBU_SPI_A3700_BYTE_LEN |
+		  MVEBU_SPI_A3700_DATA_PIN0 | MVEBU_SPI_A3700_DATA_PIN1 |
+		  MVEBU_SPI_A3700_ADDR_PIN | MVEBU_SPI_A3700_INST_PIN |
+		  MVEBU_SPI_A3700_RW_EN);
+	data &= ~(MVEBU_SPI_A3700_FIFO_THRS_MASK <<
+		  MVEBU_SPI_A3700_RFIFO_THRS_SHIFT);
+	data &= ~(MVEBU_SPI_A3700_FIFO_THRS_MASK <<
+		  MVEBU_SPI_A3700_WFIFO_THRS_SHIFT);
+	if (enable) {
+		data |= MVEBU_SPI_A3700_FIFO_EN | MVEBU_SPI_A3700_BYTE_LEN;
+		/* Signal as soon as one word can be read or written */
+		data |= 6 << MVEBU_SPI_A3700_WFIFO_THRS_SHIFT;
+	}
+
+	writel(data, &reg->cfg);
+}
+
+static int mvebu_spi_wait_ctrl(struct spi_reg *reg, u32 bit)
+{
+	return wait_for_bit_le32(&reg->ctrl, bit, true,
+				 MVEBU_SPI_A3700_TIMEOUT_MS, false);
+}
+
+static int mvebu_spi_fifo_read(struct spi_reg *reg, u8 *buf, unsigned int len)
+{
+	u32 val;
+	int ret;
+
+	while (len) {
+		ret = mvebu_spi_wait_ctrl(reg, MVEBU_SPI_A3700_RFIFO_RDY);
+		if (ret)
+			return ret;
+
+		while (len && !(readl(&reg->ctrl) &
+				MVEBU_SPI_A3700_RFIFO_EMPTY)) {
+			val = le32_to_cpu(readl(&reg->din));
+			if (len >= 4) {
+				put_unaligned(val, (u32 *)buf);
+				buf += 4;
+				len -= 4;
+				continue;
+			}
+			/* Last partial word */
+			while (len) {
+				*buf++ = val & 0xff;
+				val >>= 8;
+				len--;
+			}
+		}
+	}
+
+	return 0;
+}
+
+static int mvebu_spi_fifo_write(struct spi_reg *reg, const u8 *buf,
+				unsigned int len)
+{
+	int ret;
+
+	while (len) {
+		ret = mvebu_spi_wait_ctrl(reg, MVEBU_SPI_A3700_WFIFO_RDY);
+		if (ret)
+			return ret;
+
+		while (len && !(readl(&reg->ctrl) &
+				MVEBU_SPI_A3700_WFIFO_FULL)) {
+			writel(cpu_to_le32(get_unaligned((u32 *)buf)),
+			       &reg->dout);
+			buf += 4;
+			len -= 4;
+		}
+	}
+
+	return mvebu_spi_wait_ctrl(reg, MVEBU_SPI_A3700_WFIFO_EMPTY);
+}
+
+static u32 mvebu_spi_data_pins(u8 buswidth)
+{
+	switch (buswidth) {
+	case 2:
+		return MVEBU_SPI_A3700_DATA_PIN0;
+	case 4:
+		return MVEBU_SPI_A3700_DATA_PIN1;
+	default:
+		return 0;
+	}
+}
+
+static bool mvebu_spi_mem_supports_op(struct spi_slave *slave,
+				      const struct spi_mem_op *op)
+{
+	if (!spi_mem_default_supports_op(slave, op))
+		return false;
+
+	/* Single line ops can always fall back to mvebu_spi_xfer() */
+	if (op->cmd.buswidth == 1 &&
+	    (!op->addr.nbytes || op->addr.buswidth == 1) &&
+	    (!op->dummy.nbytes || op->dummy.buswidth == 1) &&
+	    (!op->data.nbytes || op->data.buswidth == 1))
+		return true;
+
+	/*
+	 * Multi line ops need the FIFO mode: the address and dummy bytes go
+	 * out on one line or on the data lines, and writes in whole words.
+	 */
+	if (op->cmd.buswidth != 1 || op->addr.nbytes > 4 ||
+	    op->dummy.nbytes > MVEBU_SPI_A3700_DUMMY_CNT_MAX)
+		return false;
+	if (op->addr.nbytes && op->addr.buswidth != 1 &&
+	    op->addr.buswidth != op->data.buswidth)
+		return false;
+	if (op->dummy.nbytes && op->addr.nbytes &&
+	    op->dummy.buswidth != op->addr.buswidth)
+		return false;
+	if (op->data.dir == SPI_MEM_DATA_OUT && op->data.nbytes % 4)
+		return false;
+
+	return true;
+}
+
+static int mvebu_spi_mem_exec_op(struct spi_slave *slave,
+				 const struct spi_mem_op *op)
+{
+	struct udevice *bus = slave->dev->parent;
+	struct mvebu_spi_platdata *plat = dev_get_platdata(bus);
+	struct spi_reg *reg = plat->spireg;
+	int cs = spi_chip_select(slave->dev);
+	unsigned int len = op->data.nbytes;
+	u32 cfg, hdr;
+	int ret, ret2;
+
+	/*
+	 * Header counters cover up to 4 address and 7 dummy bytes, and data
+	 * is written in whole words; leave anything else to the byte path.
+	 */
+	if (op->addr.nbytes > 4 ||
+	    op->dummy.nbytes > MVEBU_SPI_A3700_DUMMY_CNT_MAX ||
+	    (op->data.dir == SPI_MEM_DATA_OUT && len % 4))
+		return -ENOTSUPP;
+
+	mvebu_spi_set_fifo_mode(reg, true);
+	ret = mvebu_spi_fifo_flush(reg);
+	if (ret)
+		goto out;
+
+	writel(op->cmd.opcode, &reg->inst);
+	writel(op->addr.val, &reg->addr);
+	writel(0, &reg->rmode);
+	hdr = 1 << MVEBU_SPI_A3700_INSTR_CNT_SHIFT;
+	hdr |= op->addr.nbytes << MVEBU_SPI_A3700_ADDR_CNT_SHIFT;
+	hdr |= op->dummy.nbytes << MVEBU_SPI_A3700_DUMMY_CNT_SHIFT;
+	writel(hdr, &reg->hdr_cnt);
+
+	cfg = readl(&reg->cfg);
+	if (len)
+		cfg |= mvebu_spi_data_pins(op->data.buswidth);
+	if (op->addr.nbytes && op->addr.buswidth > 1)
+		cfg |= MVEBU_SPI_A3700_ADDR_PIN;
+
+	spi_cs_activate(reg, cs);
+
+	if (op->data.dir == SPI_MEM_DATA_IN && len) {
+		/* The write FIFO is shifted out during reads, clear it */
+		writel(0, &reg->dout);
+		writel(len, &reg->din_cnt);
+		cfg &= ~MVEBU_SPI_A3700_RW_EN;
+		writel(cfg | MVEBU_SPI_A3700_XFER_START, &reg->cfg);
+
+		ret = mvebu_spi_fifo_read(reg, op->data.buf.in, len);
+	} else {
+		cfg |= MVEBU_SPI_A3700_RW_EN;
+		writel(cfg | MVEBU_SPI_A3700_XFER_START, &reg->cfg);
+
+		ret = mvebu_spi_fifo_write(reg, op->data.buf.out, len);
+		if (!ret)
+			ret = mvebu_spi_wait_ctrl(reg,
+						  MVEBU_SPI_A3700_XFER_RDY);
+		/* Writes are open ended, reads stop after din_cnt bytes */
+		setbits_le32(&reg->cfg, MVEBU_SPI_A3700_XFER_STOP);
+	}
+
+	ret2 = wait_for_bit_le32(&reg->cfg, MVEBU_SPI_A3700_XFER_START, false,
+				 MVEBU_SPI_A3700_TIMEOUT_MS, false);
+	if (ret2) {
+		/* Abort the transfer */
+		setbits_le32(&reg->cfg, MVEBU_SPI_A3700_XFER_STOP);
+		wait_for_bit_le32(&reg->cfg, MVEBU_SPI_A3700_XFER_START, false,
+				  MVEBU_SPI_A3700_TIMEOUT_MS, false);
+		mvebu_spi_fifo_flush(reg);
+	}
+	clrbits_le32(&reg->cfg, MVEBU_SPI_A3700_XFER_STOP);
+	spi_cs_deactivate(reg, cs);
+	if (!ret)
+		ret = ret2;
+
+out:
+	writel(0, &reg->hdr_cnt);
+	mvebu_spi_set_fifo_mode(reg, false);
+
+	return ret;
+}
+
+static const struct spi_controller_mem_ops mvebu_spi_mem_ops = {
+	.supports_op	= mvebu_spi_mem_supports_op,
+	.exec_op	= mvebu_spi_mem_exec_op,
+};
+
 static int mvebu_spi_set_speed(struct udevice *bus, uint hz)
 {
 	struct mvebu_spi_platdata *plat = dev_get_platdata(bus);
@@ -277,6 +534,7 @@ static const struct dm_spi_ops mvebu_spi_ops = {
 	.xfer		= mvebu_spi_xfer,
 	.set_speed	= mvebu_spi_set_speed,
 	.set_mode	= mvebu_spi_set_mode,
+	.mem_ops	= &mvebu_spi_mem_ops,
 	/*
 	 * cs_info is not needed, since we require all chip selects to be
 	 * in the device tree explicitly
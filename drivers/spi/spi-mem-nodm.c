@@ -104,3 +104,10 @@ int spi_mem_adjust_op_size(struct spi_slave *slave,
 
 	return 0;
 }
+
+bool spi_mem_supports_op(struct spi_slave *slave,
+			 const struct spi_mem_op *op)
+{
+	/* Without DM the bus width is only limited by the SPI mode bits */
+	return true;
+}
@@ -172,7 +172,8 @@
 #define USB_BULK_SEND_TIMEOUT 5000
 #define USB_BULK_RECV_TIMEOUT 5000
 
-#define AX_RX_URB_SIZE 1024 * 0x12
+/* Largest bulk IN transfer of AX88179_BULKIN_SIZE, size + 2 KiB */
+#define AX_RX_URB_SIZE (1024 * 0x1a)
 #define BLK_FRAME_SIZE 0x200
 #define PHY_CONNECT_TIMEOUT 5000
 
@@ -191,10 +192,10 @@
 static const struct {
 	unsigned char ctrl, timer_l, timer_h, size, ifg;
 } AX88179_BULKIN_SIZE[] =	{
-	{7, 0x4f, 0,	0x02, 0xff},
-	{7, 0x20, 3,	0x03, 0xff},
-	{7, 0xae, 7,	0x04, 0xff},
-	{7, 0xcc, 0x4c, 0x04, 8},
+	{7, 0x4f, 0,	0x12, 0xff},
+	{7, 0x20, 3,	0x16, 0xff},
+	{7, 0xae, 7,	0x18, 0xff},
+	{7, 0xcc, 0x4c, 0x18, 8},
 };
 
 #ifndef CONFIG_DM_ETH
@@ -316,7 +317,7 @@ static int asix_basic_reset(struct ueth_data *dev,
 	memcpy(tmp, &AX88179_BULKIN_SIZE[0], 5);
 	asix_write_cmd(dev, AX_ACCESS_MAC, AX_RX_BULKIN_QCTRL, 5, 5, tmp);
 
-	dev_priv->rx_urb_size = 128 * 20;
+	dev_priv->rx_urb_size = 1024 * (AX88179_BULKIN_SIZE[0].size + 2);
 
 	/* Water Level configuration */
 	*tmp = 0x34;
@@ -543,7 +544,7 @@ static int asix_recv(struct eth_device *eth)
 	u32 rx_hdr;
 	u16 hdr_off;
 	u32 *pkt_hdr;
-	ALLOC_CACHE_ALIGN_BUFFER(u8, recv_buf, dev_priv->rx_urb_size);
+	DEFINE_CACHE_ALIGN_BUFFER(u8, recv_buf, AX_RX_URB_SIZE);
 
 	actual_len = -1;
 
@@ -460,6 +460,22 @@ static int rtl8152_enable(struct r8152 *tp)
 	return rtl_enable(tp);
 }
 
+/* Hold received frames for aggregation for at most this long */
+static void r8152_set_coalesce(struct r8152 *tp)
+{
+	switch (tp->udev->speed) {
+	case USB_SPEED_SUPER:
+		tp->coalesce = COALESCE_SUPER;
+		break;
+	case USB_SPEED_HIGH:
+		tp->coalesce = COALESCE_HIGH;
+		break;
+	default:
+		tp->coalesce = COALESCE_SLOW;
+		break;
+	}
+}
+
 static void r8153_set_rx_early_timeout(struct r8152 *tp)
 {
 	u32 ocp_data = tp->coalesce / 8;
@@ -1265,7 +1281,7 @@ static int r8152_recv(struct eth_device *eth)
 {
 	struct ueth_data *dev = (struct ueth_data *)eth->priv;
 
-	ALLOC_CACHE_ALIGN_BUFFER(uint8_t, recv_buf, RTL8152_AGG_BUF_SZ);
+	DEFINE_CACHE_ALIGN_BUFFER(uint8_t, recv_buf, RTL8152_AGG_BUF_SZ);
 	unsigned char *pkt_ptr;
 	int err;
 	int actual_len;
@@ -1435,6 +1451,7 @@ int r8152_eth_probe(struct usb_device *dev, unsigned int ifnum,
 	tp->intf = iface;
 
 	r8152b_get_version(tp);
+	r8152_set_coalesce(tp);
 
 	if (rtl_ops_init(tp))
 		return 0;
@@ -1590,6 +1607,7 @@ static int r8152_eth_probe(struct udevice *dev)
 	r8152_read_mac(tp, pdata->enetaddr);
 
 	r8152b_get_version(tp);
+	r8152_set_coalesce(tp);
 
 	ret = rtl_ops_init(tp);
 	if (ret)
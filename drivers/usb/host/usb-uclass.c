@@ -7,6 +7,7 @@
  */
 
 #include <common.h>
+#include <bootstage.h>
 #include <dm.h>
 #include <errno.h>
 #include <memalign.h>
@@ -89,6 +90,37 @@ int submit_bulk_msg(struct usb_device *udev, unsigned long pipe, void *buffer,
 	return ops->bulk(bus, udev, pipe, buffer, length);
 }
 
+int submit_bulk_msg_batch(struct usb_device *udev, unsigned long pipe,
+			  struct usb_bulk_xfer *xfers, int count)
+{
+	struct udevice *bus = udev->controller_dev;
+	struct dm_usb_ops *ops = usb_get_ops(bus);
+	int i, ret;
+
+	if (ops->bulk_batch)
+		return ops->bulk_batch(bus, udev, pipe, xfers, count);
+	if (!ops->bulk)
+		return -ENOSYS;
+
+	for (i = 0; i < count; i++) {
+		xfers[i].act_len = 0;
+		xfers[i].status = USB_ST_NOT_PROC;
+	}
+
+	for (i = 0; i < count; i++) {
+		ret = ops->bulk(bus, udev, pipe, xfers[i].buffer,
+				xfers[i].length);
+		if (ret)
+			return ret;
+		xfers[i].act_len = udev->act_len;
+		xfers[i].status = udev->status;
+		if (udev->status)
+			return i < count - 1 ? -EIO : 0;
+	}
+
+	return 0;
+}
+
 struct int_queue *create_int_queue(struct usb_device *udev,
 		unsigned long pipe, int queuesize, int elementsize,
 		void *buffer, int interval)
@@ -212,25 +244,50 @@ int usb_stop(void)
 	return err;
 }
 
-static void usb_scan_bus(struct udevice *bus, bool recurse)
+/*
+ * Scan the buses which are (not) companions. The root hubs of all of them are
+ * powered up first, then their ports are scanned together so that the
+ * power-on and connect delays of the buses overlap.
+ */
+static void usb_scan_buses(struct uclass *uc, bool companion)
 {
 	struct usb_bus_priv *priv;
+	struct udevice *bus;
 	struct udevice *dev;
 	int ret;
 
-	priv = dev_get_uclass_priv(bus);
+	usb_hub_scan_hold(true);
+	uclass_foreach_dev(bus, uc) {
+		if (!device_active(bus))
+			continue;
+		priv = dev_get_uclass_priv(bus);
+		if (priv->companion != companion)
+			continue;
+
+		debug("scanning bus %s\n", bus->name);
+		priv->scan_err = usb_scan_device(bus, 0, USB_SPEED_FULL, &dev);
+	}
+	ret = usb_hub_scan_hold(false);
 
-	assert(recurse);	/* TODO: Support non-recusive */
+	uclass_foreach_dev(bus, uc) {
+		if (!device_active(bus))
+			continue;
+		priv = dev_get_uclass_priv(bus);
+		if (priv->companion != companion)
+			continue;
+
+		printf("scanning bus %s for devices... ", bus->name);
+		if (priv->scan_err)
+			printf("failed, error %d\n", priv->scan_err);
+		else if (priv->next_addr == 0)
+			printf("No USB Device found\n");
+		else
+			printf("%d USB Device(s) found\n", priv->next_addr);
+	}
 
-	printf("scanning bus %s for devices... ", bus->name);
-	debug("\n");
-	ret = usb_scan_device(bus, 0, USB_SPEED_FULL, &dev);
+	/* The ports of all the buses were scanned together */
 	if (ret)
-		printf("failed, error %d\n", ret);
-	else if (priv->next_addr == 0)
-		printf("No USB Device found\n");
-	else
-		printf("%d USB Device(s) found\n", priv->next_addr);
+		printf("scanning hub ports failed, error %d\n", ret);
 }
 
 static void remove_inactive_children(struct uclass *uc, struct udevice *bus)
@@ -251,7 +308,6 @@ int usb_init(void)
 {
 	int controllers_initialized = 0;
 	struct usb_uclass_priv *uc_priv;
-	struct usb_bus_priv *priv;
 	struct udevice *bus;
 	struct uclass *uc;
 	int ret;
@@ -264,6 +320,7 @@ int usb_init(void)
 
 	uc_priv = uc->priv;
 
+	bootstage_start(BOOTSTAGE_ID_ACCUM_USB, "usb");
 	uclass_foreach_dev(bus, uc) {
 		/* init low_level USB */
 		printf("Bus %s: ", bus->name);
@@ -301,32 +358,18 @@ int usb_init(void)
 	 * lowlevel init done, now scan the bus for devices i.e. search HUBs
 	 * and configure them, first scan primary controllers.
 	 */
-	uclass_foreach_dev(bus, uc) {
-		if (!device_active(bus))
-			continue;
-
-		priv = dev_get_uclass_priv(bus);
-		if (!priv->companion)
-			usb_scan_bus(bus, true);
-	}
+	usb_scan_buses(uc, false);
 
 	/*
 	 * Now that the primary controllers have been scanned and have handed
 	 * over any devices they do not understand to their companions, scan
 	 * the companions if necessary.
 	 */
-	if (uc_priv->companion_device_count) {
-		uclass_foreach_dev(bus, uc) {
-			if (!device_active(bus))
-				continue;
-
-			priv = dev_get_uclass_priv(bus);
-			if (priv->companion)
-				usb_scan_bus(bus, true);
-		}
-	}
+	if (uc_priv->companion_device_count)
+		usb_scan_buses(uc, true);
 
 	debug("scan end\n");
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_USB);
 
 	/* Remove any devices that were not found on this scan */
 	remove_inactive_children(uc, bus);
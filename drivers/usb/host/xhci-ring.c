@@ -188,6 +188,10 @@ static struct xhci_generic_trb *queue_trb(struct xhci_ctrl *ctrl,
 
 	trb = &ring->enqueue->generic;
 
+	/* A late event from now on would be for the new TRB */
+	if ((union xhci_trb *)trb == ctrl->late_trb)
+		ctrl->late_trb = NULL;
+
 	for (i = 0; i < 4; i++)
 		trb->field[i] = cpu_to_le32(trb_fields[i]);
 
@@ -444,6 +448,15 @@ union xhci_trb *xhci_wait_for_event(struct xhci_ctrl *ctrl, trb_type expected)
 			continue;
 
 		type = TRB_FIELD_TO_TYPE(le32_to_cpu(event->event_cmd.flags));
+		if (type == TRB_TRANSFER && ctrl->late_trb &&
+		    le64_to_cpu(event->trans_event.buffer) ==
+		    (uintptr_t)ctrl->late_trb) {
+			/* Nobody waits for this one any more */
+			ctrl->late_trb = NULL;
+			xhci_acknowledge_event(ctrl);
+			continue;
+		}
+
 		if (type == expected)
 			return event;
 
@@ -514,90 +527,59 @@ static void abort_td(struct usb_device *udev, int ep_index)
 	xhci_acknowledge_event(ctrl);
 }
 
-static void record_transfer_result(struct usb_device *udev,
-				   union xhci_trb *event, int length)
+/**
+ * Converts the completion code of a transfer event to a USB_ST_... status
+ *
+ * @param event	the transfer event
+ * @return 0 for a (short) successful transfer, else the error status
+ */
+static unsigned long xhci_event_status(union xhci_trb *event)
 {
-	udev->act_len = min(length, length -
-		(int)EVENT_TRB_LEN(le32_to_cpu(event->trans_event.transfer_len)));
-
 	switch (GET_COMP_CODE(le32_to_cpu(event->trans_event.transfer_len))) {
 	case COMP_SUCCESS:
-		BUG_ON(udev->act_len != length);
-		/* fallthrough */
 	case COMP_SHORT_TX:
-		udev->status = 0;
-		break;
+		return 0;
 	case COMP_STALL:
-		udev->status = USB_ST_STALLED;
-		break;
+		return USB_ST_STALLED;
 	case COMP_DB_ERR:
 	case COMP_TRB_ERR:
-		udev->status = USB_ST_BUF_ERR;
-		break;
+		return USB_ST_BUF_ERR;
 	case COMP_BABBLE:
-		udev->status = USB_ST_BABBLE_DET;
-		break;
+		return USB_ST_BABBLE_DET;
 	default:
-		udev->status = 0x80;  /* USB_ST_TOO_LAZY_TO_MAKE_A_NEW_MACRO */
+		return 0x80;  /* USB_ST_TOO_LAZY_TO_MAKE_A_NEW_MACRO */
 	}
 }
 
+static void record_transfer_result(struct usb_device *udev,
+				   union xhci_trb *event, int length)
+{
+	udev->act_len = min(length, length -
+		(int)EVENT_TRB_LEN(le32_to_cpu(event->trans_event.transfer_len)));
+
+	if (GET_COMP_CODE(le32_to_cpu(event->trans_event.transfer_len)) ==
+	    COMP_SUCCESS)
+		BUG_ON(udev->act_len != length);
+
+	udev->status = xhci_event_status(event);
+}
+
 /**** Bulk and Control transfer methods ****/
 /**
- * Queues up the BULK Request
+ * Counts the TRBs of a bulk TD. The buffer of a TRB must not span a 64KB
+ * boundary, so the TD is split at those boundaries.
  *
- * @param udev		pointer to the USB device structure
- * @param pipe		contains the DIR_IN or OUT , devnum
+ * @param buffer	buffer of the TD
  * @param length	length of the buffer
- * @param buffer	buffer to be read/written based on the request
- * @return returns 0 if successful else -1 on failure
+ * @return number of TRBs needed
  */
-int xhci_bulk_tx(struct usb_device *udev, unsigned long pipe,
-			int length, void *buffer)
+static int xhci_bulk_num_trbs(void *buffer, int length)
 {
-	int num_trbs = 0;
-	struct xhci_generic_trb *start_trb;
-	bool first_trb = false;
-	int start_cycle;
-	u32 field = 0;
-	u32 length_field = 0;
-	struct xhci_ctrl *ctrl = xhci_get_ctrl(udev);
-	int slot_id = udev->slot_id;
-	int ep_index;
-	struct xhci_virt_device *virt_dev;
-	struct xhci_ep_ctx *ep_ctx;
-	struct xhci_ring *ring;		/* EP transfer ring */
-	union xhci_trb *event;
-
-	int running_total, trb_buff_len;
-	unsigned int total_packet_count;
-	int maxpacketsize;
-	u64 addr;
-	int ret;
-	u32 trb_fields[4];
 	u64 val_64 = (uintptr_t)buffer;
+	int running_total, num_trbs = 0;
 
-	debug("dev=%p, pipe=%lx, buffer=%p, length=%d\n",
-		udev, pipe, buffer, length);
-
-	ep_index = usb_pipe_ep_index(pipe);
-	virt_dev = ctrl->devs[slot_id];
-
-	xhci_inval_cache((uintptr_t)virt_dev->out_ctx->bytes,
-			 virt_dev->out_ctx->size);
-
-	ep_ctx = xhci_get_ep_ctx(ctrl, virt_dev->out_ctx, ep_index);
-
-	ring = virt_dev->eps[ep_index].ring;
-	/*
-	 * How much data is (potentially) left before the 64KB boundary?
-	 * XHCI Spec puts restriction( TABLE 49 and 6.4.1 section of XHCI Spec)
-	 * that the buffer should not span 64KB boundary. if so
-	 * we send request in more than 1 TRB by chaining them.
-	 */
 	running_total = TRB_MAX_BUFF_SIZE -
 			(lower_32_bits(val_64) & (TRB_MAX_BUFF_SIZE - 1));
-	trb_buff_len = running_total;
 	running_total &= TRB_MAX_BUFF_SIZE - 1;
 
 	/*
@@ -613,23 +595,39 @@ int xhci_bulk_tx(struct usb_device *udev, unsigned long pipe,
 		running_total += TRB_MAX_BUFF_SIZE;
 	}
 
-	/*
-	 * XXX: Calling routine prepare_ring() called in place of
-	 * prepare_trasfer() as there in 'Linux' since we are not
-	 * maintaining multiple TDs/transfer at the same time.
-	 */
-	ret = prepare_ring(ctrl, ring,
-			   le32_to_cpu(ep_ctx->ep_info) & EP_STATE_MASK);
-	if (ret < 0)
-		return ret;
+	return num_trbs;
+}
 
-	/*
-	 * Don't give the first TRB to the hardware (by toggling the cycle bit)
-	 * until we've finished creating all the other TRBs.  The ring's cycle
-	 * state may change as we enqueue the other TRBs, so save it too.
-	 */
-	start_trb = &ring->enqueue->generic;
-	start_cycle = ring->cycle_state;
+/**
+ * Queues the TRBs of a bulk TD on the endpoint ring. The last TRB of the TD
+ * interrupts on completion.
+ *
+ * @param udev		pointer to the USB device structure
+ * @param pipe		contains the DIR_IN or OUT , devnum
+ * @param ring		the endpoint transfer ring
+ * @param length	length of the buffer
+ * @param buffer	buffer to be read/written based on the request
+ * @param hold		don't give the first TRB to the hardware yet, it is
+ *			passed on by giveback_first_trb()
+ * @param more_tds	another TD is queued before ringing the doorbell
+ * @return pointer to the last TRB of the TD
+ */
+static union xhci_trb *xhci_queue_bulk_td(struct usb_device *udev,
+					  unsigned long pipe,
+					  struct xhci_ring *ring, int length,
+					  void *buffer, bool hold,
+					  bool more_tds)
+{
+	struct xhci_ctrl *ctrl = xhci_get_ctrl(udev);
+	int num_trbs = xhci_bulk_num_trbs(buffer, length);
+	unsigned int total_packet_count;
+	int running_total, trb_buff_len;
+	union xhci_trb *trb;
+	u32 length_field;
+	int maxpacketsize;
+	u32 trb_fields[4];
+	u32 field;
+	u64 addr;
 
 	running_total = 0;
 	maxpacketsize = usb_maxpacket(udev, pipe);
@@ -643,13 +641,13 @@ int xhci_bulk_tx(struct usb_device *udev, unsigned long pipe,
 	 * that the buffer should not span 64KB boundary. if so
 	 * we send request in more than 1 TRB by chaining them.
 	 */
-	addr = val_64;
+	addr = (uintptr_t)buffer;
+	trb_buff_len = TRB_MAX_BUFF_SIZE -
+		       (lower_32_bits(addr) & (TRB_MAX_BUFF_SIZE - 1));
 
 	if (trb_buff_len > length)
 		trb_buff_len = length;
 
-	first_trb = true;
-
 	/* flush the buffer before use */
 	xhci_flush_cache((uintptr_t)buffer, length);
 
@@ -658,9 +656,9 @@ int xhci_bulk_tx(struct usb_device *udev, unsigned long pipe,
 		u32 remainder = 0;
 		field = 0;
 		/* Don't change the cycle bit of the first TRB until later */
-		if (first_trb) {
-			first_trb = false;
-			if (start_cycle == 0)
+		if (hold) {
+			hold = false;
+			if (ring->cycle_state == 0)
 				field |= TRB_CYCLE;
 		} else {
 			field |= ring->cycle_state;
@@ -699,7 +697,9 @@ int xhci_bulk_tx(struct usb_device *udev, unsigned long pipe,
 		trb_fields[2] = length_field;
 		trb_fields[3] = field | (TRB_NORMAL << TRB_TYPE_SHIFT);
 
-		queue_trb(ctrl, ring, (num_trbs > 1), trb_fields);
+		trb = (union xhci_trb *)queue_trb(ctrl, ring,
+						  num_trbs > 1 || more_tds,
+						  trb_fields);
 
 		--num_trbs;
 
@@ -710,6 +710,66 @@ int xhci_bulk_tx(struct usb_device *udev, unsigned long pipe,
 		trb_buff_len = min((length - running_total), TRB_MAX_BUFF_SIZE);
 	} while (running_total < length);
 
+	return trb;
+}
+
+/**
+ * Queues up the BULK Request
+ *
+ * @param udev		pointer to the USB device structure
+ * @param pipe		contains the DIR_IN or OUT , devnum
+ * @param length	length of the buffer
+ * @param buffer	buffer to be read/written based on the request
+ * @return returns 0 if successful else -1 on failure
+ */
+int xhci_bulk_tx(struct usb_device *udev, unsigned long pipe,
+			int length, void *buffer)
+{
+	struct xhci_generic_trb *start_trb;
+	int start_cycle;
+	u32 field = 0;
+	struct xhci_ctrl *ctrl = xhci_get_ctrl(udev);
+	int slot_id = udev->slot_id;
+	int ep_index;
+	struct xhci_virt_device *virt_dev;
+	struct xhci_ep_ctx *ep_ctx;
+	struct xhci_ring *ring;		/* EP transfer ring */
+	union xhci_trb *event;
+	int ret;
+
+	debug("dev=%p, pipe=%lx, buffer=%p, length=%d\n",
+		udev, pipe, buffer, length);
+
+	ep_index = usb_pipe_ep_index(pipe);
+	virt_dev = ctrl->devs[slot_id];
+
+	xhci_inval_cache((uintptr_t)virt_dev->out_ctx->bytes,
+			 virt_dev->out_ctx->size);
+
+	ep_ctx = xhci_get_ep_ctx(ctrl, virt_dev->out_ctx, ep_index);
+
+	ring = virt_dev->eps[ep_index].ring;
+
+	/*
+	 * XXX: Calling routine prepare_ring() called in place of
+	 * prepare_trasfer() as there in 'Linux' since we are not
+	 * maintaining multiple TDs/transfer at the same time.
+	 */
+	ret = prepare_ring(ctrl, ring,
+			   le32_to_cpu(ep_ctx->ep_info) & EP_STATE_MASK);
+	if (ret < 0)
+		return ret;
+
+	/*
+	 * Don't give the first TRB to the hardware (by toggling the cycle bit)
+	 * until we've finished creating all the other TRBs.  The ring's cycle
+	 * state may change as we enqueue the other TRBs, so save it too.
+	 */
+	start_trb = &ring->enqueue->generic;
+	start_cycle = ring->cycle_state;
+
+	xhci_queue_bulk_td(udev, pipe, ring, length, buffer, true, false);
+
 	giveback_first_trb(udev, ep_index, start_cycle, start_trb);
 
 	event = xhci_wait_for_event(ctrl, TRB_TRANSFER);
@@ -734,6 +794,173 @@ int xhci_bulk_tx(struct usb_device *udev, unsigned long pipe,
 	return (udev->status != USB_ST_NOT_PROC) ? 0 : -1;
 }
 
+/**
+ * Drops the TDs left on the ring of a halted endpoint. The endpoint is reset
+ * and its dequeue pointer moved to our enqueue pointer, so the next transfer
+ * starts from there.
+ *
+ * @param udev		pointer to the USB device structure
+ * @param ep_index	index of the endpoint
+ * @return none
+ */
+static void xhci_reset_ep_ring(struct usb_device *udev, int ep_index)
+{
+	struct xhci_ctrl *ctrl = xhci_get_ctrl(udev);
+	struct xhci_ring *ring =  ctrl->devs[udev->slot_id]->eps[ep_index].ring;
+	union xhci_trb *event;
+
+	xhci_queue_command(ctrl, NULL, udev->slot_id, ep_index, TRB_RESET_EP);
+	event = xhci_wait_for_event(ctrl, TRB_COMPLETION);
+	BUG_ON(TRB_TO_SLOT_ID(le32_to_cpu(event->event_cmd.flags))
+		!= udev->slot_id || GET_COMP_CODE(le32_to_cpu(
+		event->event_cmd.status)) != COMP_SUCCESS);
+	xhci_acknowledge_event(ctrl);
+
+	xhci_queue_command(ctrl, (void *)((uintptr_t)ring->enqueue |
+		ring->cycle_state), udev->slot_id, ep_index, TRB_SET_DEQ);
+	event = xhci_wait_for_event(ctrl, TRB_COMPLETION);
+	BUG_ON(TRB_TO_SLOT_ID(le32_to_cpu(event->event_cmd.flags))
+		!= udev->slot_id || GET_COMP_CODE(le32_to_cpu(
+		event->event_cmd.status)) != COMP_SUCCESS);
+	xhci_acknowledge_event(ctrl);
+}
+
+/* Is @trb one of the TRBs from @first to @last on a single segment ring? */
+static bool xhci_trb_in_td(union xhci_trb *trb, union xhci_trb *first,
+			   union xhci_trb *last)
+{
+	if (first <= last)
+		return trb >= first && trb <= last;
+
+	return trb >= first || trb <= last;
+}
+
+/**
+ * Queues up several BULK Requests to one endpoint
+ *
+ * All TDs which fit on the endpoint ring are queued before the doorbell is
+ * rung once, then their completions are reaped in order. This saves the
+ * round trip through the driver between back-to-back transfers.
+ *
+ * @param udev		pointer to the USB device structure
+ * @param pipe		contains the DIR_IN or OUT , devnum
+ * @param xfers		the transfers, act_len and status are filled in
+ * @param count		number of transfers
+ * @return 0 if all transfers were processed, else error code. A transfer
+ *	   which was not processed has the status USB_ST_NOT_PROC.
+ */
+int xhci_bulk_tx_batch(struct usb_device *udev, unsigned long pipe,
+		       struct usb_bulk_xfer *xfers, int count)
+{
+	union xhci_trb *first[TRBS_PER_SEGMENT], *last[TRBS_PER_SEGMENT];
+	struct xhci_ctrl *ctrl = xhci_get_ctrl(udev);
+	int ep_index = usb_pipe_ep_index(pipe);
+	struct xhci_virt_device *virt_dev = ctrl->devs[udev->slot_id];
+	struct xhci_ring *ring = virt_dev->eps[ep_index].ring;
+	struct xhci_generic_trb *start_trb;
+	struct usb_bulk_xfer *xfer;
+	struct xhci_ep_ctx *ep_ctx;
+	union xhci_trb *event, *trb;
+	int base, i, n, trbs, num;
+	int start_cycle, ret;
+	u32 field, len;
+	u64 addr;
+
+	for (i = 0; i < count; i++) {
+		xfers[i].act_len = 0;
+		xfers[i].status = USB_ST_NOT_PROC;
+	}
+
+	for (base = 0; base < count; base += n) {
+		xhci_inval_cache((uintptr_t)virt_dev->out_ctx->bytes,
+				 virt_dev->out_ctx->size);
+		ep_ctx = xhci_get_ep_ctx(ctrl, virt_dev->out_ctx, ep_index);
+		ret = prepare_ring(ctrl, ring,
+				   le32_to_cpu(ep_ctx->ep_info) &
+				   EP_STATE_MASK);
+		if (ret < 0)
+			return ret;
+
+		/* Queue as many TDs as the ring holds, 62 TRBs */
+		for (n = 0, trbs = 0; base + n < count; n++) {
+			xfer = &xfers[base + n];
+			num = xhci_bulk_num_trbs(xfer->buffer, xfer->length);
+			if (n && trbs + num > TRBS_PER_SEGMENT - 2)
+				break;
+			trbs += num;
+		}
+
+		start_trb = &ring->enqueue->generic;
+		start_cycle = ring->cycle_state;
+		for (i = 0; i < n; i++) {
+			xfer = &xfers[base + i];
+			first[i] = ring->enqueue;
+			last[i] = xhci_queue_bulk_td(udev, pipe, ring,
+						     xfer->length,
+						     xfer->buffer, !i,
+						     i < n - 1);
+		}
+		giveback_first_trb(udev, ep_index, start_cycle, start_trb);
+
+		for (i = 0; i < n; ) {
+			xfer = &xfers[base + i];
+			event = xhci_wait_for_event(ctrl, TRB_TRANSFER);
+			if (!event) {
+				debug("XHCI bulk batch timed out, aborting...\n");
+				abort_td(udev, ep_index);
+				xfer->status = USB_ST_NAK_REC;
+				return -ETIMEDOUT;
+			}
+			field = le32_to_cpu(event->trans_event.flags);
+			BUG_ON(TRB_TO_SLOT_ID(field) != udev->slot_id);
+			BUG_ON(TRB_TO_EP_INDEX(field) != ep_index);
+
+			/* A late event for a TD which ended short, skip it */
+			trb = (union xhci_trb *)(uintptr_t)
+				le64_to_cpu(event->trans_event.buffer);
+			if (!xhci_trb_in_td(trb, first[i], last[i])) {
+				xhci_acknowledge_event(ctrl);
+				continue;
+			}
+
+			/* The TRBs of a TD follow each other in the buffer */
+			addr = (u64)le32_to_cpu(trb->generic.field[1]) << 32 |
+			       le32_to_cpu(trb->generic.field[0]);
+			len = le32_to_cpu(event->trans_event.transfer_len);
+			len = TRB_LEN(le32_to_cpu(trb->generic.field[2])) -
+			      EVENT_TRB_LEN(len);
+			xfer->act_len = addr - (uintptr_t)xfer->buffer + len;
+			xfer->status = xhci_event_status(event);
+			xhci_acknowledge_event(ctrl);
+			xhci_inval_cache((uintptr_t)xfer->buffer,
+					 xfer->length);
+
+			udev->act_len = xfer->act_len;
+			udev->status = xfer->status;
+			i++;
+			if (!xfer->status)
+				continue;
+
+			/* The endpoint halted, drop the TDs behind this one */
+			if (i < n)
+				xhci_reset_ep_ring(udev, ep_index);
+
+			return base + i < count ? -EIO : 0;
+		}
+
+		/*
+		 * If the last TD ended short before its final TRB, some hosts
+		 * still post an event for that TRB. Have the next wait drop it
+		 * rather than waiting for it here, or taking it as the
+		 * completion of the next transfer.
+		 */
+		if (trb != last[n - 1])
+			ctrl->late_trb = last[n - 1];
+	}
+
+	return 0;
+}
+
 /**
  * Queues up the Control Transfer Request
  *
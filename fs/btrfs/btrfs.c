@@ -210,6 +210,7 @@ int btrfs_read(const char *file, void *buf, loff_t offset, loff_t len,
 void btrfs_close(void)
 {
 	btrfs_chunk_map_exit();
+	btrfs_decompress_exit();
 }
 
 int btrfs_uuid(char *uuid_str)
@@ -48,6 +48,7 @@ int btrfs_read_chunk_tree(void);
 
 /* compression.c */
 u32 btrfs_decompress(u8 type, const char *, u32, char *, u32);
+void btrfs_decompress_exit(void);
 
 /* super.c */
 int btrfs_read_superblock(void);
@@ -78,10 +79,23 @@ u64 btrfs_file_read(const struct btrfs_root *, u64, u64, u64, char *);
 u64 btrfs_get_default_subvol_objectid(void);
 
 /* extent-io.c */
+
+/*
+ * Uncompressed extents which lie back to back on disk are read with one
+ * device request: btrfs_read_extent_reg() only queues them here and
+ * btrfs_extent_batch_flush() issues the pending read.
+ */
+struct btrfs_extent_batch {
+	u64 physical;
+	u64 len;
+	char *buf;
+};
+
 u64 btrfs_read_extent_inline(struct btrfs_path *,
 			      struct btrfs_file_extent_item *, u64, u64,
 			      char *);
 u64 btrfs_read_extent_reg(struct btrfs_path *, struct btrfs_file_extent_item *,
-			   u64, u64, char *);
+			   u64, u64, char *, struct btrfs_extent_batch *);
+int btrfs_extent_batch_flush(struct btrfs_extent_batch *);
 
 #endif /* !__BTRFS_BTRFS_H__ */
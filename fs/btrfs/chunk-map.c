@@ -15,6 +15,16 @@ struct chunk_map_item {
 	u64 physical;
 };
 
+/* Consecutive lookups mostly hit the same chunk, check it first */
+static struct chunk_map_item *last_item;
+
+static inline bool chunk_map_hit(const struct chunk_map_item *item,
+				 u64 logical)
+{
+	return item->logical <= logical &&
+	       logical < item->logical + item->length;
+}
+
 static int add_chunk_mapping(struct btrfs_key *key, struct btrfs_chunk *chunk)
 {
 	struct btrfs_stripe *stripe;
@@ -71,17 +81,22 @@ u64 btrfs_map_logical_to_physical(u64 logical)
 {
 	struct rb_node *node = btrfs_info.chunks_root.rb_node;
 
+	if (last_item && chunk_map_hit(last_item, logical))
+		return last_item->physical + logical - last_item->logical;
+
 	while (node) {
 		struct chunk_map_item *item;
 
 		item = rb_entry(node, struct chunk_map_item, node);
 
-		if (item->logical > logical)
+		if (item->logical > logical) {
 			node = node->rb_left;
-		else if (logical >= item->logical + item->length)
+		} else if (logical >= item->logical + item->length) {
 			node = node->rb_right;
-		else
+		} else {
+			last_item = item;
 			return item->physical + logical - item->logical;
+		}
 	}
 
 	printf("%s: Cannot map logical address %llu to physical\n", __func__,
@@ -95,6 +110,7 @@ void btrfs_chunk_map_exit(void)
 	struct rb_node *now, *next;
 	struct chunk_map_item *item;
 
+	last_item = NULL;
 	for (now = rb_first_postorder(&btrfs_info.chunks_root); now; now = next)
 	{
 		item = rb_entry(now, struct chunk_map_item, node);
@@ -113,6 +129,7 @@ int btrfs_chunk_map_init(void)
 	struct btrfs_chunk *chunk;
 
 	btrfs_info.chunks_root = RB_ROOT;
+	last_item = NULL;
 
 	memcpy(sys_chunk_array_copy, btrfs_info.sb.sys_chunk_array,
 	       sizeof(sys_chunk_array_copy));
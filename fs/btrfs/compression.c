@@ -113,27 +113,31 @@ static u32 decompress_zlib(const u8 *_cbuf, u32 clen, u8 *dbuf, u32 dlen)
 #define ZSTD_BTRFS_MAX_WINDOWLOG 17
 #define ZSTD_BTRFS_MAX_INPUT (1 << ZSTD_BTRFS_MAX_WINDOWLOG)
 
+/* Allocated on first use and kept until unmount, files have many extents */
+static void *zstd_workspace;
+
 static u32 decompress_zstd(const u8 *cbuf, u32 clen, u8 *dbuf, u32 dlen)
 {
 	ZSTD_DStream *dstream;
 	ZSTD_inBuffer in_buf;
 	ZSTD_outBuffer out_buf;
-	void *workspace;
 	size_t wsize;
-	u32 res = -1;
 
 	wsize = ZSTD_DStreamWorkspaceBound(ZSTD_BTRFS_MAX_INPUT);
-	workspace = malloc(wsize);
-	if (!workspace) {
-		debug("%s: cannot allocate workspace of size %zu\n", __func__,
-		      wsize);
-		return -1;
+	if (!zstd_workspace) {
+		zstd_workspace = malloc(wsize);
+		if (!zstd_workspace) {
+			debug("%s: cannot allocate workspace of size %zu\n",
+			      __func__, wsize);
+			return -1;
+		}
 	}
 
-	dstream = ZSTD_initDStream(ZSTD_BTRFS_MAX_INPUT, workspace, wsize);
+	dstream = ZSTD_initDStream(ZSTD_BTRFS_MAX_INPUT, zstd_workspace,
+				   wsize);
 	if (!dstream) {
 		printf("%s: ZSTD_initDStream failed\n", __func__);
-		goto err_free;
+		return -1;
 	}
 
 	in_buf.src = cbuf;
@@ -151,18 +155,14 @@ static u32 decompress_zstd(const u8 *cbuf, u32 clen, u8 *dbuf, u32 dlen)
 		if (ZSTD_isError(ret)) {
 			printf("%s: ZSTD_decompressStream error %d\n", __func__,
 			       ZSTD_getErrorCode(ret));
-			goto err_free;
+			return -1;
 		}
 
 		if (in_buf.pos >= clen || !ret)
 			break;
 	}
 
-	res = out_buf.pos;
-
-err_free:
-	free(workspace);
-	return res;
+	return out_buf.pos;
 }
 
 u32 btrfs_decompress(u8 type, const char *c, u32 clen, char *d, u32 dlen)
@@ -191,3 +191,9 @@ u32 btrfs_decompress(u8 type, const char *c, u32 clen, char *d, u32 dlen)
 		return -1;
 	}
 }
+
+void btrfs_decompress_exit(void)
+{
+	free(zstd_workspace);
+	zstd_workspace = NULL;
+}
@@ -8,6 +8,42 @@
 #include "btrfs.h"
 #include <malloc.h>
 #include <memalign.h>
+#include <linux/sizes.h>
+
+/* btrfs_devread() takes an int length */
+#define BTRFS_EXTENT_BATCH_MAX	SZ_1G
+
+int btrfs_extent_batch_flush(struct btrfs_extent_batch *batch)
+{
+	int ret = 0;
+
+	if (batch->len && !btrfs_devread(batch->physical, batch->len,
+					 batch->buf))
+		ret = -1;
+	batch->len = 0;
+
+	return ret;
+}
+
+static int btrfs_extent_batch_add(struct btrfs_extent_batch *batch,
+				  u64 physical, u64 len, char *buf)
+{
+	if (batch->len && batch->physical + batch->len == physical &&
+	    batch->buf + batch->len == buf &&
+	    batch->len + len <= BTRFS_EXTENT_BATCH_MAX) {
+		batch->len += len;
+		return 0;
+	}
+
+	if (btrfs_extent_batch_flush(batch))
+		return -1;
+
+	batch->physical = physical;
+	batch->len = len;
+	batch->buf = buf;
+
+	return 0;
+}
 
 u64 btrfs_read_extent_inline(struct btrfs_path *path,
 			     struct btrfs_file_extent_item *extent, u64 offset,
@@ -61,27 +97,30 @@ err:
 	return -1ULL;
 }
 
+/*
+ * Read from a regular extent. If @batch is given, an uncompressed read may
+ * only be queued; the caller must then call btrfs_extent_batch_flush()
+ * before using the data.
+ */
 u64 btrfs_read_extent_reg(struct btrfs_path *path,
 			  struct btrfs_file_extent_item *extent, u64 offset,
-			  u64 size, char *out)
+			  u64 size, char *out, struct btrfs_extent_batch *batch)
 {
-	u64 physical, clen, dlen, orig_size = size;
+	u64 physical, clen, dlen;
 	u32 res;
 	char *cbuf, *dbuf;
+	bool direct;
 
-	clen = extent->disk_num_bytes;
-	dlen = extent->num_bytes;
-
-	if (offset > dlen)
+	if (offset > extent->num_bytes)
 		return -1ULL;
 
-	if (size > dlen - offset)
-		size = dlen - offset;
+	if (size > extent->num_bytes - offset)
+		size = extent->num_bytes - offset;
 
 	/* sparse extent */
 	if (extent->disk_bytenr == 0) {
-		memset(out, 0, dlen);
-		return dlen;
+		memset(out, 0, size);
+		return size;
 	}
 
 	physical = btrfs_map_logical_to_physical(extent->disk_bytenr);
@@ -90,35 +129,47 @@ u64 btrfs_read_extent_reg(struct btrfs_path *path,
 
 	if (extent->compression == BTRFS_COMPRESS_NONE) {
 		physical += extent->offset + offset;
-		if (!btrfs_devread(physical, size, out))
+		if (batch) {
+			if (btrfs_extent_batch_add(batch, physical, size, out))
+				return -1ULL;
+		} else if (!btrfs_devread(physical, size, out)) {
 			return -1ULL;
+		}
 
 		return size;
 	}
 
-	cbuf = malloc_cache_aligned(dlen > size ? clen + dlen : clen);
+	/*
+	 * The file range covers num_bytes of the decompressed data, starting
+	 * at extent->offset, which may be only part of it (ram_bytes).
+	 */
+	clen = extent->disk_num_bytes;
+	dlen = extent->ram_bytes;
+	offset += extent->offset;
+	if (offset + size > dlen)
+		return -1ULL;
+
+	/* Decompress straight into @out when nothing else is produced */
+	direct = !offset && dlen == size;
+
+	cbuf = malloc_cache_aligned(direct ? clen : clen + dlen);
 	if (!cbuf)
 		return -1ULL;
 
-	if (dlen > orig_size)
-		dbuf = cbuf + clen;
-	else
-		dbuf = out;
+	dbuf = direct ? out : cbuf + clen;
 
 	if (!btrfs_devread(physical, clen, cbuf))
 		goto err;
 
 	res = btrfs_decompress(extent->compression, cbuf, clen, dbuf, dlen);
-	if (res == -1)
+	if (res == -1 || res < offset + size)
 		goto err;
 
-	if (dlen > orig_size)
+	if (!direct)
 		memcpy(out, dbuf + offset, size);
-	else
-		memmove(out, dbuf + offset, size);
 
 	free(cbuf);
-	return res;
+	return size;
 
 err:
 	free(cbuf);
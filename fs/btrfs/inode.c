@@ -322,6 +322,7 @@ u64 btrfs_file_read(const struct btrfs_root *root, u64 inr, u64 offset,
 	struct btrfs_path path;
 	struct btrfs_key key;
 	struct btrfs_file_extent_item *extent;
+	struct btrfs_extent_batch batch = { .len = 0 };
 	int res = 0;
 	u64 rd, rd_all = -1ULL;
 
@@ -356,7 +357,7 @@ u64 btrfs_file_read(const struct btrfs_root *root, u64 inr, u64 offset,
 		} else {
 			btrfs_file_extent_item_to_cpu(extent);
 			rd = btrfs_read_extent_reg(&path, extent, offset, size,
-						   buf);
+						   buf, &batch);
 		}
 
 		if (rd == -1ULL) {
@@ -374,10 +375,26 @@ u64 btrfs_file_read(const struct btrfs_root *root, u64 inr, u64 offset,
 			break;
 	} while (!(res = btrfs_next_slot(&path)));
 
-	if (res)
-		return -1ULL;
+	if (res < 0) {
+		rd_all = -1ULL;
+		goto out;
+	}
+
+	/*
+	 * The caller limits the read to the file size, so whatever is left
+	 * after the last extent is a hole at the end of the file. Zero it, as
+	 * for a sparse extent.
+	 */
+	if (size) {
+		memset(buf, 0, size);
+		rd_all += size;
+	}
 
 out:
+	if (btrfs_extent_batch_flush(&batch) && rd_all != -1ULL) {
+		printf("%s: Error reading extent\n", __func__);
+		rd_all = -1ULL;
+	}
 	btrfs_free_path(&path);
 	return rd_all;
 }
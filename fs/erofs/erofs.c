@@ -0,0 +1,590 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * EROFS filesystem implementation for U-Boot
+ *
+ * Read-only support for EROFS images with plain, tail-packed (inline) and
+ * LZ4 compressed data layouts. Plain file data is contiguous on disk and is
+ * read straight into the destination buffer in a single request; metadata
+ * goes through a small block cache which lives as long as the mount.
+ */
+
+#include <common.h>
+#include <errno.h>
+#include <erofs.h>
+#include <fs.h>
+#include <fs_internal.h>
+#include <malloc.h>
+#include <uuid.h>
+#include <linux/kernel.h>
+#include <linux/sizes.h>
+#include <linux/stat.h>
+
+#include "internal.h"
+
+#define EROFS_MAX_SYMLINKS	8
+#define EROFS_MAX_LINK_LEN	4096
+
+struct erofs_ctxt erofs_ctxt;
+
+struct erofs_dir_iter {
+	struct erofs_inode dir;
+	u32 block;
+	u32 index;
+};
+
+struct erofs_dir_stream {
+	struct fs_dir_stream fs_dirs;
+	struct fs_dirent dirent;
+	struct erofs_dir_iter iter;
+};
+
+int erofs_disk_read(u64 pos, u32 len, void *buf)
+{
+	struct blk_desc *dev = erofs_ctxt.cur_dev;
+
+	if (!fs_devread(dev, &erofs_ctxt.cur_part_info, pos >> dev->log2blksz,
+			pos & (dev->blksz - 1), len, buf))
+		return -EIO;
+
+	return 0;
+}
+
+static const void *erofs_read_metablock(u32 blkaddr)
+{
+	struct erofs_cache_entry *entry, *victim = NULL;
+	int i;
+
+	for (i = 0; i < EROFS_META_CACHE_ENTRIES; i++) {
+		entry = &erofs_ctxt.meta_cache[i];
+		if (entry->valid && entry->blkaddr == blkaddr) {
+			entry->seq = ++erofs_ctxt.cache_seq;
+			return entry->data;
+		}
+		if (!victim || entry->seq < victim->seq)
+			victim = entry;
+	}
+
+	victim->valid = false;
+	if (!victim->data) {
+		victim->data = malloc(erofs_ctxt.blksz);
+		if (!victim->data)
+			return NULL;
+	}
+	if (erofs_disk_read((u64)blkaddr << erofs_ctxt.blkszbits,
+			    erofs_ctxt.blksz, victim->data))
+		return NULL;
+
+	victim->blkaddr = blkaddr;
+	victim->valid = true;
+	victim->seq = ++erofs_ctxt.cache_seq;
+
+	return victim->data;
+}
+
+/* Copy metadata at disk position @pos, possibly spanning blocks */
+int erofs_read_meta(u64 pos, void *buf, u32 len)
+{
+	const void *data;
+	u32 off, n;
+
+	while (len) {
+		data = erofs_read_metablock(pos >> erofs_ctxt.blkszbits);
+		if (!data)
+			return -EIO;
+
+		off = pos & (erofs_ctxt.blksz - 1);
+		n = min(len, erofs_ctxt.blksz - off);
+		memcpy(buf, data + off, n);
+		buf += n;
+		pos += n;
+		len -= n;
+	}
+
+	return 0;
+}
+
+static int erofs_read_inode(u64 nid, struct erofs_inode *inode)
+{
+	union {
+		struct erofs_inode_compact c;
+		struct erofs_inode_extended e;
+	} raw;
+	struct z_erofs_map_header h;
+	u64 pos = erofs_ctxt.meta_base + (nid << EROFS_ISLOTBITS);
+	u32 isize, xattr_isize;
+	u16 fmt, icount;
+	int ret;
+
+	ret = erofs_read_meta(pos, &raw.c, sizeof(raw.c));
+	if (ret)
+		return ret;
+
+	fmt = le16_to_cpu(raw.c.i_format);
+	memset(inode, 0, sizeof(*inode));
+	inode->nid = nid;
+	inode->datalayout = EROFS_I_DATALAYOUT(fmt);
+
+	switch (EROFS_I_VERSION(fmt)) {
+	case EROFS_INODE_LAYOUT_COMPACT:
+		isize = sizeof(raw.c);
+		inode->mode = le16_to_cpu(raw.c.i_mode);
+		inode->size = le32_to_cpu(raw.c.i_size);
+		inode->raw_blkaddr = le32_to_cpu(raw.c.i_u.raw_blkaddr);
+		break;
+	default:
+		isize = sizeof(raw.e);
+		ret = erofs_read_meta(pos + sizeof(raw.c),
+				      (u8 *)&raw + sizeof(raw.c),
+				      sizeof(raw.e) - sizeof(raw.c));
+		if (ret)
+			return ret;
+		inode->mode = le16_to_cpu(raw.e.i_mode);
+		inode->size = le64_to_cpu(raw.e.i_size);
+		inode->raw_blkaddr = le32_to_cpu(raw.e.i_u.raw_blkaddr);
+		break;
+	}
+
+	icount = le16_to_cpu(raw.c.i_xattr_icount);
+	xattr_isize = icount ? EROFS_XATTR_IBODY_HDR_SIZE +
+			       (icount - 1) * EROFS_XATTR_ENTRY_SIZE : 0;
+	inode->inline_pos = pos + isize + xattr_isize;
+
+	switch (inode->datalayout) {
+	case EROFS_INODE_FLAT_PLAIN:
+	case EROFS_INODE_FLAT_INLINE:
+		return 0;
+	case EROFS_INODE_FLAT_COMPRESSION_LEGACY:
+	case EROFS_INODE_FLAT_COMPRESSION:
+		break;
+	default:
+		debug("%s: unsupported data layout %u\n", __func__,
+		      inode->datalayout);
+		return -EOPNOTSUPP;
+	}
+
+	ret = erofs_read_meta(round_up(inode->inline_pos, 8), &h, sizeof(h));
+	if (ret)
+		return ret;
+
+	inode->z_advise = le16_to_cpu(h.h_advise);
+	inode->z_lclusterbits = erofs_ctxt.blkszbits + (h.h_clusterbits & 7);
+	if ((h.h_algorithmtype & 0xf) != Z_EROFS_COMPRESSION_LZ4 ||
+	    inode->z_lclusterbits != erofs_ctxt.blkszbits ||
+	    inode->z_advise & (Z_EROFS_ADVISE_BIG_PCLUSTER_1 |
+			       Z_EROFS_ADVISE_BIG_PCLUSTER_2)) {
+		debug("%s: unsupported compression (algorithm %u, advise %x)\n",
+		      __func__, h.h_algorithmtype, inode->z_advise);
+		return -EOPNOTSUPP;
+	}
+
+	return 0;
+}
+
+/*
+ * Map @pos of an uncompressed inode to a disk position. Blocks are stored
+ * contiguously from raw_blkaddr, except that the tail of an inline inode
+ * follows the on-disk inode. Return 1 if @pos is in that inline tail, 0 if
+ * it is in the plain blocks or a negative error code.
+ */
+static int erofs_map_flat(const struct erofs_inode *inode, u64 pos,
+			  u64 *phys, u64 *avail)
+{
+	u64 nblocks, raw_end;
+
+	if (inode->datalayout == EROFS_INODE_FLAT_INLINE)
+		nblocks = inode->size >> erofs_ctxt.blkszbits;
+	else
+		nblocks = DIV_ROUND_UP(inode->size, erofs_ctxt.blksz);
+	raw_end = nblocks << erofs_ctxt.blkszbits;
+
+	if (pos < raw_end) {
+		*phys = ((u64)inode->raw_blkaddr << erofs_ctxt.blkszbits) + pos;
+		*avail = min(raw_end, inode->size) - pos;
+		return 0;
+	}
+
+	/* The inline tail must not cross a block boundary */
+	if ((inode->inline_pos & (erofs_ctxt.blksz - 1)) +
+	    inode->size - raw_end > erofs_ctxt.blksz)
+		return -EIO;
+
+	*phys = inode->inline_pos + pos - raw_end;
+	*avail = inode->size - pos;
+
+	return 1;
+}
+
+static int erofs_pread(struct erofs_inode *inode, void *buf, u64 offset,
+		       u64 len)
+{
+	u64 phys, avail, n;
+	int ret;
+
+	if (erofs_inode_is_compressed(inode))
+		return z_erofs_read(inode, buf, offset, len);
+
+	while (len) {
+		ret = erofs_map_flat(inode, offset, &phys, &avail);
+		if (ret < 0)
+			return ret;
+
+		/* fs_devread() takes an int length */
+		n = min3(len, avail, (u64)SZ_1G);
+		/* The inline tail shares its block with metadata */
+		if (ret)
+			ret = erofs_read_meta(phys, buf, n);
+		else
+			ret = erofs_disk_read(phys, n, buf);
+		if (ret)
+			return ret;
+
+		buf += n;
+		offset += n;
+		len -= n;
+	}
+
+	return 0;
+}
+
+static void erofs_dir_init(const struct erofs_inode *dir,
+			   struct erofs_dir_iter *iter)
+{
+	iter->dir = *dir;
+	iter->block = 0;
+	iter->index = 0;
+}
+
+/*
+ * Fetch the next directory entry into @name (EROFS_NAME_LEN + 1 bytes).
+ * Return 1 if an entry was found, 0 at the end of the directory or a
+ * negative error code.
+ */
+static int erofs_dir_next(struct erofs_dir_iter *iter, char *name, u64 *nid,
+			  u8 *type)
+{
+	const struct erofs_inode *dir = &iter->dir;
+	struct erofs_dirent de;
+	u32 blklen, count, nameoff, nameend;
+	u64 blkpos, phys, avail;
+	__le16 next;
+	int ret;
+
+	for (;;) {
+		blkpos = (u64)iter->block << erofs_ctxt.blkszbits;
+		if (blkpos >= dir->size)
+			return 0;
+		blklen = min_t(u64, erofs_ctxt.blksz, dir->size - blkpos);
+
+		ret = erofs_map_flat(dir, blkpos, &phys, &avail);
+		if (ret >= 0)
+			ret = erofs_read_meta(phys, &de, sizeof(de));
+		if (ret)
+			return ret;
+
+		/* The first name starts right after the last dirent */
+		nameoff = le16_to_cpu(de.nameoff);
+		if (nameoff < sizeof(de) || nameoff >= blklen)
+			return -EIO;
+		count = nameoff / sizeof(de);
+		if (iter->index < count)
+			break;
+
+		iter->block++;
+		iter->index = 0;
+	}
+
+	ret = erofs_read_meta(phys + iter->index * sizeof(de), &de, sizeof(de));
+	if (ret)
+		return ret;
+	nameoff = le16_to_cpu(de.nameoff);
+
+	if (iter->index + 1 < count) {
+		ret = erofs_read_meta(phys + (iter->index + 1) * sizeof(de) +
+				      offsetof(struct erofs_dirent, nameoff),
+				      &next, sizeof(next));
+		if (ret)
+			return ret;
+		nameend = le16_to_cpu(next);
+	} else {
+		nameend = blklen;
+	}
+	if (nameend <= nameoff || nameend > blklen)
+		return -EIO;
+
+	nameend = min_t(u32, nameend - nameoff, EROFS_NAME_LEN);
+	ret = erofs_read_meta(phys + nameoff, name, nameend);
+	if (ret)
+		return ret;
+	/* The last name of a block may be padded with NULs */
+	name[nameend] = '\0';
+
+	*nid = le64_to_cpu(de.nid);
+	*type = de.file_type;
+	iter->index++;
+
+	return 1;
+}
+
+static int erofs_dir_find(const struct erofs_inode *dir, const char *name,
+			  u64 *nid)
+{
+	char entry_name[EROFS_NAME_LEN + 1];
+	struct erofs_dir_iter iter;
+	u8 type;
+	int ret;
+
+	erofs_dir_init(dir, &iter);
+	while ((ret = erofs_dir_next(&iter, entry_name, nid, &type)) > 0) {
+		if (!strcmp(entry_name, name))
+			return 0;
+	}
+
+	return ret < 0 ? ret : -ENOENT;
+}
+
+/* Resolve @filename to an inode, following symbolic links on the way */
+static int erofs_lookup(const char *filename, struct erofs_inode *inode)
+{
+	u64 root = le16_to_cpu(erofs_ctxt.sblk.root_nid);
+	char *path, *p, *name, *target;
+	int links = 0;
+	u64 dir, nid;
+	int ret;
+
+	path = strdup(filename);
+	if (!path)
+		return -ENOMEM;
+
+	ret = erofs_read_inode(root, inode);
+
+	p = path;
+	while (!ret) {
+		while (*p == '/')
+			p++;
+		if (!*p)
+			break;
+
+		name = p;
+		p = (char *)strchrnul(p, '/');
+		if (*p)
+			*p++ = '\0';
+
+		if (!S_ISDIR(inode->mode)) {
+			ret = -ENOTDIR;
+			break;
+		}
+		if (!strcmp(name, "."))
+			continue;
+
+		/* ".." is a regular entry of every directory */
+		dir = inode->nid;
+		ret = erofs_dir_find(inode, name, &nid);
+		if (!ret)
+			ret = erofs_read_inode(nid, inode);
+		if (ret || !S_ISLNK(inode->mode))
+			continue;
+
+		if (++links > EROFS_MAX_SYMLINKS) {
+			ret = -ELOOP;
+			break;
+		}
+		if (!inode->size || inode->size > EROFS_MAX_LINK_LEN) {
+			ret = -EIO;
+			break;
+		}
+
+		/* Continue with the link target followed by the rest */
+		target = malloc(inode->size + strlen(p) + 2);
+		if (!target) {
+			ret = -ENOMEM;
+			break;
+		}
+		ret = erofs_pread(inode, target, 0, inode->size);
+		if (ret) {
+			free(target);
+			break;
+		}
+		target[inode->size] = '/';
+		strcpy(target + inode->size + 1, p);
+		free(path);
+		path = target;
+		p = path;
+
+		ret = erofs_read_inode(*p == '/' ? root : dir, inode);
+	}
+
+	free(path);
+
+	return ret;
+}
+
+int erofs_probe(struct blk_desc *fs_dev_desc, disk_partition_t *fs_partition)
+{
+	u32 incompat;
+	int ret;
+
+	erofs_ctxt.cur_dev = fs_dev_desc;
+	erofs_ctxt.cur_part_info = *fs_partition;
+
+	ret = erofs_disk_read(EROFS_SUPER_OFFSET, sizeof(erofs_ctxt.sblk),
+			      &erofs_ctxt.sblk);
+	if (ret)
+		goto error;
+
+	if (le32_to_cpu(erofs_ctxt.sblk.magic) != EROFS_SUPER_MAGIC_V1 ||
+	    erofs_ctxt.sblk.blkszbits < 9 || erofs_ctxt.sblk.blkszbits > 16) {
+		ret = -EINVAL;
+		goto error;
+	}
+
+	incompat = le32_to_cpu(erofs_ctxt.sblk.feature_incompat);
+	if (incompat & ~EROFS_ALL_FEATURE_INCOMPAT) {
+		printf("** EROFS features %x are not supported **\n",
+		       incompat & ~EROFS_ALL_FEATURE_INCOMPAT);
+		ret = -EOPNOTSUPP;
+		goto error;
+	}
+
+	erofs_ctxt.blkszbits = erofs_ctxt.sblk.blkszbits;
+	erofs_ctxt.blksz = 1 << erofs_ctxt.blkszbits;
+	erofs_ctxt.meta_base = (u64)le32_to_cpu(erofs_ctxt.sblk.meta_blkaddr) <<
+			 erofs_ctxt.blkszbits;
+
+	return 0;
+
+error:
+	erofs_close();
+
+	return ret;
+}
+
+int erofs_opendir(const char *filename, struct fs_dir_stream **dirsp)
+{
+	struct erofs_dir_stream *dirs;
+	struct erofs_inode inode;
+	int ret;
+
+	ret = erofs_lookup(filename, &inode);
+	if (ret)
+		return ret;
+	if (!S_ISDIR(inode.mode))
+		return -ENOTDIR;
+
+	dirs = calloc(1, sizeof(*dirs));
+	if (!dirs)
+		return -ENOMEM;
+	erofs_dir_init(&inode, &dirs->iter);
+	*dirsp = &dirs->fs_dirs;
+
+	return 0;
+}
+
+int erofs_readdir(struct fs_dir_stream *fs_dirs, struct fs_dirent **dentp)
+{
+	struct erofs_dir_stream *dirs;
+	char name[EROFS_NAME_LEN + 1];
+	struct erofs_inode inode;
+	u64 nid;
+	u8 type;
+	int ret;
+
+	dirs = container_of(fs_dirs, struct erofs_dir_stream, fs_dirs);
+	do {
+		ret = erofs_dir_next(&dirs->iter, name, &nid, &type);
+		if (ret <= 0)
+			return ret ? ret : -ENOENT;
+	} while (!strcmp(name, ".") || !strcmp(name, ".."));
+
+	ret = erofs_read_inode(nid, &inode);
+	if (ret)
+		return ret;
+
+	memset(&dirs->dirent, 0, sizeof(dirs->dirent));
+	strlcpy(dirs->dirent.name, name, sizeof(dirs->dirent.name));
+	if (S_ISDIR(inode.mode)) {
+		dirs->dirent.type = FS_DT_DIR;
+	} else {
+		dirs->dirent.type = S_ISLNK(inode.mode) ? FS_DT_LNK : FS_DT_REG;
+		dirs->dirent.size = inode.size;
+	}
+	*dentp = &dirs->dirent;
+
+	return 0;
+}
+
+void erofs_closedir(struct fs_dir_stream *fs_dirs)
+{
+	free(container_of(fs_dirs, struct erofs_dir_stream, fs_dirs));
+}
+
+int erofs_read(const char *filename, void *buf, loff_t offset, loff_t len,
+	       loff_t *actread)
+{
+	struct erofs_inode inode;
+	int ret;
+
+	*actread = 0;
+
+	ret = erofs_lookup(filename, &inode);
+	if (ret)
+		return ret;
+	if (S_ISDIR(inode.mode))
+		return -EISDIR;
+	if (!S_ISREG(inode.mode))
+		return -EINVAL;
+
+	if (offset >= inode.size)
+		return 0;
+	if (!len || len > inode.size - offset)
+		len = inode.size - offset;
+
+	ret = erofs_pread(&inode, buf, offset, len);
+	if (ret)
+		return ret;
+
+	*actread = len;
+
+	return 0;
+}
+
+int erofs_size(const char *filename, loff_t *size)
+{
+	struct erofs_inode inode;
+	int ret;
+
+	ret = erofs_lookup(filename, &inode);
+	if (ret)
+		return ret;
+
+	*size = inode.size;
+
+	return 0;
+}
+
+int erofs_exists(const char *filename)
+{
+	struct erofs_inode inode;
+
+	return !erofs_lookup(filename, &inode);
+}
+
+int erofs_uuid(char *uuid_str)
+{
+	if (!IS_ENABLED(CONFIG_LIB_UUID))
+		return -ENOSYS;
+
+	uuid_bin_to_str(erofs_ctxt.sblk.uuid, uuid_str, UUID_STR_FORMAT_STD);
+
+	return 0;
+}
+
+void erofs_close(void)
+{
+	int i;
+
+	for (i = 0; i < EROFS_META_CACHE_ENTRIES; i++)
+		free(erofs_ctxt.meta_cache[i].data);
+	free(erofs_ctxt.comp_buf);
+	free(erofs_ctxt.ext_buf);
+	memset(&erofs_ctxt, 0, sizeof(erofs_ctxt));
+}
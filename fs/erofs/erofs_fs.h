@@ -0,0 +1,164 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * EROFS filesystem implementation for U-Boot
+ *
+ * On-disk structures of the EROFS format. All fields are little endian.
+ */
+
+#ifndef __EROFS_FS_H__
+#define __EROFS_FS_H__
+
+#include <linux/types.h>
+
+#define EROFS_SUPER_OFFSET		1024
+#define EROFS_SUPER_MAGIC_V1		0xE0F5E1E2
+
+/* Compressed data is right-aligned within its physical cluster */
+#define EROFS_FEATURE_INCOMPAT_LZ4_0PADDING	0x00000001
+#define EROFS_ALL_FEATURE_INCOMPAT	EROFS_FEATURE_INCOMPAT_LZ4_0PADDING
+
+#define EROFS_ISLOTBITS			5
+#define EROFS_NAME_LEN			255
+
+struct erofs_super_block {
+	__le32 magic;
+	__le32 checksum;
+	__le32 feature_compat;
+	__u8 blkszbits;
+	__u8 reserved;
+	__le16 root_nid;
+	__le64 inos;
+	__le64 build_time;
+	__le32 build_time_nsec;
+	__le32 blocks;
+	__le32 meta_blkaddr;
+	__le32 xattr_blkaddr;
+	__u8 uuid[16];
+	__u8 volume_name[16];
+	__le32 feature_incompat;
+	__u8 reserved2[44];
+} __packed;
+
+/* i_format: bit 0 is the inode version, bits 1-3 the data layout */
+#define EROFS_I_VERSION_BIT		0
+#define EROFS_I_DATALAYOUT_BIT		1
+#define EROFS_I_VERSION(fmt)		(((fmt) >> EROFS_I_VERSION_BIT) & 1)
+#define EROFS_I_DATALAYOUT(fmt)		(((fmt) >> EROFS_I_DATALAYOUT_BIT) & 7)
+
+enum {
+	EROFS_INODE_LAYOUT_COMPACT = 0,
+	EROFS_INODE_LAYOUT_EXTENDED = 1,
+};
+
+enum {
+	EROFS_INODE_FLAT_PLAIN = 0,
+	EROFS_INODE_FLAT_COMPRESSION_LEGACY = 1,
+	EROFS_INODE_FLAT_INLINE = 2,
+	EROFS_INODE_FLAT_COMPRESSION = 3,
+};
+
+struct erofs_inode_compact {
+	__le16 i_format;
+	__le16 i_xattr_icount;
+	__le16 i_mode;
+	__le16 i_nlink;
+	__le32 i_size;
+	__le32 i_reserved;
+	union {
+		__le32 compressed_blocks;
+		__le32 raw_blkaddr;
+		__le32 rdev;
+	} i_u;
+	__le32 i_ino;
+	__le16 i_uid;
+	__le16 i_gid;
+	__le32 i_reserved2;
+} __packed;
+
+struct erofs_inode_extended {
+	__le16 i_format;
+	__le16 i_xattr_icount;
+	__le16 i_mode;
+	__le16 i_reserved;
+	__le64 i_size;
+	union {
+		__le32 compressed_blocks;
+		__le32 raw_blkaddr;
+		__le32 rdev;
+	} i_u;
+	__le32 i_ino;
+	__le32 i_uid;
+	__le32 i_gid;
+	__le64 i_ctime;
+	__le32 i_ctime_nsec;
+	__le32 i_nlink;
+	__u8 i_reserved2[16];
+} __packed;
+
+/* In-inode xattrs: a 12-byte header plus (i_xattr_icount - 1) slots */
+#define EROFS_XATTR_IBODY_HDR_SIZE	12
+#define EROFS_XATTR_ENTRY_SIZE		4
+
+struct erofs_dirent {
+	__le64 nid;
+	__le16 nameoff;
+	__u8 file_type;
+	__u8 reserved;
+} __packed;
+
+enum {
+	EROFS_FT_UNKNOWN,
+	EROFS_FT_REG_FILE,
+	EROFS_FT_DIR,
+	EROFS_FT_CHRDEV,
+	EROFS_FT_BLKDEV,
+	EROFS_FT_FIFO,
+	EROFS_FT_SOCK,
+	EROFS_FT_SYMLINK,
+};
+
+/* Compressed inodes: map header follows the inode and its xattrs */
+#define Z_EROFS_ADVISE_COMPACTED_2B	0x0001
+#define Z_EROFS_ADVISE_BIG_PCLUSTER_1	0x0002
+#define Z_EROFS_ADVISE_BIG_PCLUSTER_2	0x0004
+
+enum {
+	Z_EROFS_COMPRESSION_LZ4 = 0,
+};
+
+struct z_erofs_map_header {
+	__le32 h_reserved1;
+	__le16 h_advise;
+	/* bits 0-3: algorithm of the head cluster, 4-7: of the others */
+	__u8 h_algorithmtype;
+	/* bits 0-2: logical cluster bits minus block size bits */
+	__u8 h_clusterbits;
+} __packed;
+
+enum {
+	Z_EROFS_VLE_CLUSTER_TYPE_PLAIN = 0,
+	Z_EROFS_VLE_CLUSTER_TYPE_HEAD = 1,
+	Z_EROFS_VLE_CLUSTER_TYPE_NONHEAD = 2,
+	Z_EROFS_VLE_CLUSTER_TYPE_RESERVED = 3,
+};
+
+#define Z_EROFS_VLE_DI_CLUSTER_TYPE_BITS	2
+
+struct z_erofs_vle_decompressed_index {
+	__le16 di_advise;
+	/* where the extent starts in a HEAD or PLAIN logical cluster */
+	__le16 di_clusterofs;
+	union {
+		/* physical block of a HEAD or PLAIN logical cluster */
+		__le32 blkaddr;
+		/* distances to the head / next head of a NONHEAD cluster */
+		__le16 delta[2];
+	} di_u;
+} __packed;
+
+#define Z_EROFS_VLE_LEGACY_HEADER_PADDING	8
+#define Z_EROFS_VLE_LEGACY_INDEX_ALIGN(size) \
+	(round_up(size, sizeof(struct z_erofs_vle_decompressed_index)) + \
+	 sizeof(struct z_erofs_map_header) + Z_EROFS_VLE_LEGACY_HEADER_PADDING)
+
+#endif /* __EROFS_FS_H__ */
@@ -0,0 +1,78 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * EROFS filesystem implementation for U-Boot
+ */
+
+#ifndef __EROFS_INTERNAL_H__
+#define __EROFS_INTERNAL_H__
+
+#include <part.h>
+
+#include "erofs_fs.h"
+
+/* Metadata blocks (inodes, directories, indexes) kept while mounted */
+#define EROFS_META_CACHE_ENTRIES	8
+
+struct erofs_cache_entry {
+	u32 blkaddr;
+	bool valid;
+	ulong seq;
+	void *data;
+};
+
+struct erofs_ctxt {
+	struct blk_desc *cur_dev;
+	disk_partition_t cur_part_info;
+	struct erofs_super_block sblk;
+	unsigned int blkszbits;
+	u32 blksz;
+	u64 meta_base;
+	struct erofs_cache_entry meta_cache[EROFS_META_CACHE_ENTRIES];
+	ulong cache_seq;
+	/* Physical cluster being decompressed */
+	void *comp_buf;
+	/* Last extent which was only partially copied out */
+	u64 ext_nid;
+	u64 ext_la;
+	u32 ext_len;
+	u32 ext_buf_size;
+	void *ext_buf;
+};
+
+extern struct erofs_ctxt erofs_ctxt;
+
+/* In-memory inode, only the fields this driver needs */
+struct erofs_inode {
+	u64 nid;
+	u16 mode;
+	u8 datalayout;
+	u64 size;
+	u32 raw_blkaddr;
+	/* Disk position right after the on-disk inode and its xattrs */
+	u64 inline_pos;
+	/* compressed inodes */
+	u16 z_advise;
+	u8 z_lclusterbits;
+};
+
+static inline bool erofs_inode_is_compressed(const struct erofs_inode *inode)
+{
+	return inode->datalayout == EROFS_INODE_FLAT_COMPRESSION_LEGACY ||
+	       inode->datalayout == EROFS_INODE_FLAT_COMPRESSION;
+}
+
+int erofs_disk_read(u64 pos, u32 len, void *buf);
+int erofs_read_meta(u64 pos, void *buf, u32 len);
+
+/**
+ * z_erofs_read() - read from a compressed inode
+ *
+ * @inode:	inode with a compressed data layout
+ * @buf:	destination buffer
+ * @offset:	offset in the file, must be below the file size
+ * @len:	number of bytes to read, must not cross the end of the file
+ * @return 0 if OK, negative on error
+ */
+int z_erofs_read(struct erofs_inode *inode, void *buf, u64 offset, u64 len);
+
+#endif /* __EROFS_INTERNAL_H__ */
@@ -0,0 +1,390 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * EROFS filesystem implementation for U-Boot
+ *
+ * Compressed inodes: logical cluster index decoding and LZ4 extents.
+ *
+ * A compressed file is split into extents of variable logical length, each
+ * compressed into one physical cluster. Every logical cluster has an index
+ * entry, either in the legacy (8 bytes) or the compacted (2 or 4 bytes
+ * amortized) format, telling whether an extent starts in it (HEAD or PLAIN)
+ * and where, or how far back the extent's head is (NONHEAD).
+ */
+
+#include <common.h>
+#include <errno.h>
+#include <lz4.h>
+#include <malloc.h>
+#include <asm/unaligned.h>
+#include <linux/kernel.h>
+
+#include "internal.h"
+
+struct z_erofs_maprecorder {
+	struct erofs_inode *inode;
+	u64 lcn;
+	u8 type;
+	u16 clusterofs;
+	u16 delta0;
+	u32 pblk;
+};
+
+struct z_erofs_map {
+	u64 la;		/* logical start of the extent */
+	u64 llen;	/* logical length of the extent */
+	u64 pa;		/* disk position of the physical cluster */
+	bool zipped;
+};
+
+static int z_erofs_legacy_load(struct z_erofs_maprecorder *m, u64 lcn)
+{
+	struct erofs_inode *inode = m->inode;
+	struct z_erofs_vle_decompressed_index di;
+	u64 pos;
+	int ret;
+
+	pos = Z_EROFS_VLE_LEGACY_INDEX_ALIGN(inode->inline_pos) +
+	      lcn * sizeof(di);
+	ret = erofs_read_meta(pos, &di, sizeof(di));
+	if (ret)
+		return ret;
+
+	m->lcn = lcn;
+	m->type = le16_to_cpu(di.di_advise) &
+		  ((1 << Z_EROFS_VLE_DI_CLUSTER_TYPE_BITS) - 1);
+	switch (m->type) {
+	case Z_EROFS_VLE_CLUSTER_TYPE_NONHEAD:
+		m->clusterofs = 1 << inode->z_lclusterbits;
+		m->delta0 = le16_to_cpu(di.di_u.delta[0]);
+		break;
+	case Z_EROFS_VLE_CLUSTER_TYPE_PLAIN:
+	case Z_EROFS_VLE_CLUSTER_TYPE_HEAD:
+		m->clusterofs = le16_to_cpu(di.di_clusterofs);
+		m->pblk = le32_to_cpu(di.di_u.blkaddr);
+		break;
+	default:
+		return -EIO;
+	}
+
+	return 0;
+}
+
+static unsigned int z_erofs_decode_bits(unsigned int lobits, const u8 *in,
+					unsigned int pos, u8 *type)
+{
+	const u32 v = get_unaligned_le32(in + pos / 8) >> (pos & 7);
+
+	*type = (v >> lobits) & 3;
+
+	return v & ((1 << lobits) - 1);
+}
+
+/*
+ * Compacted indexes come in packs of @vcnt entries sharing one 32-bit
+ * block address at the end of the pack; the address of a HEAD or PLAIN
+ * entry is found by counting the heads before it in the pack.
+ */
+static int z_erofs_unpack_compacted(struct z_erofs_maprecorder *m,
+				    unsigned int amortizedshift, u64 pos)
+{
+	const unsigned int lclusterbits = m->inode->z_lclusterbits;
+	unsigned int vcnt, packsize, encodebits, lo, nblk;
+	u8 in[32], type;
+	u64 packpos;
+	int i, ret;
+
+	if (amortizedshift == 2)
+		vcnt = 2;
+	else if (amortizedshift == 1 && lclusterbits == 12)
+		vcnt = 16;
+	else
+		return -EOPNOTSUPP;
+
+	packsize = vcnt << amortizedshift;
+	encodebits = (packsize - sizeof(__le32)) * 8 / vcnt;
+	packpos = round_down(pos, packsize);
+	ret = erofs_read_meta(packpos, in, packsize);
+	if (ret)
+		return ret;
+
+	i = (pos - packpos) >> amortizedshift;
+	lo = z_erofs_decode_bits(lclusterbits, in, encodebits * i, &type);
+	m->type = type;
+	if (type == Z_EROFS_VLE_CLUSTER_TYPE_NONHEAD) {
+		m->clusterofs = 1 << lclusterbits;
+		if (i + 1 != vcnt) {
+			m->delta0 = lo;
+			return 0;
+		}
+		/*
+		 * The last entry of a pack stores the distance to the next
+		 * head instead, so derive it from the previous entry.
+		 */
+		lo = z_erofs_decode_bits(lclusterbits, in, encodebits * (i - 1),
+					 &type);
+		if (type != Z_EROFS_VLE_CLUSTER_TYPE_NONHEAD)
+			lo = 0;
+		m->delta0 = lo + 1;
+		return 0;
+	}
+	if (type == Z_EROFS_VLE_CLUSTER_TYPE_RESERVED)
+		return -EIO;
+
+	m->clusterofs = lo;
+	m->delta0 = 0;
+	nblk = 1;
+	while (i > 0) {
+		--i;
+		lo = z_erofs_decode_bits(lclusterbits, in, encodebits * i,
+					 &type);
+		if (type == Z_EROFS_VLE_CLUSTER_TYPE_NONHEAD)
+			i -= lo;
+		if (i >= 0)
+			++nblk;
+	}
+	m->pblk = get_unaligned_le32(in + packsize - sizeof(__le32)) + nblk;
+
+	return 0;
+}
+
+static int z_erofs_compacted_load(struct z_erofs_maprecorder *m, u64 lcn)
+{
+	struct erofs_inode *inode = m->inode;
+	const u64 ebase = round_up(inode->inline_pos, 8) +
+			  sizeof(struct z_erofs_map_header);
+	const u64 totalidx = DIV_ROUND_UP(inode->size, erofs_ctxt.blksz);
+	unsigned int compacted_4b_initial, amortizedshift;
+	u64 compacted_2b, pos;
+
+	if (inode->z_lclusterbits != erofs_ctxt.blkszbits)
+		return -EOPNOTSUPP;
+	if (lcn >= totalidx)
+		return -EINVAL;
+
+	m->lcn = lcn;
+	/* 4-byte entries until the 2-byte packs are 32-byte aligned */
+	compacted_4b_initial = (32 - ebase % 32) / 4;
+	if (compacted_4b_initial == 32 / 4)
+		compacted_4b_initial = 0;
+
+	if (inode->z_advise & Z_EROFS_ADVISE_COMPACTED_2B &&
+	    totalidx > compacted_4b_initial)
+		compacted_2b = round_down(totalidx - compacted_4b_initial, 16);
+	else
+		compacted_2b = 0;
+
+	pos = ebase;
+	amortizedshift = 2;
+	if (lcn >= compacted_4b_initial) {
+		pos += compacted_4b_initial * 4;
+		lcn -= compacted_4b_initial;
+		if (lcn < compacted_2b) {
+			amortizedshift = 1;
+		} else {
+			pos += compacted_2b * 2;
+			lcn -= compacted_2b;
+		}
+	}
+	pos += lcn << amortizedshift;
+
+	return z_erofs_unpack_compacted(m, amortizedshift, pos);
+}
+
+static int z_erofs_load_cluster(struct z_erofs_maprecorder *m, u64 lcn)
+{
+	if (m->inode->datalayout == EROFS_INODE_FLAT_COMPRESSION_LEGACY)
+		return z_erofs_legacy_load(m, lcn);
+
+	return z_erofs_compacted_load(m, lcn);
+}
+
+/* Walk NONHEAD clusters back to the head of the extent */
+static int z_erofs_lookback(struct z_erofs_maprecorder *m,
+			    struct z_erofs_map *map, unsigned int distance)
+{
+	int ret;
+
+	for (;;) {
+		if (!distance || distance > m->lcn)
+			return -EIO;
+		ret = z_erofs_load_cluster(m, m->lcn - distance);
+		if (ret)
+			return ret;
+
+		switch (m->type) {
+		case Z_EROFS_VLE_CLUSTER_TYPE_NONHEAD:
+			distance = m->delta0;
+			continue;
+		case Z_EROFS_VLE_CLUSTER_TYPE_PLAIN:
+			map->zipped = false;
+			/* fall through */
+		case Z_EROFS_VLE_CLUSTER_TYPE_HEAD:
+			map->la = (m->lcn << m->inode->z_lclusterbits) |
+				  m->clusterofs;
+			return 0;
+		default:
+			return -EIO;
+		}
+	}
+}
+
+/* Find the extent covering @ofs */
+static int z_erofs_map_blocks(struct erofs_inode *inode, u64 ofs,
+			      struct z_erofs_map *map)
+{
+	const unsigned int lclusterbits = inode->z_lclusterbits;
+	const u64 totalidx = DIV_ROUND_UP(inode->size, 1ULL << lclusterbits);
+	struct z_erofs_maprecorder m = { .inode = inode };
+	u64 lcn = ofs >> lclusterbits;
+	u32 endoff = ofs & ((1 << lclusterbits) - 1);
+	u64 end = 0;
+	u32 pblk;
+	int ret;
+
+	ret = z_erofs_load_cluster(&m, lcn);
+	if (ret)
+		return ret;
+
+	map->zipped = true;
+	switch (m.type) {
+	case Z_EROFS_VLE_CLUSTER_TYPE_PLAIN:
+	case Z_EROFS_VLE_CLUSTER_TYPE_HEAD:
+		if (endoff >= m.clusterofs) {
+			map->zipped = m.type == Z_EROFS_VLE_CLUSTER_TYPE_HEAD;
+			map->la = (lcn << lclusterbits) | m.clusterofs;
+			pblk = m.pblk;
+			break;
+		}
+		/* @ofs is still part of the previous extent */
+		end = (lcn << lclusterbits) | m.clusterofs;
+		ret = z_erofs_lookback(&m, map, 1);
+		pblk = m.pblk;
+		break;
+	case Z_EROFS_VLE_CLUSTER_TYPE_NONHEAD:
+		ret = z_erofs_lookback(&m, map, m.delta0);
+		pblk = m.pblk;
+		break;
+	default:
+		return -EIO;
+	}
+	if (ret)
+		return ret;
+
+	/* The extent ends where the next one starts, or at the file end */
+	while (!end && ++lcn < totalidx) {
+		ret = z_erofs_load_cluster(&m, lcn);
+		if (ret)
+			return ret;
+		if (m.type != Z_EROFS_VLE_CLUSTER_TYPE_NONHEAD)
+			end = (lcn << lclusterbits) | m.clusterofs;
+	}
+	if (!end || end > inode->size)
+		end = inode->size;
+	if (end <= map->la)
+		return -EIO;
+
+	map->llen = end - map->la;
+	map->pa = (u64)pblk << erofs_ctxt.blkszbits;
+
+	return 0;
+}
+
+/* Decompress the extent in @map into @out, which holds map->llen bytes */
+static int z_erofs_decompress(const struct z_erofs_map *map, void *out)
+{
+	const u32 plen = 1 << erofs_ctxt.blkszbits;
+	const char *src;
+	u32 inlen;
+	int ret;
+
+	if (!erofs_ctxt.comp_buf) {
+		erofs_ctxt.comp_buf = malloc(plen);
+		if (!erofs_ctxt.comp_buf)
+			return -ENOMEM;
+	}
+
+	ret = erofs_disk_read(map->pa, plen, erofs_ctxt.comp_buf);
+	if (ret)
+		return ret;
+
+	src = erofs_ctxt.comp_buf;
+	inlen = plen;
+	if (le32_to_cpu(erofs_ctxt.sblk.feature_incompat) &
+	    EROFS_FEATURE_INCOMPAT_LZ4_0PADDING) {
+		/* The compressed data is right-aligned in the cluster */
+		while (inlen && !*src) {
+			src++;
+			inlen--;
+		}
+		if (!inlen)
+			return -EIO;
+	}
+
+	ret = LZ4_decompress_safe_partial(src, out, inlen, map->llen,
+					  map->llen);
+	if (ret < 0 || ret < map->llen) {
+		debug("%s: LZ4 error %d at %llx\n", __func__, ret, map->pa);
+		return -EIO;
+	}
+
+	return 0;
+}
+
+int z_erofs_read(struct erofs_inode *inode, void *buf, u64 offset, u64 len)
+{
+	struct z_erofs_map map;
+	u64 n, skip;
+	int ret;
+
+	while (len) {
+		ret = z_erofs_map_blocks(inode, offset, &map);
+		if (ret)
+			return ret;
+
+		skip = offset - map.la;
+		n = min(len, map.llen - skip);
+
+		if (!map.zipped) {
+			if (map.llen > erofs_ctxt.blksz)
+				return -EIO;
+			ret = erofs_disk_read(map.pa + skip, n, buf);
+		} else if (!skip && n == map.llen) {
+			/* Whole extent wanted: decompress in place */
+			ret = z_erofs_decompress(&map, buf);
+		} else {
+			/*
+			 * Partial extent, keep it around since the next read
+			 * usually continues where this one stopped
+			 */
+			if (erofs_ctxt.ext_nid != inode->nid ||
+			    erofs_ctxt.ext_la != map.la ||
+			    erofs_ctxt.ext_len != map.llen) {
+				if (map.llen > erofs_ctxt.ext_buf_size) {
+					free(erofs_ctxt.ext_buf);
+					erofs_ctxt.ext_buf_size = 0;
+					erofs_ctxt.ext_buf = malloc(map.llen);
+					if (!erofs_ctxt.ext_buf)
+						return -ENOMEM;
+					erofs_ctxt.ext_buf_size = map.llen;
+				}
+				erofs_ctxt.ext_len = 0;
+				ret = z_erofs_decompress(&map,
+							 erofs_ctxt.ext_buf);
+				if (ret)
+					return ret;
+				erofs_ctxt.ext_nid = inode->nid;
+				erofs_ctxt.ext_la = map.la;
+				erofs_ctxt.ext_len = map.llen;
+			}
+			memcpy(buf, erofs_ctxt.ext_buf + skip, n);
+		}
+		if (ret)
+			return ret;
+
+		buf += n;
+		offset += n;
+		len -= n;
+	}
+
+	return 0;
+}
@@ -15,10 +15,13 @@
 #include <sandboxfs.h>
 #include <ubifs_uboot.h>
 #include <btrfs.h>
+#include <squashfs.h>
+#include <erofs.h>
 #include <asm/io.h>
 #include <div64.h>
 #include <linux/math64.h>
 #include <efi_loader.h>
+#include <malloc.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -27,6 +30,32 @@ static int fs_dev_part;
 static disk_partition_t fs_partition;
 static int fs_type = FS_TYPE_ANY;
 
+#define FS_MOUNT_MAX	8
+
+/**
+ * struct fs_mount - cached state of a filesystem found on a partition
+ *
+ * @desc:	block device holding the filesystem (NULL for virtual ones)
+ * @part:	partition number on @desc
+ * @fstype:	filesystem type found by the last successful probe
+ * @partition:	partition information @fstype was probed with
+ * @refcnt:	number of open file handles using this mount
+ * @seq:	last use, for picking an entry to recycle
+ */
+struct fs_mount {
+	struct blk_desc *desc;
+	int part;
+	int fstype;
+	disk_partition_t partition;
+	int refcnt;
+	ulong seq;
+};
+
+static struct fs_mount fs_mounts[FS_MOUNT_MAX];
+static ulong fs_mount_seq;
+/* Mount whose driver state is currently live, if any */
+static struct fs_mount *fs_active;
+
 static inline int fs_probe_unsupported(struct blk_desc *fs_dev_desc,
 				      disk_partition_t *fs_partition)
 {
@@ -273,6 +302,48 @@ static struct fstype_info fstypes[] = {
 		.mkdir = fs_mkdir_unsupported,
 		.ln = fs_ln_unsupported,
 	},
+#endif
+#if IS_ENABLED(CONFIG_FS_SQUASHFS)
+	{
+		.fstype = FS_TYPE_SQUASHFS,
+		.name = "squashfs",
+		.null_dev_desc_ok = false,
+		.probe = sqfs_probe,
+		.close = sqfs_close,
+		.ls = fs_ls_generic,
+		.exists = sqfs_exists,
+		.size = sqfs_size,
+		.read = sqfs_read,
+		.write = fs_write_unsupported,
+		.uuid = fs_uuid_unsupported,
+		.opendir = sqfs_opendir,
+		.readdir = sqfs_readdir,
+		.closedir = sqfs_closedir,
+		.unlink = fs_unlink_unsupported,
+		.mkdir = fs_mkdir_unsupported,
+		.ln = fs_ln_unsupported,
+	},
+#endif
+#if IS_ENABLED(CONFIG_FS_EROFS)
+	{
+		.fstype = FS_TYPE_EROFS,
+		.name = "erofs",
+		.null_dev_desc_ok = false,
+		.probe = erofs_probe,
+		.close = erofs_close,
+		.ls = fs_ls_generic,
+		.exists = erofs_exists,
+		.size = erofs_size,
+		.read = erofs_read,
+		.write = fs_write_unsupported,
+		.uuid = erofs_uuid,
+		.opendir = erofs_opendir,
+		.readdir = erofs_readdir,
+		.closedir = erofs_closedir,
+		.unlink = fs_unlink_unsupported,
+		.mkdir = fs_mkdir_unsupported,
+		.ln = fs_ln_unsupported,
+	},
 #endif
 	{
 		.fstype = FS_TYPE_ANY,
@@ -333,31 +404,84 @@ const char *fs_get_type_name(void)
 	return fs_get_info(fs_type)->name;
 }
 
-int fs_set_blk_dev(const char *ifname, const char *dev_part_str, int fstype)
+static struct fs_mount *fs_mount_find(struct blk_desc *desc, int part,
+				       int fstype)
 {
-	struct fstype_info *info;
-	int part, i;
-#ifdef CONFIG_NEEDS_MANUAL_RELOC
-	static int relocated;
+	struct fs_mount *mnt;
 
-	if (!relocated) {
-		for (i = 0, info = fstypes; i < ARRAY_SIZE(fstypes);
-				i++, info++) {
-			info->name += gd->reloc_off;
-			info->probe += gd->reloc_off;
-			info->close += gd->reloc_off;
-			info->ls += gd->reloc_off;
-			info->read += gd->reloc_off;
-			info->write += gd->reloc_off;
+	for (mnt = fs_mounts; mnt < fs_mounts + FS_MOUNT_MAX; mnt++) {
+		if (mnt->fstype == FS_TYPE_ANY || mnt->desc != desc ||
+		    mnt->part != part)
+			continue;
+		if (fstype != FS_TYPE_ANY && mnt->fstype != fstype)
+			continue;
+		mnt->seq = ++fs_mount_seq;
+		return mnt;
+	}
+
+	return NULL;
+}
+
+/*
+ * Record the filesystem which has just been probed on the current block
+ * device, recycling the least recently used mount without open files.
+ */
+static struct fs_mount *fs_mount_update(void)
+{
+	struct fs_mount *mnt, *victim = NULL;
+
+	mnt = fs_mount_find(fs_dev_desc, fs_dev_part, fs_type);
+	if (!mnt) {
+		/* Forget a different type seen on this partition before */
+		mnt = fs_mount_find(fs_dev_desc, fs_dev_part, FS_TYPE_ANY);
+		if (mnt && !mnt->refcnt)
+			mnt->fstype = FS_TYPE_ANY;
+
+		for (mnt = fs_mounts; mnt < fs_mounts + FS_MOUNT_MAX; mnt++) {
+			if (mnt->refcnt)
+				continue;
+			if (!victim || mnt->seq < victim->seq)
+				victim = mnt;
 		}
-		relocated = 1;
+		if (!victim)
+			return NULL;
+
+		mnt = victim;
+		mnt->desc = fs_dev_desc;
+		mnt->part = fs_dev_part;
+		mnt->fstype = fs_type;
+		mnt->seq = ++fs_mount_seq;
 	}
-#endif
+	mnt->partition = fs_partition;
 
-	part = blk_get_device_part_str(ifname, dev_part_str, &fs_dev_desc,
-					&fs_partition, 1);
-	if (part < 0)
-		return -1;
+	return mnt;
+}
+
+/*
+ * Identify the filesystem in fs_partition of fs_dev_desc. A filesystem type
+ * which was found on the same partition before is tried first, so that a
+ * repeated command does not have to go through every driver's probe.
+ */
+static int fs_probe(int fstype, int part)
+{
+	struct fstype_info *info;
+	struct fs_mount *mnt;
+	int i;
+
+	if (fs_dev_desc) {
+		mnt = fs_mount_find(fs_dev_desc, part, fstype);
+		if (mnt) {
+			info = fs_get_info(mnt->fstype);
+			if (!info->probe(fs_dev_desc, &fs_partition)) {
+				fs_type = info->fstype;
+				fs_dev_part = part;
+				mnt->partition = fs_partition;
+				return 0;
+			}
+			if (!mnt->refcnt)
+				mnt->fstype = FS_TYPE_ANY;
+		}
+	}
 
 	for (i = 0, info = fstypes; i < ARRAY_SIZE(fstypes); i++, info++) {
 		if (fstype != FS_TYPE_ANY && info->fstype != FS_TYPE_ANY &&
@@ -370,6 +494,8 @@ int fs_set_blk_dev(const char *ifname, const char *dev_part_str, int fstype)
 		if (!info->probe(fs_dev_desc, &fs_partition)) {
 			fs_type = info->fstype;
 			fs_dev_part = part;
+			if (fs_dev_desc && fs_type != FS_TYPE_ANY)
+				fs_mount_update();
 			return 0;
 		}
 	}
@@ -377,29 +503,83 @@ int fs_set_blk_dev(const char *ifname, const char *dev_part_str, int fstype)
 	return -1;
 }
 
+/*
+ * Is the filesystem on @part of @desc the one whose driver state is live?
+ * Then it does not have to be probed again.
+ */
+static bool fs_mount_live(struct blk_desc *desc, int part,
+			  disk_partition_t *info, int fstype)
+{
+	return fs_active && fs_type == fs_active->fstype &&
+	       fs_active->desc == desc && fs_active->part == part &&
+	       fs_active->partition.start == info->start &&
+	       fs_active->partition.size == info->size &&
+	       (fstype == FS_TYPE_ANY || fstype == fs_type);
+}
+
+int fs_set_blk_dev(const char *ifname, const char *dev_part_str, int fstype)
+{
+	struct blk_desc *desc;
+	disk_partition_t info;
+	int part;
+#ifdef CONFIG_NEEDS_MANUAL_RELOC
+	static int relocated;
+
+	if (!relocated) {
+		struct fstype_info *info;
+		int i;
+
+		for (i = 0, info = fstypes; i < ARRAY_SIZE(fstypes);
+				i++, info++) {
+			info->name += gd->reloc_off;
+			info->probe += gd->reloc_off;
+			info->close += gd->reloc_off;
+			info->ls += gd->reloc_off;
+			info->read += gd->reloc_off;
+			info->write += gd->reloc_off;
+		}
+		relocated = 1;
+	}
+#endif
+
+	part = blk_get_device_part_str(ifname, dev_part_str, &desc, &info, 1);
+	if (part >= 0 && fs_mount_live(desc, part, &info, fstype))
+		return 0;
+
+	/* Drop driver state kept alive for open file handles */
+	if (fs_type != FS_TYPE_ANY)
+		fs_close();
+
+	if (part < 0)
+		return -1;
+	fs_dev_desc = desc;
+	fs_partition = info;
+
+	return fs_probe(fstype, part);
+}
+
 /* set current blk device w/ blk_desc + partition # */
 int fs_set_blk_dev_with_part(struct blk_desc *desc, int part)
 {
-	struct fstype_info *info;
-	int ret, i;
+	disk_partition_t info;
+	int ret;
 
 	if (part >= 1)
-		ret = part_get_info(desc, part, &fs_partition);
+		ret = part_get_info(desc, part, &info);
 	else
-		ret = part_get_info_whole_disk(desc, &fs_partition);
+		ret = part_get_info_whole_disk(desc, &info);
+	if (!ret && fs_mount_live(desc, part, &info, FS_TYPE_ANY))
+		return 0;
+
+	if (fs_type != FS_TYPE_ANY)
+		fs_close();
+
 	if (ret)
 		return ret;
 	fs_dev_desc = desc;
+	fs_partition = info;
 
-	for (i = 0, info = fstypes; i < ARRAY_SIZE(fstypes); i++, info++) {
-		if (!info->probe(fs_dev_desc, &fs_partition)) {
-			fs_type = info->fstype;
-			fs_dev_part = part;
-			return 0;
-		}
-	}
-
-	return -1;
+	return fs_probe(FS_TYPE_ANY, part);
 }
 
 void fs_close(void)
@@ -409,6 +589,17 @@ void fs_close(void)
 	info->close();
 
 	fs_type = FS_TYPE_ANY;
+	fs_active = NULL;
+}
+
+/*
+ * Done with the current filesystem. Its driver state stays live while files
+ * opened with fs_open() use it.
+ */
+static void fs_release(void)
+{
+	if (!fs_active || !fs_active->refcnt)
+		fs_close();
 }
 
 int fs_uuid(char *uuid_str)
@@ -426,7 +617,7 @@ int fs_ls(const char *dirname)
 
 	ret = info->ls(dirname);
 
-	fs_close();
+	fs_release();
 
 	return ret;
 }
@@ -439,7 +630,7 @@ int fs_exists(const char *filename)
 
 	ret = info->exists(filename);
 
-	fs_close();
+	fs_release();
 
 	return ret;
 }
@@ -452,25 +643,19 @@ int fs_size(const char *filename, loff_t *size)
 
 	ret = info->size(filename, size);
 
-	fs_close();
+	fs_release();
 
 	return ret;
 }
 
 #ifdef CONFIG_LMB
 /* Check if a file may be read to the given address */
-static int fs_read_lmb_check(const char *filename, ulong addr, loff_t offset,
-			     loff_t len, struct fstype_info *info)
+static int fs_read_lmb_check(ulong addr, loff_t offset, loff_t len,
+			     loff_t size)
 {
 	struct lmb lmb;
-	int ret;
-	loff_t size;
 	loff_t read_len;
 
-	/* get the actual size of the file */
-	ret = info->size(filename, &size);
-	if (ret)
-		return ret;
 	if (offset >= size) {
 		/* offset >= EOF, no bytes will be written */
 		return 0;
@@ -492,21 +677,13 @@ static int fs_read_lmb_check(const char *filename, ulong addr, loff_t offset,
 }
 #endif
 
-static int _fs_read(const char *filename, ulong addr, loff_t offset, loff_t len,
-		    int do_lmb_check, loff_t *actread)
+int fs_read(const char *filename, ulong addr, loff_t offset, loff_t len,
+	    loff_t *actread)
 {
 	struct fstype_info *info = fs_get_info(fs_type);
 	void *buf;
 	int ret;
 
-#ifdef CONFIG_LMB
-	if (do_lmb_check) {
-		ret = fs_read_lmb_check(filename, addr, offset, len, info);
-		if (ret)
-			return ret;
-	}
-#endif
-
 	/*
 	 * We don't actually know how many bytes are being read, since len==0
 	 * means read the whole file.
@@ -518,15 +695,95 @@ static int _fs_read(const char *filename, ulong addr, loff_t offset, loff_t len,
 	/* If we requested a specific number of bytes, check we got it */
 	if (ret == 0 && len && *actread != len)
 		debug("** %s shorter than offset + len **\n", filename);
-	fs_close();
+	fs_release();
 
 	return ret;
 }
 
-int fs_read(const char *filename, ulong addr, loff_t offset, loff_t len,
-	    loff_t *actread)
+/* Make the driver state of @mnt live again, unless it still is */
+static int fs_mount_activate(struct fs_mount *mnt)
 {
-	return _fs_read(filename, addr, offset, len, 0, actread);
+	struct fstype_info *info;
+
+	if (fs_active == mnt && fs_type == mnt->fstype)
+		return 0;
+
+	if (fs_type != FS_TYPE_ANY)
+		fs_close();
+
+	fs_dev_desc = mnt->desc;
+	fs_partition = mnt->partition;
+	info = fs_get_info(mnt->fstype);
+	if (info->probe(fs_dev_desc, &fs_partition))
+		return -ENODEV;
+
+	fs_type = mnt->fstype;
+	fs_dev_part = mnt->part;
+	fs_active = mnt;
+
+	return 0;
+}
+
+struct fs_file *fs_open(const char *filename)
+{
+	struct fstype_info *info = fs_get_info(fs_type);
+	struct fs_mount *mnt;
+	struct fs_file *file;
+	loff_t size;
+
+	if (fs_type == FS_TYPE_ANY || info->size(filename, &size)) {
+		fs_release();
+		errno = ENOENT;
+		return NULL;
+	}
+
+	mnt = fs_mount_find(fs_dev_desc, fs_dev_part, fs_type);
+	if (!mnt)
+		mnt = fs_mount_update();
+	file = mnt ? malloc(sizeof(*file) + strlen(filename) + 1) : NULL;
+	if (!file) {
+		fs_release();
+		errno = mnt ? ENOMEM : EMFILE;
+		return NULL;
+	}
+
+	mnt->partition = fs_partition;
+	mnt->refcnt++;
+	fs_active = mnt;
+
+	file->mnt = mnt;
+	file->size = size;
+	strcpy(file->path, filename);
+
+	return file;
+}
+
+int fs_pread(struct fs_file *file, void *buf, loff_t offset, loff_t len,
+	     loff_t *actread)
+{
+	struct fstype_info *info;
+	int ret;
+
+	ret = fs_mount_activate(file->mnt);
+	if (ret)
+		return ret;
+
+	info = fs_get_info(fs_type);
+	ret = info->read(file->path, buf, offset, len, actread);
+	if (ret == 0 && len && *actread != len)
+		debug("** %s shorter than offset + len **\n", file->path);
+
+	return ret;
+}
+
+void fs_file_close(struct fs_file *file)
+{
+	if (!file)
+		return;
+
+	if (!--file->mnt->refcnt && fs_active == file->mnt)
+		fs_close();
+	free(file);
 }
 
 int fs_write(const char *filename, ulong addr, loff_t offset, loff_t len,
@@ -544,7 +801,7 @@ int fs_write(const char *filename, ulong addr, loff_t offset, loff_t len,
 		printf("** Unable to write file %s **\n", filename);
 		ret = -1;
 	}
-	fs_close();
+	fs_release();
 
 	return ret;
 }
@@ -556,7 +813,7 @@ struct fs_dir_stream *fs_opendir(const char *filename)
 	int ret;
 
 	ret = info->opendir(filename, &dirs);
-	fs_close();
+	fs_release();
 	if (ret) {
 		errno = -ret;
 		return NULL;
@@ -578,7 +835,7 @@ struct fs_dirent *fs_readdir(struct fs_dir_stream *dirs)
 	info = fs_get_info(fs_type);
 
 	ret = info->readdir(dirs, &dirent);
-	fs_close();
+	fs_release();
 	if (ret) {
 		errno = -ret;
 		return NULL;
@@ -598,7 +855,7 @@ void fs_closedir(struct fs_dir_stream *dirs)
 	info = fs_get_info(fs_type);
 
 	info->closedir(dirs);
-	fs_close();
+	fs_release();
 }
 
 int fs_unlink(const char *filename)
@@ -609,7 +866,7 @@ int fs_unlink(const char *filename)
 
 	ret = info->unlink(filename);
 
-	fs_close();
+	fs_release();
 
 	return ret;
 }
@@ -622,7 +879,7 @@ int fs_mkdir(const char *dirname)
 
 	ret = info->mkdir(dirname);
 
-	fs_close();
+	fs_release();
 
 	return ret;
 }
@@ -638,7 +895,7 @@ int fs_ln(const char *fname, const char *target)
 		printf("** Unable to create link %s -> %s **\n", fname, target);
 		ret = -1;
 	}
-	fs_close();
+	fs_release();
 
 	return ret;
 }
@@ -668,9 +925,11 @@ int do_load(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[],
 	unsigned long addr;
 	const char *addr_str;
 	const char *filename;
+	struct fs_file *file;
 	loff_t bytes;
 	loff_t pos;
 	loff_t len_read;
+	void *buf;
 	int ret;
 	unsigned long time;
 	char *ep;
@@ -717,18 +976,31 @@ int do_load(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[],
 			(argc > 4) ? argv[4] : "");
 #endif
 	time = get_timer(0);
-	ret = _fs_read(filename, addr, pos, bytes, 1, &len_read);
+	file = fs_open(filename);
+	if (!file)
+		return 1;
+
+#ifdef CONFIG_LMB
+	ret = fs_read_lmb_check(addr, pos, bytes, file->size);
+	if (ret) {
+		fs_file_close(file);
+		return 1;
+	}
+#endif
+
+	/*
+	 * We don't actually know how many bytes are being read, since len==0
+	 * means read the whole file.
+	 */
+	buf = map_sysmem(addr, bytes);
+	ret = fs_pread(file, buf, pos, bytes, &len_read);
+	unmap_sysmem(buf);
+	fs_file_close(file);
 	time = get_timer(time);
 	if (ret < 0)
 		return 1;
 
-	printf("%llu bytes read in %lu ms", len_read, time);
-	if (time > 0) {
-		puts(" (");
-		print_size(div_u64(len_read, time) * 1000, "/s");
-		puts(")");
-	}
-	puts("\n");
+	print_read_time(len_read, time);
 
 	env_set_hex("fileaddr", addr);
 	env_set_hex("filesize", len_read);
@@ -846,7 +1118,7 @@ int do_fs_type(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 	else
 		printf("%s\n", info->name);
 
-	fs_close();
+	fs_release();
 
 	return CMD_RET_SUCCESS;
 }
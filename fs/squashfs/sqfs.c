@@ -0,0 +1,796 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * SquashFS filesystem implementation for U-Boot
+ *
+ * Read-only support for SquashFS 4.0 images. Metadata (inodes, directories,
+ * fragment table) and fragment blocks are kept decompressed in small LRU
+ * caches for as long as the image is mounted, so that walking a path or
+ * reading the tails of several files does not decompress the same block
+ * over and over again.
+ */
+
+#include <common.h>
+#include <errno.h>
+#include <fs.h>
+#include <fs_internal.h>
+#include <malloc.h>
+#include <squashfs.h>
+#include <asm/unaligned.h>
+#include <linux/kernel.h>
+#include <linux/sizes.h>
+
+#include "sqfs_decompressor.h"
+#include "sqfs_internal.h"
+
+#define SQFS_MAX_SYMLINKS	8
+#define SQFS_MAX_DEPTH		64
+#define SQFS_NAME_LEN		256
+#define SQFS_DIR_MAX_ENTRIES	256
+
+static struct squashfs_ctxt ctxt;
+
+/* Position in a metadata table: disk offset of a block, offset within it */
+struct sqfs_meta_pos {
+	u64 block;
+	u32 offset;
+};
+
+/* Decoded inode, only the fields this driver needs */
+struct sqfs_inode {
+	u16 type;
+	u64 file_size;
+	/* directories */
+	u32 dir_block;
+	u16 dir_offset;
+	/* regular files */
+	u64 start_block;
+	u32 fragment;
+	u32 frag_offset;
+	/* block list of regular files, target of symlinks */
+	struct sqfs_meta_pos data;
+};
+
+struct sqfs_dir_iter {
+	struct sqfs_meta_pos pos;
+	u32 remaining;
+	u32 entries;
+	u32 start;
+};
+
+struct squashfs_dir_stream {
+	struct fs_dir_stream fs_dirs;
+	struct fs_dirent dirent;
+	struct sqfs_dir_iter iter;
+};
+
+static int sqfs_disk_read(u64 offset, u32 len, void *buf)
+{
+	struct blk_desc *dev = ctxt.cur_dev;
+
+	if (!fs_devread(dev, &ctxt.cur_part_info, offset >> dev->log2blksz,
+			offset & (dev->blksz - 1), len, buf))
+		return -EIO;
+
+	return 0;
+}
+
+static struct sqfs_cache_entry *sqfs_cache_find(struct sqfs_cache_entry *cache,
+						int count, u64 key)
+{
+	int i;
+
+	for (i = 0; i < count; i++) {
+		if (cache[i].len && cache[i].key == key) {
+			cache[i].seq = ++ctxt.cache_seq;
+			return &cache[i];
+		}
+	}
+
+	return NULL;
+}
+
+static struct sqfs_cache_entry *sqfs_cache_victim(struct sqfs_cache_entry *cache,
+						  int count, u32 size)
+{
+	struct sqfs_cache_entry *victim = &cache[0];
+	int i;
+
+	for (i = 1; i < count; i++) {
+		if (cache[i].seq < victim->seq)
+			victim = &cache[i];
+	}
+
+	victim->len = 0;
+	if (!victim->data) {
+		victim->data = malloc(size);
+		if (!victim->data)
+			return NULL;
+	}
+	victim->seq = ++ctxt.cache_seq;
+
+	return victim;
+}
+
+static void sqfs_cache_free(struct sqfs_cache_entry *cache, int count)
+{
+	int i;
+
+	for (i = 0; i < count; i++) {
+		free(cache[i].data);
+		cache[i].data = NULL;
+		cache[i].len = 0;
+	}
+}
+
+/* Read and decompress the metadata block at disk offset @start */
+static struct sqfs_cache_entry *sqfs_read_metablock(u64 start)
+{
+	struct sqfs_cache_entry *entry;
+	unsigned long len;
+	u64 image_size;
+	u32 disk_len;
+	u16 hdr;
+
+	entry = sqfs_cache_find(ctxt.meta_cache, SQFS_META_CACHE_ENTRIES,
+				start);
+	if (entry)
+		return entry;
+
+	image_size = le64_to_cpu(ctxt.sblk.bytes_used);
+	if (start + SQFS_METADATA_HDR_SIZE > image_size)
+		return NULL;
+
+	entry = sqfs_cache_victim(ctxt.meta_cache, SQFS_META_CACHE_ENTRIES,
+				  SQFS_METADATA_SIZE);
+	if (!entry)
+		return NULL;
+
+	/* Fetch header and block in one go, the block is at most 8 KiB */
+	disk_len = min_t(u64, image_size - start,
+			 SQFS_METADATA_HDR_SIZE + SQFS_METADATA_SIZE);
+	if (sqfs_disk_read(start, disk_len, ctxt.comp_buf))
+		return NULL;
+
+	hdr = get_unaligned_le16(ctxt.comp_buf);
+	len = SQFS_METADATA_LEN(hdr);
+	if (!len || len > disk_len - SQFS_METADATA_HDR_SIZE)
+		return NULL;
+
+	if (hdr & SQFS_METADATA_UNCOMPRESSED) {
+		memcpy(entry->data, ctxt.comp_buf + SQFS_METADATA_HDR_SIZE, len);
+		entry->len = len;
+	} else {
+		unsigned long out_len = SQFS_METADATA_SIZE;
+
+		if (sqfs_decompress(&ctxt, entry->data, &out_len,
+				    ctxt.comp_buf + SQFS_METADATA_HDR_SIZE,
+				    len) || !out_len)
+			return NULL;
+		entry->len = out_len;
+	}
+
+	entry->key = start;
+	entry->next = start + SQFS_METADATA_HDR_SIZE + len;
+
+	return entry;
+}
+
+/* Copy @len bytes of a metadata table starting at @pos, advancing @pos */
+static int sqfs_read_meta(struct sqfs_meta_pos *pos, void *buf, u32 len)
+{
+	struct sqfs_cache_entry *entry;
+	u32 n;
+
+	while (len) {
+		entry = sqfs_read_metablock(pos->block);
+		if (!entry || pos->offset >= entry->len)
+			return -EIO;
+
+		n = min(len, entry->len - pos->offset);
+		memcpy(buf, entry->data + pos->offset, n);
+		buf += n;
+		len -= n;
+		pos->offset += n;
+
+		if (pos->offset == entry->len) {
+			pos->block = entry->next;
+			pos->offset = 0;
+		}
+	}
+
+	return 0;
+}
+
+static int sqfs_read_inode(u64 ref, struct sqfs_inode *inode)
+{
+	union {
+		struct squashfs_base_inode base;
+		struct squashfs_dir_inode dir;
+		struct squashfs_ldir_inode ldir;
+		struct squashfs_reg_inode reg;
+		struct squashfs_lreg_inode lreg;
+		struct squashfs_symlink_inode symlink;
+	} raw;
+	struct sqfs_meta_pos pos;
+	size_t size;
+	int ret;
+
+	pos.block = le64_to_cpu(ctxt.sblk.inode_table_start) +
+		    SQFS_REF_BLOCK(ref);
+	pos.offset = SQFS_REF_OFFSET(ref);
+
+	ret = sqfs_read_meta(&pos, &raw.base, sizeof(raw.base));
+	if (ret)
+		return ret;
+
+	memset(inode, 0, sizeof(*inode));
+	inode->type = le16_to_cpu(raw.base.inode_type);
+	inode->fragment = SQFS_INVALID_FRAG;
+
+	switch (inode->type) {
+	case SQFS_DIR_TYPE:
+		size = sizeof(raw.dir);
+		break;
+	case SQFS_LDIR_TYPE:
+		size = sizeof(raw.ldir);
+		break;
+	case SQFS_REG_TYPE:
+		size = sizeof(raw.reg);
+		break;
+	case SQFS_LREG_TYPE:
+		size = sizeof(raw.lreg);
+		break;
+	case SQFS_SYMLINK_TYPE:
+	case SQFS_LSYMLINK_TYPE:
+		size = sizeof(raw.symlink);
+		break;
+	default:
+		/* Devices, FIFOs and sockets have no contents to read */
+		return 0;
+	}
+
+	ret = sqfs_read_meta(&pos, (u8 *)&raw + sizeof(raw.base),
+			     size - sizeof(raw.base));
+	if (ret)
+		return ret;
+	inode->data = pos;
+
+	switch (inode->type) {
+	case SQFS_DIR_TYPE:
+		inode->file_size = le16_to_cpu(raw.dir.file_size);
+		inode->dir_block = le32_to_cpu(raw.dir.start_block);
+		inode->dir_offset = le16_to_cpu(raw.dir.offset);
+		break;
+	case SQFS_LDIR_TYPE:
+		inode->file_size = le32_to_cpu(raw.ldir.file_size);
+		inode->dir_block = le32_to_cpu(raw.ldir.start_block);
+		inode->dir_offset = le16_to_cpu(raw.ldir.offset);
+		break;
+	case SQFS_REG_TYPE:
+		inode->file_size = le32_to_cpu(raw.reg.file_size);
+		inode->start_block = le32_to_cpu(raw.reg.start_block);
+		inode->fragment = le32_to_cpu(raw.reg.fragment);
+		inode->frag_offset = le32_to_cpu(raw.reg.offset);
+		break;
+	case SQFS_LREG_TYPE:
+		inode->file_size = le64_to_cpu(raw.lreg.file_size);
+		inode->start_block = le64_to_cpu(raw.lreg.start_block);
+		inode->fragment = le32_to_cpu(raw.lreg.fragment);
+		inode->frag_offset = le32_to_cpu(raw.lreg.offset);
+		break;
+	default:
+		inode->file_size = le32_to_cpu(raw.symlink.symlink_size);
+		break;
+	}
+
+	return 0;
+}
+
+static bool sqfs_inode_is_dir(const struct sqfs_inode *inode)
+{
+	return inode->type == SQFS_DIR_TYPE || inode->type == SQFS_LDIR_TYPE;
+}
+
+static bool sqfs_inode_is_reg(const struct sqfs_inode *inode)
+{
+	return inode->type == SQFS_REG_TYPE || inode->type == SQFS_LREG_TYPE;
+}
+
+static bool sqfs_inode_is_symlink(const struct sqfs_inode *inode)
+{
+	return inode->type == SQFS_SYMLINK_TYPE ||
+	       inode->type == SQFS_LSYMLINK_TYPE;
+}
+
+static void sqfs_dir_init(const struct sqfs_inode *dir,
+			  struct sqfs_dir_iter *iter)
+{
+	iter->pos.block = le64_to_cpu(ctxt.sblk.directory_table_start) +
+			  dir->dir_block;
+	iter->pos.offset = dir->dir_offset;
+	/* The listing size accounts for the implicit "." and ".." entries */
+	iter->remaining = dir->file_size > 3 ? dir->file_size - 3 : 0;
+	iter->entries = 0;
+	iter->start = 0;
+}
+
+/*
+ * Fetch the next directory entry into @name (SQFS_NAME_LEN + 1 bytes).
+ * Return 1 if an entry was found, 0 at the end of the directory or a
+ * negative error code.
+ */
+static int sqfs_dir_next(struct sqfs_dir_iter *iter, char *name, u16 *type,
+			 u64 *ref)
+{
+	struct squashfs_directory_entry entry;
+	u32 name_len;
+	int ret;
+
+	if (!iter->entries) {
+		struct squashfs_directory_header hdr;
+
+		if (iter->remaining < sizeof(hdr))
+			return 0;
+		ret = sqfs_read_meta(&iter->pos, &hdr, sizeof(hdr));
+		if (ret)
+			return ret;
+		iter->remaining -= sizeof(hdr);
+		iter->entries = le32_to_cpu(hdr.count) + 1;
+		iter->start = le32_to_cpu(hdr.start);
+		if (iter->entries > SQFS_DIR_MAX_ENTRIES)
+			return -EIO;
+	}
+
+	if (iter->remaining < sizeof(entry))
+		return -EIO;
+	ret = sqfs_read_meta(&iter->pos, &entry, sizeof(entry));
+	if (ret)
+		return ret;
+	iter->remaining -= sizeof(entry);
+
+	name_len = le16_to_cpu(entry.name_size) + 1;
+	if (name_len > SQFS_NAME_LEN || name_len > iter->remaining)
+		return -EIO;
+	ret = sqfs_read_meta(&iter->pos, name, name_len);
+	if (ret)
+		return ret;
+	name[name_len] = '\0';
+	iter->remaining -= name_len;
+	iter->entries--;
+
+	*type = le16_to_cpu(entry.type);
+	*ref = ((u64)iter->start << 16) | le16_to_cpu(entry.offset);
+
+	return 1;
+}
+
+static int sqfs_dir_find(const struct sqfs_inode *dir, const char *name,
+			 u64 *ref)
+{
+	char entry_name[SQFS_NAME_LEN + 1];
+	struct sqfs_dir_iter iter;
+	int ret, cmp;
+	u16 type;
+
+	sqfs_dir_init(dir, &iter);
+	while ((ret = sqfs_dir_next(&iter, entry_name, &type, ref)) > 0) {
+		cmp = strcmp(entry_name, name);
+		if (!cmp)
+			return 0;
+		/* mksquashfs sorts directory entries by name */
+		if (cmp > 0)
+			break;
+	}
+
+	return ret < 0 ? ret : -ENOENT;
+}
+
+/* Resolve @filename to an inode, following symbolic links on the way */
+static int sqfs_lookup(const char *filename, struct sqfs_inode *inode)
+{
+	u64 stack[SQFS_MAX_DEPTH];
+	int depth = 0, links = 0;
+	char *path, *p, *name, *target;
+	u64 ref;
+	int ret;
+
+	path = strdup(filename);
+	if (!path)
+		return -ENOMEM;
+
+	stack[0] = le64_to_cpu(ctxt.sblk.root_inode);
+	ret = sqfs_read_inode(stack[0], inode);
+
+	p = path;
+	while (!ret) {
+		while (*p == '/')
+			p++;
+		if (!*p)
+			break;
+
+		name = p;
+		p = (char *)strchrnul(p, '/');
+		if (*p)
+			*p++ = '\0';
+
+		if (!strcmp(name, "."))
+			continue;
+		if (!strcmp(name, "..")) {
+			if (depth)
+				depth--;
+			ret = sqfs_read_inode(stack[depth], inode);
+			continue;
+		}
+
+		if (!sqfs_inode_is_dir(inode)) {
+			ret = -ENOTDIR;
+			break;
+		}
+		ret = sqfs_dir_find(inode, name, &ref);
+		if (!ret)
+			ret = sqfs_read_inode(ref, inode);
+		if (ret)
+			break;
+
+		if (sqfs_inode_is_symlink(inode)) {
+			if (++links > SQFS_MAX_SYMLINKS) {
+				ret = -ELOOP;
+				break;
+			}
+
+			/* Continue with the link target followed by the rest */
+			target = malloc(inode->file_size + strlen(p) + 2);
+			if (!target) {
+				ret = -ENOMEM;
+				break;
+			}
+			ret = sqfs_read_meta(&inode->data, target,
+					     inode->file_size);
+			if (ret) {
+				free(target);
+				break;
+			}
+			target[inode->file_size] = '/';
+			strcpy(target + inode->file_size + 1, p);
+			free(path);
+			path = target;
+			p = path;
+
+			if (*p == '/')
+				depth = 0;
+			ret = sqfs_read_inode(stack[depth], inode);
+			continue;
+		}
+
+		if (sqfs_inode_is_dir(inode)) {
+			if (depth + 1 >= SQFS_MAX_DEPTH) {
+				ret = -ENAMETOOLONG;
+				break;
+			}
+			stack[++depth] = ref;
+		}
+	}
+
+	free(path);
+
+	return ret;
+}
+
+/* Read a data or fragment block of @size (block list format) into @dest */
+static int sqfs_read_block(u64 start, u32 size, void *dest,
+			   unsigned long *dest_len)
+{
+	u32 disk_len = SQFS_BLOCK_LEN(size);
+	int ret;
+
+	if (!disk_len || disk_len > ctxt.block_size)
+		return -EIO;
+
+	if (size & SQFS_BLOCK_UNCOMPRESSED) {
+		if (disk_len > *dest_len)
+			return -EIO;
+		*dest_len = disk_len;
+		return sqfs_disk_read(start, disk_len, dest);
+	}
+
+	ret = sqfs_disk_read(start, disk_len, ctxt.comp_buf);
+	if (ret)
+		return ret;
+
+	return sqfs_decompress(&ctxt, dest, dest_len, ctxt.comp_buf, disk_len);
+}
+
+static struct sqfs_cache_entry *sqfs_read_fragment(u32 index)
+{
+	struct squashfs_fragment_block_entry frag;
+	struct sqfs_cache_entry *entry;
+	struct sqfs_meta_pos pos;
+	unsigned long len;
+
+	entry = sqfs_cache_find(ctxt.frag_cache, SQFS_FRAG_CACHE_ENTRIES,
+				index);
+	if (entry)
+		return entry;
+
+	if (index >= le32_to_cpu(ctxt.sblk.fragments))
+		return NULL;
+
+	pos.block = le64_to_cpu(ctxt.frag_index[index /
+						SQFS_FRAGMENTS_PER_BLOCK]);
+	pos.offset = (index % SQFS_FRAGMENTS_PER_BLOCK) * sizeof(frag);
+	if (sqfs_read_meta(&pos, &frag, sizeof(frag)))
+		return NULL;
+
+	entry = sqfs_cache_victim(ctxt.frag_cache, SQFS_FRAG_CACHE_ENTRIES,
+				  ctxt.block_size);
+	if (!entry)
+		return NULL;
+
+	len = ctxt.block_size;
+	if (sqfs_read_block(le64_to_cpu(frag.start), le32_to_cpu(frag.size),
+			    entry->data, &len))
+		return NULL;
+
+	entry->key = index;
+	entry->len = len;
+
+	return entry;
+}
+
+int sqfs_probe(struct blk_desc *fs_dev_desc, disk_partition_t *fs_partition)
+{
+	u32 block_size, fragments;
+	int ret;
+
+	ctxt.cur_dev = fs_dev_desc;
+	ctxt.cur_part_info = *fs_partition;
+
+	ret = sqfs_disk_read(0, sizeof(ctxt.sblk), &ctxt.sblk);
+	if (ret)
+		goto error;
+
+	block_size = le32_to_cpu(ctxt.sblk.block_size);
+	if (le32_to_cpu(ctxt.sblk.s_magic) != SQFS_MAGIC ||
+	    le16_to_cpu(ctxt.sblk.s_major) != SQFS_MAJOR ||
+	    block_size < SZ_4K || block_size > SZ_1M ||
+	    block_size != 1 << le16_to_cpu(ctxt.sblk.block_log)) {
+		ret = -EINVAL;
+		goto error;
+	}
+	ctxt.block_size = block_size;
+
+	ret = sqfs_decompressor_init(&ctxt);
+	if (ret)
+		goto error;
+
+	ret = -ENOMEM;
+	ctxt.comp_buf = malloc(max_t(u32, block_size, SQFS_METADATA_HDR_SIZE +
+				     SQFS_METADATA_SIZE));
+	ctxt.data_buf = malloc(block_size);
+	if (!ctxt.comp_buf || !ctxt.data_buf)
+		goto error;
+
+	fragments = le32_to_cpu(ctxt.sblk.fragments);
+	if (fragments) {
+		u32 len = DIV_ROUND_UP(fragments, SQFS_FRAGMENTS_PER_BLOCK) *
+			  sizeof(*ctxt.frag_index);
+
+		ctxt.frag_index = malloc(len);
+		if (!ctxt.frag_index)
+			goto error;
+		ret = sqfs_disk_read(le64_to_cpu(ctxt.sblk.fragment_table_start),
+				     len, ctxt.frag_index);
+		if (ret)
+			goto error;
+	}
+
+	return 0;
+
+error:
+	sqfs_close();
+
+	return ret;
+}
+
+int sqfs_opendir(const char *filename, struct fs_dir_stream **dirsp)
+{
+	struct squashfs_dir_stream *dirs;
+	struct sqfs_inode inode;
+	int ret;
+
+	ret = sqfs_lookup(filename, &inode);
+	if (ret)
+		return ret;
+	if (!sqfs_inode_is_dir(&inode))
+		return -ENOTDIR;
+
+	dirs = calloc(1, sizeof(*dirs));
+	if (!dirs)
+		return -ENOMEM;
+	sqfs_dir_init(&inode, &dirs->iter);
+	*dirsp = &dirs->fs_dirs;
+
+	return 0;
+}
+
+int sqfs_readdir(struct fs_dir_stream *fs_dirs, struct fs_dirent **dentp)
+{
+	struct squashfs_dir_stream *dirs;
+	char name[SQFS_NAME_LEN + 1];
+	struct sqfs_inode inode;
+	u16 type;
+	u64 ref;
+	int ret;
+
+	dirs = container_of(fs_dirs, struct squashfs_dir_stream, fs_dirs);
+	ret = sqfs_dir_next(&dirs->iter, name, &type, &ref);
+	if (ret <= 0)
+		return ret ? ret : -ENOENT;
+
+	ret = sqfs_read_inode(ref, &inode);
+	if (ret)
+		return ret;
+
+	memset(&dirs->dirent, 0, sizeof(dirs->dirent));
+	strlcpy(dirs->dirent.name, name, sizeof(dirs->dirent.name));
+	if (sqfs_inode_is_dir(&inode)) {
+		dirs->dirent.type = FS_DT_DIR;
+	} else if (sqfs_inode_is_symlink(&inode)) {
+		dirs->dirent.type = FS_DT_LNK;
+		dirs->dirent.size = inode.file_size;
+	} else {
+		dirs->dirent.type = FS_DT_REG;
+		dirs->dirent.size = inode.file_size;
+	}
+	*dentp = &dirs->dirent;
+
+	return 0;
+}
+
+void sqfs_closedir(struct fs_dir_stream *fs_dirs)
+{
+	free(container_of(fs_dirs, struct squashfs_dir_stream, fs_dirs));
+}
+
+int sqfs_read(const char *filename, void *buf, loff_t offset, loff_t len,
+	      loff_t *actread)
+{
+	struct sqfs_cache_entry *frag;
+	struct sqfs_inode inode;
+	u64 file_size, disk_pos, pos, blk_start, blk_len;
+	u32 block_size = ctxt.block_size;
+	u32 nblocks, i, in_off, n, size;
+	__le32 *blocks = NULL;
+	unsigned long out_len;
+	loff_t done = 0;
+	int ret;
+
+	*actread = 0;
+
+	ret = sqfs_lookup(filename, &inode);
+	if (ret)
+		return ret;
+	if (!sqfs_inode_is_reg(&inode))
+		return sqfs_inode_is_dir(&inode) ? -EISDIR : -EINVAL;
+
+	file_size = inode.file_size;
+	if (offset >= file_size)
+		return 0;
+	if (!len || len > file_size - offset)
+		len = file_size - offset;
+
+	/* Full blocks; the tail lives in a fragment unless there is none */
+	if (inode.fragment == SQFS_INVALID_FRAG)
+		nblocks = DIV_ROUND_UP(file_size, block_size);
+	else
+		nblocks = file_size / block_size;
+
+	if (nblocks) {
+		blocks = malloc(nblocks * sizeof(*blocks));
+		if (!blocks)
+			return -ENOMEM;
+		ret = sqfs_read_meta(&inode.data, blocks,
+				     nblocks * sizeof(*blocks));
+		if (ret)
+			goto out;
+	}
+
+	disk_pos = inode.start_block;
+	for (i = 0; i < nblocks && done < len; i++) {
+		size = le32_to_cpu(blocks[i]);
+		blk_start = (u64)i * block_size;
+		blk_len = min_t(u64, block_size, file_size - blk_start);
+		pos = offset + done;
+
+		if (blk_start + blk_len <= pos) {
+			disk_pos += SQFS_BLOCK_LEN(size);
+			continue;
+		}
+
+		in_off = pos - blk_start;
+		n = min_t(u64, blk_len - in_off, len - done);
+
+		if (!size) {
+			/* Sparse block */
+			memset(buf + done, 0, n);
+		} else if (size & SQFS_BLOCK_UNCOMPRESSED) {
+			ret = sqfs_disk_read(disk_pos + in_off, n, buf + done);
+		} else if (n == blk_len) {
+			/* Whole block wanted, decompress it into place */
+			out_len = n;
+			ret = sqfs_read_block(disk_pos, size, buf + done,
+					      &out_len);
+			if (!ret && out_len != n)
+				ret = -EIO;
+		} else {
+			out_len = block_size;
+			ret = sqfs_read_block(disk_pos, size, ctxt.data_buf,
+					      &out_len);
+			if (!ret && out_len < in_off + n)
+				ret = -EIO;
+			if (!ret)
+				memcpy(buf + done, ctxt.data_buf + in_off, n);
+		}
+		if (ret)
+			goto out;
+
+		done += n;
+		disk_pos += SQFS_BLOCK_LEN(size);
+	}
+
+	if (done < len) {
+		if (inode.fragment == SQFS_INVALID_FRAG) {
+			ret = -EIO;
+			goto out;
+		}
+
+		frag = sqfs_read_fragment(inode.fragment);
+		in_off = inode.frag_offset + offset + done -
+			 (u64)nblocks * block_size;
+		if (!frag || in_off + (len - done) > frag->len) {
+			ret = -EIO;
+			goto out;
+		}
+		memcpy(buf + done, frag->data + in_off, len - done);
+		done = len;
+	}
+
+	*actread = done;
+
+out:
+	free(blocks);
+
+	return ret;
+}
+
+int sqfs_size(const char *filename, loff_t *size)
+{
+	struct sqfs_inode inode;
+	int ret;
+
+	ret = sqfs_lookup(filename, &inode);
+	if (ret)
+		return ret;
+
+	*size = inode.file_size;
+
+	return 0;
+}
+
+int sqfs_exists(const char *filename)
+{
+	struct sqfs_inode inode;
+
+	return !sqfs_lookup(filename, &inode);
+}
+
+void sqfs_close(void)
+{
+	sqfs_cache_free(ctxt.meta_cache, SQFS_META_CACHE_ENTRIES);
+	sqfs_cache_free(ctxt.frag_cache, SQFS_FRAG_CACHE_ENTRIES);
+	sqfs_decompressor_cleanup(&ctxt);
+	free(ctxt.frag_index);
+	free(ctxt.data_buf);
+	free(ctxt.comp_buf);
+	memset(&ctxt, 0, sizeof(ctxt));
+}
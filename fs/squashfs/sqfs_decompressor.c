@@ -0,0 +1,150 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * SquashFS filesystem implementation for U-Boot
+ *
+ * Glue between the SquashFS block format and the decompressors in lib/.
+ * Every block is compressed independently, so a block is always
+ * decompressed in one call straight into its final location.
+ */
+
+#include <common.h>
+#include <errno.h>
+#include <lz4.h>
+#include <malloc.h>
+#include <linux/lzo.h>
+#include <linux/zstd.h>
+#include <u-boot/zlib.h>
+
+#include "sqfs_decompressor.h"
+#include "sqfs_filesystem.h"
+#include "sqfs_internal.h"
+
+static int sqfs_zlib_decompress(void *dest, unsigned long *dest_len,
+				const void *source, u32 src_len)
+{
+	z_stream stream;
+	int ret;
+
+	memset(&stream, 0, sizeof(stream));
+	stream.next_in = (unsigned char *)source;
+	stream.avail_in = src_len;
+	stream.next_out = dest;
+	stream.avail_out = *dest_len;
+
+	if (inflateInit(&stream) != Z_OK)
+		return -EIO;
+
+	ret = inflate(&stream, Z_FINISH);
+	*dest_len = stream.total_out;
+	inflateEnd(&stream);
+
+	return ret == Z_STREAM_END ? 0 : -EIO;
+}
+
+int sqfs_decompressor_init(struct squashfs_ctxt *ctxt)
+{
+	u16 comp = le16_to_cpu(ctxt->sblk.compression);
+
+	switch (comp) {
+	case SQFS_COMP_ZLIB:
+		if (IS_ENABLED(CONFIG_ZLIB))
+			return 0;
+		break;
+	case SQFS_COMP_LZO:
+		if (IS_ENABLED(CONFIG_LZO))
+			return 0;
+		break;
+	case SQFS_COMP_LZ4:
+		if (IS_ENABLED(CONFIG_LZ4))
+			return 0;
+		break;
+#if IS_ENABLED(CONFIG_ZSTD)
+	case SQFS_COMP_ZSTD: {
+		size_t wsize = ZSTD_DCtxWorkspaceBound();
+
+		ctxt->zstd_workspace = malloc(wsize);
+		if (!ctxt->zstd_workspace)
+			return -ENOMEM;
+		ctxt->zstd_dctx = ZSTD_initDCtx(ctxt->zstd_workspace, wsize);
+		if (!ctxt->zstd_dctx) {
+			free(ctxt->zstd_workspace);
+			ctxt->zstd_workspace = NULL;
+			return -ENOMEM;
+		}
+		return 0;
+	}
+#endif
+	default:
+		break;
+	}
+
+	printf("** SquashFS compression type %u is not supported **\n", comp);
+
+	return -EPROTONOSUPPORT;
+}
+
+int sqfs_decompress(struct squashfs_ctxt *ctxt, void *dest,
+		    unsigned long *dest_len, const void *source, u32 src_len)
+{
+	u16 comp = le16_to_cpu(ctxt->sblk.compression);
+	int ret = -EIO;
+
+	switch (comp) {
+#if IS_ENABLED(CONFIG_ZLIB)
+	case SQFS_COMP_ZLIB:
+		ret = sqfs_zlib_decompress(dest, dest_len, source, src_len);
+		break;
+#endif
+#if IS_ENABLED(CONFIG_LZO)
+	case SQFS_COMP_LZO: {
+		size_t len = *dest_len;
+
+		if (lzo1x_decompress_safe(source, src_len, dest, &len) ==
+		    LZO_E_OK) {
+			*dest_len = len;
+			ret = 0;
+		}
+		break;
+	}
+#endif
+#if IS_ENABLED(CONFIG_LZ4)
+	case SQFS_COMP_LZ4: {
+		int len;
+
+		len = LZ4_decompress_safe(source, dest, src_len, *dest_len);
+		if (len >= 0) {
+			*dest_len = len;
+			ret = 0;
+		}
+		break;
+	}
+#endif
+#if IS_ENABLED(CONFIG_ZSTD)
+	case SQFS_COMP_ZSTD: {
+		size_t len;
+
+		len = ZSTD_decompressDCtx(ctxt->zstd_dctx, dest, *dest_len,
+					  source, src_len);
+		if (!ZSTD_isError(len)) {
+			*dest_len = len;
+			ret = 0;
+		}
+		break;
+	}
+#endif
+	default:
+		break;
+	}
+
+	if (ret)
+		debug("%s: corrupted block (compression %u)\n", __func__, comp);
+
+	return ret;
+}
+
+void sqfs_decompressor_cleanup(struct squashfs_ctxt *ctxt)
+{
+	free(ctxt->zstd_workspace);
+	ctxt->zstd_workspace = NULL;
+	ctxt->zstd_dctx = NULL;
+}
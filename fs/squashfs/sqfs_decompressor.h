@@ -0,0 +1,42 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * SquashFS filesystem implementation for U-Boot
+ */
+
+#ifndef __SQFS_DECOMPRESSOR_H__
+#define __SQFS_DECOMPRESSOR_H__
+
+#include <linux/types.h>
+
+struct squashfs_ctxt;
+
+/**
+ * sqfs_decompressor_init() - prepare decompression for the mounted image
+ *
+ * @ctxt:	filesystem context with a valid superblock
+ * @return 0 if OK, -EPROTONOSUPPORT if the compressor is not built in,
+ *	-ENOMEM if its workspace cannot be allocated
+ */
+int sqfs_decompressor_init(struct squashfs_ctxt *ctxt);
+
+/**
+ * sqfs_decompress() - decompress one data or metadata block
+ *
+ * @ctxt:	filesystem context
+ * @dest:	destination buffer
+ * @dest_len:	size of @dest on entry, decompressed length on return
+ * @source:	compressed data
+ * @src_len:	length of the compressed data
+ * @return 0 if OK, -EIO on corrupted data
+ */
+int sqfs_decompress(struct squashfs_ctxt *ctxt, void *dest,
+		    unsigned long *dest_len, const void *source, u32 src_len);
+
+/**
+ * sqfs_decompressor_cleanup() - release what sqfs_decompressor_init() set up
+ *
+ * @ctxt:	filesystem context
+ */
+void sqfs_decompressor_cleanup(struct squashfs_ctxt *ctxt);
+
+#endif /* __SQFS_DECOMPRESSOR_H__ */
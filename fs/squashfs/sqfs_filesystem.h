@@ -0,0 +1,164 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * SquashFS filesystem implementation for U-Boot
+ *
+ * On-disk structures of the SquashFS 4.0 format. All fields are little
+ * endian.
+ */
+
+#ifndef __SQFS_FILESYSTEM_H__
+#define __SQFS_FILESYSTEM_H__
+
+#include <linux/types.h>
+
+#define SQFS_MAGIC			0x73717368
+#define SQFS_MAJOR			4
+
+#define SQFS_METADATA_SIZE		8192
+#define SQFS_METADATA_HDR_SIZE		2
+#define SQFS_METADATA_UNCOMPRESSED	BIT(15)
+#define SQFS_METADATA_LEN(hdr)		((hdr) & ~SQFS_METADATA_UNCOMPRESSED)
+
+#define SQFS_BLOCK_UNCOMPRESSED		BIT(24)
+#define SQFS_BLOCK_LEN(size)		((size) & ~SQFS_BLOCK_UNCOMPRESSED)
+
+#define SQFS_INVALID_FRAG		0xffffffff
+#define SQFS_INVALID_BLK		(~0ULL)
+
+/* Inode references: metadata block offset from table start, then offset */
+#define SQFS_REF_BLOCK(ref)		((ref) >> 16)
+#define SQFS_REF_OFFSET(ref)		((ref) & 0xffff)
+
+#define SQFS_FRAGMENTS_PER_BLOCK	\
+	(SQFS_METADATA_SIZE / sizeof(struct squashfs_fragment_block_entry))
+
+/* Superblock flags */
+#define SQFS_FLAG_COMP_OPT		BIT(10)
+
+enum squashfs_compression {
+	SQFS_COMP_ZLIB = 1,
+	SQFS_COMP_LZMA = 2,
+	SQFS_COMP_LZO = 3,
+	SQFS_COMP_XZ = 4,
+	SQFS_COMP_LZ4 = 5,
+	SQFS_COMP_ZSTD = 6,
+};
+
+enum squashfs_inode_type {
+	SQFS_DIR_TYPE = 1,
+	SQFS_REG_TYPE = 2,
+	SQFS_SYMLINK_TYPE = 3,
+	SQFS_BLKDEV_TYPE = 4,
+	SQFS_CHRDEV_TYPE = 5,
+	SQFS_FIFO_TYPE = 6,
+	SQFS_SOCKET_TYPE = 7,
+	SQFS_LDIR_TYPE = 8,
+	SQFS_LREG_TYPE = 9,
+	SQFS_LSYMLINK_TYPE = 10,
+	SQFS_LBLKDEV_TYPE = 11,
+	SQFS_LCHRDEV_TYPE = 12,
+	SQFS_LFIFO_TYPE = 13,
+	SQFS_LSOCKET_TYPE = 14,
+};
+
+struct squashfs_super_block {
+	__le32 s_magic;
+	__le32 inodes;
+	__le32 mkfs_time;
+	__le32 block_size;
+	__le32 fragments;
+	__le16 compression;
+	__le16 block_log;
+	__le16 flags;
+	__le16 no_ids;
+	__le16 s_major;
+	__le16 s_minor;
+	__le64 root_inode;
+	__le64 bytes_used;
+	__le64 id_table_start;
+	__le64 xattr_id_table_start;
+	__le64 inode_table_start;
+	__le64 directory_table_start;
+	__le64 fragment_table_start;
+	__le64 export_table_start;
+} __packed;
+
+struct squashfs_base_inode {
+	__le16 inode_type;
+	__le16 mode;
+	__le16 uid;
+	__le16 guid;
+	__le32 mtime;
+	__le32 inode_number;
+} __packed;
+
+struct squashfs_dir_inode {
+	struct squashfs_base_inode base;
+	__le32 start_block;
+	__le32 nlink;
+	__le16 file_size;
+	__le16 offset;
+	__le32 parent_inode;
+} __packed;
+
+struct squashfs_ldir_inode {
+	struct squashfs_base_inode base;
+	__le32 nlink;
+	__le32 file_size;
+	__le32 start_block;
+	__le32 parent_inode;
+	__le16 i_count;
+	__le16 offset;
+	__le32 xattr;
+	/* followed by i_count directory index entries */
+} __packed;
+
+struct squashfs_reg_inode {
+	struct squashfs_base_inode base;
+	__le32 start_block;
+	__le32 fragment;
+	__le32 offset;
+	__le32 file_size;
+	/* followed by the block list */
+} __packed;
+
+struct squashfs_lreg_inode {
+	struct squashfs_base_inode base;
+	__le64 start_block;
+	__le64 file_size;
+	__le64 sparse;
+	__le32 nlink;
+	__le32 fragment;
+	__le32 offset;
+	__le32 xattr;
+	/* followed by the block list */
+} __packed;
+
+struct squashfs_symlink_inode {
+	struct squashfs_base_inode base;
+	__le32 nlink;
+	__le32 symlink_size;
+	/* followed by the target, not NUL-terminated */
+} __packed;
+
+struct squashfs_directory_header {
+	__le32 count;		/* number of entries minus one */
+	__le32 start;		/* metadata block of the entries' inodes */
+	__le32 inode_number;
+} __packed;
+
+struct squashfs_directory_entry {
+	__le16 offset;
+	__le16 inode_offset;
+	__le16 type;
+	__le16 name_size;	/* name length minus one */
+	/* followed by the name, not NUL-terminated */
+} __packed;
+
+struct squashfs_fragment_block_entry {
+	__le64 start;
+	__le32 size;
+	__le32 _unused;
+} __packed;
+
+#endif /* __SQFS_FILESYSTEM_H__ */
@@ -0,0 +1,54 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * SquashFS filesystem implementation for U-Boot
+ */
+
+#ifndef __SQFS_INTERNAL_H__
+#define __SQFS_INTERNAL_H__
+
+#include <part.h>
+#include <linux/zstd.h>
+
+#include "sqfs_filesystem.h"
+
+/* Decompressed metadata blocks kept around while the image is mounted */
+#define SQFS_META_CACHE_ENTRIES	8
+/* Decompressed fragment blocks kept around while the image is mounted */
+#define SQFS_FRAG_CACHE_ENTRIES	2
+
+/**
+ * struct sqfs_cache_entry - one decompressed block
+ *
+ * @key:	disk offset of a metadata block, or fragment index
+ * @next:	disk offset of the following metadata block
+ * @len:	decompressed length, 0 if the entry is unused
+ * @seq:	last use, for picking an entry to recycle
+ * @data:	decompressed contents, allocated on first use
+ */
+struct sqfs_cache_entry {
+	u64 key;
+	u64 next;
+	u32 len;
+	ulong seq;
+	void *data;
+};
+
+struct squashfs_ctxt {
+	struct blk_desc *cur_dev;
+	disk_partition_t cur_part_info;
+	struct squashfs_super_block sblk;
+	u32 block_size;
+	/* Compressed block staging buffer */
+	void *comp_buf;
+	/* Decompressed data block which is only partially copied out */
+	void *data_buf;
+	/* On-disk locations of the fragment table metadata blocks */
+	__le64 *frag_index;
+	struct sqfs_cache_entry meta_cache[SQFS_META_CACHE_ENTRIES];
+	struct sqfs_cache_entry frag_cache[SQFS_FRAG_CACHE_ENTRIES];
+	ulong cache_seq;
+	void *zstd_workspace;
+	ZSTD_DCtx *zstd_dctx;
+};
+
+#endif /* __SQFS_INTERNAL_H__ */
@@ -91,11 +91,128 @@ void ubifs_ro_mode(struct ubifs_info *c, int err)
  * for more information.
  */
 
+#ifdef __UBOOT__
+/**
+ * ubifs_rcache_init - allocate the LEB read cache.
+ * @c: UBIFS file-system description object
+ *
+ * The window must hold a min. I/O unit plus the largest cached read, so it
+ * grows with the flash page size. Returns zero or %-ENOMEM.
+ */
+int ubifs_rcache_init(struct ubifs_info *c)
+{
+	struct ubifs_rcache *rc;
+	int i;
+
+	rc = kzalloc(sizeof(struct ubifs_rcache), GFP_KERNEL);
+	if (!rc)
+		return -ENOMEM;
+
+	rc->window = max_t(int, UBIFS_RCACHE_WINDOW, 2 * c->min_io_size);
+	rc->window = min_t(int, rc->window, c->leb_size);
+	for (i = 0; i < UBIFS_RCACHE_ENTRIES; i++) {
+		rc->entry[i].lnum = -1;
+		rc->entry[i].buf = kmalloc(rc->window, GFP_KERNEL);
+		if (!rc->entry[i].buf) {
+			c->rcache = rc;
+			ubifs_rcache_free(c);
+			return -ENOMEM;
+		}
+	}
+	c->rcache = rc;
+
+	return 0;
+}
+
+/**
+ * ubifs_rcache_free - free the LEB read cache.
+ * @c: UBIFS file-system description object
+ */
+void ubifs_rcache_free(struct ubifs_info *c)
+{
+	struct ubifs_rcache *rc = c->rcache;
+	int i;
+
+	if (!rc)
+		return;
+
+	dbg_io("read cache: %lu hits, %lu misses", rc->hits, rc->misses);
+	for (i = 0; i < UBIFS_RCACHE_ENTRIES; i++)
+		kfree(rc->entry[i].buf);
+	kfree(rc);
+	c->rcache = NULL;
+}
+
+/* Forget cached windows of @lnum, which is about to change */
+static void ubifs_rcache_drop(struct ubifs_info *c, int lnum)
+{
+	int i;
+
+	if (!c->rcache)
+		return;
+
+	for (i = 0; i < UBIFS_RCACHE_ENTRIES; i++)
+		if (c->rcache->entry[i].lnum == lnum)
+			c->rcache->entry[i].lnum = -1;
+}
+
+/*
+ * Serve a small read from the read cache, reading the window around it on a
+ * miss. Returns zero if @buf was filled, non-zero if the caller has to read
+ * from flash itself.
+ */
+static int ubifs_rcache_read(const struct ubifs_info *c, int lnum, void *buf,
+			     int offs, int len)
+{
+	struct ubifs_rcache *rc = c->rcache;
+	struct ubifs_rcache_entry *e, *victim = NULL;
+	int i, wofs, wlen;
+
+	if (len > rc->window / 2)
+		return -EINVAL;
+
+	for (i = 0; i < UBIFS_RCACHE_ENTRIES; i++) {
+		e = &rc->entry[i];
+		if (e->lnum == lnum && offs >= e->offs &&
+		    offs + len <= e->offs + e->len) {
+			e->seq = ++rc->seq;
+			rc->hits++;
+			memcpy(buf, e->buf + offs - e->offs, len);
+			return 0;
+		}
+		if (!victim || e->seq < victim->seq)
+			victim = e;
+	}
+
+	wofs = offs - offs % c->min_io_size;
+	wlen = min(rc->window, c->leb_size - wofs);
+	if (offs + len > wofs + wlen)
+		return -EINVAL;
+
+	victim->lnum = -1;
+	if (ubi_read(c->ubi, lnum, victim->buf, wofs, wlen))
+		return -EIO;
+
+	victim->lnum = lnum;
+	victim->offs = wofs;
+	victim->len = wlen;
+	victim->seq = ++rc->seq;
+	rc->misses++;
+	memcpy(buf, victim->buf + offs - wofs, len);
+
+	return 0;
+}
+#endif
+
 int ubifs_leb_read(const struct ubifs_info *c, int lnum, void *buf, int offs,
 		   int len, int even_ebadmsg)
 {
 	int err;
 
+#ifdef __UBOOT__
+	if (c->rcache && !ubifs_rcache_read(c, lnum, buf, offs, len))
+		return 0;
+#endif
 	err = ubi_read(c->ubi, lnum, buf, offs, len);
 	/*
 	 * In case of %-EBADMSG print the error message only if the
@@ -117,6 +234,9 @@ int ubifs_leb_write(struct ubifs_info *c, int lnum, const void *buf, int offs,
 	ubifs_assert(!c->ro_media && !c->ro_mount);
 	if (c->ro_error)
 		return -EROFS;
+#ifdef __UBOOT__
+	ubifs_rcache_drop(c, lnum);
+#endif
 	if (!dbg_is_tst_rcvry(c))
 		err = ubi_leb_write(c->ubi, lnum, buf, offs, len);
 #ifndef __UBOOT__
@@ -139,6 +259,9 @@ int ubifs_leb_change(struct ubifs_info *c, int lnum, const void *buf, int len)
 	ubifs_assert(!c->ro_media && !c->ro_mount);
 	if (c->ro_error)
 		return -EROFS;
+#ifdef __UBOOT__
+	ubifs_rcache_drop(c, lnum);
+#endif
 	if (!dbg_is_tst_rcvry(c))
 		err = ubi_leb_change(c->ubi, lnum, buf, len);
 #ifndef __UBOOT__
@@ -161,6 +284,9 @@ int ubifs_leb_unmap(struct ubifs_info *c, int lnum)
 	ubifs_assert(!c->ro_media && !c->ro_mount);
 	if (c->ro_error)
 		return -EROFS;
+#ifdef __UBOOT__
+	ubifs_rcache_drop(c, lnum);
+#endif
 	if (!dbg_is_tst_rcvry(c))
 		err = ubi_leb_unmap(c->ubi, lnum);
 #ifndef __UBOOT__
@@ -182,6 +308,9 @@ int ubifs_leb_map(struct ubifs_info *c, int lnum)
 	ubifs_assert(!c->ro_media && !c->ro_mount);
 	if (c->ro_error)
 		return -EROFS;
+#ifdef __UBOOT__
+	ubifs_rcache_drop(c, lnum);
+#endif
 	if (!dbg_is_tst_rcvry(c))
 		err = ubi_leb_map(c->ubi, lnum);
 #ifndef __UBOOT__
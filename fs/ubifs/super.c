@@ -1401,6 +1401,13 @@ static int mount_ubifs(struct ubifs_info *c)
 	}
 #endif
 
+#ifdef __UBOOT__
+	/* U-Boot only reads, always use bulk-read and the LEB read cache */
+	c->bulk_read = 1;
+	if (ubifs_rcache_init(c))
+		ubifs_warn(c, "cannot allocate the read cache, reading uncached");
+#endif
+
 	if (c->bulk_read == 1)
 		bu_init(c);
 
@@ -1704,6 +1711,9 @@ out_cbuf:
 out_free:
 	kfree(c->write_reserve_buf);
 	kfree(c->bu.buf);
+#ifdef __UBOOT__
+	ubifs_rcache_free(c);
+#endif
 	vfree(c->ileb_buf);
 	vfree(c->sbuf);
 	kfree(c->bottom_up_buf);
@@ -1749,6 +1759,9 @@ void ubifs_umount(struct ubifs_info *c)
 	kfree(c->mst_node);
 	kfree(c->write_reserve_buf);
 	kfree(c->bu.buf);
+#ifdef __UBOOT__
+	ubifs_rcache_free(c);
+#endif
 	vfree(c->ileb_buf);
 	vfree(c->sbuf);
 	kfree(c->bottom_up_buf);
@@ -23,6 +23,7 @@
 #include <linux/compat.h>
 #include <linux/err.h>
 #include <linux/lzo.h>
+#include <linux/math64.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -669,23 +670,16 @@ static inline void *kmap(struct page *page)
 	return page->addr;
 }
 
-static int read_block(struct inode *inode, void *addr, unsigned int block,
-		      struct ubifs_data_node *dn)
+/*
+ * Decompress data node @dn of @block into @addr, which has room for a whole
+ * block.
+ */
+static int decode_block(struct ubifs_info *c, struct inode *inode, void *addr,
+			unsigned int block, struct ubifs_data_node *dn)
 {
-	struct ubifs_info *c = inode->i_sb->s_fs_info;
 	int err, len, out_len;
-	union ubifs_key key;
 	unsigned int dlen;
 
-	data_key_init(c, &key, inode->i_ino, block);
-	err = ubifs_tnc_lookup(c, &key, dn);
-	if (err) {
-		if (err == -ENOENT)
-			/* Not found, so it must be a hole */
-			memset(addr, 0, UBIFS_BLOCK_SIZE);
-		return err;
-	}
-
 	ubifs_assert(le64_to_cpu(dn->ch.sqnum) > ubifs_inode(inode)->creat_sqnum);
 
 	len = le32_to_cpu(dn->size);
@@ -716,6 +710,82 @@ dump:
 	return -EINVAL;
 }
 
+static int read_block(struct inode *inode, void *addr, unsigned int block,
+		      struct ubifs_data_node *dn)
+{
+	struct ubifs_info *c = inode->i_sb->s_fs_info;
+	union ubifs_key key;
+	int err;
+
+	data_key_init(c, &key, inode->i_ino, block);
+	err = ubifs_tnc_lookup(c, &key, dn);
+	if (err) {
+		if (err == -ENOENT)
+			/* Not found, so it must be a hole */
+			memset(addr, 0, UBIFS_BLOCK_SIZE);
+		return err;
+	}
+
+	return decode_block(c, inode, addr, block, dn);
+}
+
+/**
+ * read_blocks_bulk - read a run of whole blocks with one LEB read.
+ * @c: UBIFS file-system description object
+ * @inode: inode to read from
+ * @addr: destination, with room for @count blocks
+ * @block: first block to read
+ * @count: maximum number of blocks to read
+ *
+ * Data nodes of consecutive blocks usually sit back to back in one LEB, so
+ * they are read together and decompressed straight into the destination.
+ * Returns the number of blocks read, which is 0 if the caller has to fall
+ * back to reading block by block, or a negative error code.
+ */
+static int read_blocks_bulk(struct ubifs_info *c, struct inode *inode,
+			    void *addr, unsigned int block, unsigned int count)
+{
+	struct bu_info *bu = &c->bu;
+	unsigned int i, b, n;
+	void *node;
+	int err;
+
+	if (!c->bulk_read || !bu->buf)
+		return 0;
+
+	data_key_init(c, &bu->key, inode->i_ino, block);
+	bu->buf_len = c->max_bu_buf_len;
+	err = ubifs_tnc_get_bu_keys(c, bu);
+	if (err)
+		return err;
+	if (!bu->cnt)
+		return 0;
+
+	err = ubifs_tnc_bulk_read(c, bu);
+	if (err)
+		return err;
+
+	/* Blocks up to the last node read, including holes in between */
+	n = key_block(c, &bu->zbranch[bu->cnt - 1].key) - block + 1;
+	n = min(n, count);
+
+	node = bu->buf;
+	for (b = 0, i = 0; b < n; b++, addr += UBIFS_BLOCK_SIZE) {
+		if (key_block(c, &bu->zbranch[i].key) != block + b) {
+			memset(addr, 0, UBIFS_BLOCK_SIZE);
+			continue;
+		}
+
+		err = decode_block(c, inode, addr, block + b, node);
+		if (err)
+			return err;
+		node += ALIGN(bu->zbranch[i].len, 8);
+		i++;
+	}
+
+	return n;
+}
+
 static int do_readpage(struct ubifs_info *c, struct inode *inode,
 		       struct page *page, int last_block_size)
 {
@@ -886,6 +956,24 @@ int ubifs_read(const char *filename, void *buf, loff_t offset,
 	page.index = offset / PAGE_SIZE;
 	page.inode = inode;
 	for (i = 0; i < count; i++) {
+		/*
+		 * Whole pages before the last one are bulk-read, there is
+		 * one block per page in U-Boot.
+		 */
+		if (i + 1 < count) {
+			err = read_blocks_bulk(c, inode, page.addr, page.index,
+					       count - 1 - i);
+			if (err < 0)
+				break;
+			if (err > 0) {
+				page.addr += err * PAGE_SIZE;
+				page.index += err;
+				i += err - 1;
+				err = 0;
+				continue;
+			}
+		}
+
 		/*
 		 * Make sure to not read beyond the requested size
 		 */
@@ -923,14 +1011,18 @@ void ubifs_close(void)
 int ubifs_load(char *filename, u32 addr, u32 size)
 {
 	loff_t actread;
+	ulong time;
 	int err;
 
 	printf("Loading file '%s' to addr 0x%08x...\n", filename, addr);
 
+	time = get_timer(0);
 	err = ubifs_read(filename, (void *)(uintptr_t)addr, 0, size, &actread);
+	time = get_timer(time);
 	if (err == 0) {
 		env_set_hex("filesize", actread);
-		printf("Done\n");
+		puts("Done: ");
+		print_read_time(actread, time);
 	}
 
 	return err;
@@ -1403,6 +1403,49 @@ struct bu_info {
 	int eof;
 };
 
+#ifdef __UBOOT__
+/* LEB read cache: number of windows and minimum window size */
+#define UBIFS_RCACHE_ENTRIES 16
+#define UBIFS_RCACHE_WINDOW 8192
+
+/**
+ * struct ubifs_rcache_entry - a cached window of a LEB.
+ * @lnum: LEB number, %-1 if the entry is unused
+ * @offs: offset of the window in the LEB
+ * @len: window length
+ * @seq: sequence number of the last use, for LRU replacement
+ * @buf: window contents
+ */
+struct ubifs_rcache_entry {
+	int lnum;
+	int offs;
+	int len;
+	unsigned long seq;
+	void *buf;
+};
+
+/**
+ * struct ubifs_rcache - read cache for small LEB reads.
+ * @window: window size
+ * @seq: use sequence counter
+ * @hits: number of reads served from the cache
+ * @misses: number of windows read from flash
+ * @entry: cached windows
+ *
+ * Index nodes, inodes and directory entries are small and clustered, so
+ * reading a whole window around them saves a flash access for most of the
+ * lookups which follow. The cache lives as long as the mount, so it also
+ * helps consecutive file reads.
+ */
+struct ubifs_rcache {
+	int window;
+	unsigned long seq;
+	unsigned long hits;
+	unsigned long misses;
+	struct ubifs_rcache_entry entry[UBIFS_RCACHE_ENTRIES];
+};
+#endif
+
 /**
  * struct ubifs_node_range - node length range description data structure.
  * @len: fixed node length
@@ -1654,6 +1697,7 @@ struct ubifs_debug_info;
  * @max_bu_buf_len: maximum bulk-read buffer length
  * @bu_mutex: protects the pre-allocated bulk-read buffer and @c->bu
  * @bu: pre-allocated bulk-read information
+ * @rcache: read cache for small LEB reads (U-Boot only)
  *
  * @write_reserve_mutex: protects @write_reserve_buf
  * @write_reserve_buf: on the write path we allocate memory, which might
@@ -1896,6 +1940,9 @@ struct ubifs_info {
 	int max_bu_buf_len;
 	struct mutex bu_mutex;
 	struct bu_info bu;
+#ifdef __UBOOT__
+	struct ubifs_rcache *rcache;
+#endif
 
 	struct mutex write_reserve_mutex;
 	void *write_reserve_buf;
@@ -2090,6 +2137,10 @@ int ubifs_leb_change(struct ubifs_info *c, int lnum, const void *buf, int len);
 int ubifs_leb_unmap(struct ubifs_info *c, int lnum);
 int ubifs_leb_map(struct ubifs_info *c, int lnum);
 int ubifs_is_mapped(const struct ubifs_info *c, int lnum);
+#ifdef __UBOOT__
+int ubifs_rcache_init(struct ubifs_info *c);
+void ubifs_rcache_free(struct ubifs_info *c);
+#endif
 int ubifs_wbuf_write_nolock(struct ubifs_wbuf *wbuf, void *buf, int len);
 int ubifs_wbuf_seek_nolock(struct ubifs_wbuf *wbuf, int lnum, int offs);
 int ubifs_wbuf_init(struct ubifs_info *c, struct ubifs_wbuf *wbuf);
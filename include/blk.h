@@ -8,6 +8,7 @@
 #define BLK_H
 
 #include <efi.h>
+#include <linux/list.h>
 
 #ifdef CONFIG_SYS_64BIT_LBA
 typedef uint64_t lbaint_t;
@@ -203,9 +204,52 @@ static inline void blkcache_invalidate(int iftype, int dev) {}
 
 #endif
 
+/**
+ * struct blk_sg - one segment of a scatter-gather transfer
+ *
+ * @buffer:	Data buffer for this segment
+ * @blkcnt:	Number of blocks transferred to/from @buffer
+ */
+struct blk_sg {
+	void *buffer;
+	lbaint_t blkcnt;
+};
+
 #if CONFIG_IS_ENABLED(BLK)
 struct udevice;
 
+/* blk_wait() gives up on a request making no progress for this long */
+#define BLK_WAIT_TIMEOUT_MS	60000
+
+/**
+ * struct blk_req - an asynchronous block device request
+ *
+ * Filled in by the caller, who must keep it and @buffer untouched until
+ * @done is set. See blk_submit().
+ *
+ * @write:	true to write @buffer to the device, false to read into it
+ * @start:	Start block number (0=first)
+ * @blkcnt:	Number of blocks
+ * @buffer:	Data buffer
+ * @done:	Set by the driver when the request has completed
+ * @result:	Set with @done: number of blocks transferred, or -ve error
+ * @submitted:	Driver use: number of blocks sent to the device so far
+ * @inflight:	Driver use: number of device commands outstanding
+ * @node:	Driver use: position in the list of pending requests
+ */
+struct blk_req {
+	bool write;
+	lbaint_t start;
+	lbaint_t blkcnt;
+	void *buffer;
+	bool done;
+	long result;
+
+	lbaint_t submitted;
+	int inflight;
+	struct list_head node;
+};
+
 /* Operations on block devices */
 struct blk_ops {
 	/**
@@ -234,6 +278,21 @@ struct blk_ops {
 	unsigned long (*write)(struct udevice *dev, lbaint_t start,
 			       lbaint_t blkcnt, const void *buffer);
 
+	/**
+	 * read_sg() - read consecutive blocks into several buffers
+	 *
+	 * Optional, see blk_dread_sg().
+	 *
+	 * @dev:	Device to read from
+	 * @start:	Start block number to read (0=first)
+	 * @sg:	Destination segments, filled in order
+	 * @nsegs:	Number of entries in @sg
+	 * @return number of blocks read, or -ve error number (see the
+	 * IS_ERR_VALUE() macro
+	 */
+	unsigned long (*read_sg)(struct udevice *dev, lbaint_t start,
+				 const struct blk_sg *sg, int nsegs);
+
 	/**
 	 * erase() - erase a section of a block device
 	 *
@@ -264,6 +323,42 @@ struct blk_ops {
 	 * @return 0 if OK, -ve on error
 	 */
 	int (*select_hwpart)(struct udevice *dev, int hwpart);
+
+	/**
+	 * submit() - queue an asynchronous request
+	 *
+	 * The device starts as much of the request as it can take, the rest
+	 * is started from poll(). Optional, see blk_submit().
+	 *
+	 * @dev:	Device to submit to
+	 * @req:	Request to queue, with done set to false
+	 * @return 0 if OK, -ve on error
+	 */
+	int (*submit)(struct udevice *dev, struct blk_req *req);
+
+	/**
+	 * poll() - make progress on the submitted requests
+	 *
+	 * Reap the completions of the device and start what is still queued.
+	 * This sets done and result of the requests which completed. It does
+	 * not wait for the device.
+	 *
+	 * @dev:	Device to poll
+	 * @return number of requests not done yet, or -ve on error
+	 */
+	int (*poll)(struct udevice *dev);
+
+	/**
+	 * cancel() - give up on a request which is not done
+	 *
+	 * Forget about @req, which its caller is going to reuse or free.
+	 * Commands still running for it on the device must no longer refer
+	 * to it. Optional, but devices with submit() should have it.
+	 *
+	 * @dev:	Device the request was submitted to
+	 * @req:	Request to cancel
+	 */
+	void (*cancel)(struct udevice *dev, struct blk_req *req);
 };
 
 #define blk_get_ops(dev)	((struct blk_ops *)(dev)->driver->ops)
@@ -281,6 +376,59 @@ unsigned long blk_dwrite(struct blk_desc *block_dev, lbaint_t start,
 unsigned long blk_derase(struct blk_desc *block_dev, lbaint_t start,
 			 lbaint_t blkcnt);
 
+/**
+ * blk_dread_sg() - read consecutive blocks into several buffers
+ *
+ * This lets a caller such as a filesystem gather blocks which are adjacent
+ * on the device but not in memory with a single device command. Devices
+ * without a read_sg() operation read each segment separately. The block
+ * cache is bypassed.
+ *
+ * @block_dev:	Block device to read from
+ * @start:	Start block number to read (0=first)
+ * @sg:		Destination segments, filled in order
+ * @nsegs:	Number of entries in @sg
+ * @return number of blocks read, or -ve error number
+ */
+unsigned long blk_dread_sg(struct blk_desc *block_dev, lbaint_t start,
+			   const struct blk_sg *sg, int nsegs);
+
+/**
+ * blk_submit() - start an asynchronous request on a block device
+ *
+ * Several requests can be submitted before waiting for them, which lets
+ * devices with command queues work on them at the same time. The block
+ * cache is bypassed, writes invalidate it.
+ *
+ * Devices without a submit() operation do the transfer right away, so
+ * @req is done when this returns.
+ *
+ * @dev:	Block device to use
+ * @req:	Request to start, see struct blk_req
+ * @return 0 if OK, -ve on error, in which case @req was not queued
+ */
+int blk_submit(struct udevice *dev, struct blk_req *req);
+
+/**
+ * blk_poll() - make progress on the requests submitted to a block device
+ *
+ * @dev:	Block device to poll
+ * @return number of requests not done yet, or -ve on error
+ */
+int blk_poll(struct udevice *dev);
+
+/**
+ * blk_wait() - poll a block device until a request is done
+ *
+ * If @req makes no progress for BLK_WAIT_TIMEOUT_MS it is cancelled.
+ *
+ * @dev:	Block device to poll
+ * @req:	Request to wait for
+ * @return result of @req, -ETIMEDOUT if it was cancelled, or -ve error
+ * from the device
+ */
+long blk_wait(struct udevice *dev, struct blk_req *req);
+
 /**
  * blk_find_device() - Find a block device
  *
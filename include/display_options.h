@@ -21,6 +21,27 @@
  */
 void print_size(uint64_t size, const char *suffix);
 
+/**
+ * print_rate() - Print a throughput in brackets
+ *
+ * Print " (xxx MiB/s)" for @bytes transferred in @time_us microseconds, or
+ * nothing if @time_us is 0
+ *
+ * @bytes:	Number of bytes transferred
+ * @time_us:	Time taken in microseconds
+ */
+void print_rate(uint64_t bytes, uint64_t time_us);
+
+/**
+ * print_read_time() - Print how much data was read and how long it took
+ *
+ * Print "xxx bytes read in xxx ms (xxx MiB/s)" followed by a newline
+ *
+ * @bytes:	Number of bytes read
+ * @time_ms:	Time taken in milliseconds
+ */
+void print_read_time(uint64_t bytes, ulong time_ms);
+
 /**
  * print_freq() - Print a frequency with a suffix
  *
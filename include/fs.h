@@ -13,6 +13,8 @@
 #define FS_TYPE_SANDBOX	3
 #define FS_TYPE_UBIFS	4
 #define FS_TYPE_BTRFS	5
+#define FS_TYPE_SQUASHFS 6
+#define FS_TYPE_EROFS 7
 
 /**
  * do_fat_fsload - Run the fatload command
@@ -41,6 +43,8 @@ int do_ext2load(cmd_tbl_t *cmdtp, int flag, int argc, char *const argv[]);
  * commands. This also internally identifies the filesystem that is present
  * within the partition. The identification process may be limited to a
  * specific filesystem type by passing FS_* in the fstype parameter.
+ * A partition which is kept mounted for files opened with fs_open() is not
+ * identified again.
  *
  * Returns 0 on success.
  * Returns non-zero if there is an error accessing the disk or partition, or
@@ -67,7 +71,8 @@ int fs_set_blk_dev_with_part(struct blk_desc *desc, int part);
  *
  * Many file functions implicitly call fs_close(), e.g. fs_closedir(),
  * fs_exist(), fs_ln(), fs_ls(), fs_mkdir(), fs_read(), fs_size(), fs_write(),
- * fs_unlink().
+ * fs_unlink(). They leave the file system mounted while files opened on it
+ * with fs_open() are still open.
  */
 void fs_close(void);
 
@@ -146,6 +151,56 @@ int fs_read(const char *filename, ulong addr, loff_t offset, loff_t len,
 int fs_write(const char *filename, ulong addr, loff_t offset, loff_t len,
 	     loff_t *actwrite);
 
+struct fs_mount;
+
+/* Note: fs_file should be treated as opaque to the user of fs layer */
+struct fs_file {
+	/* private to fs. layer: */
+	struct fs_mount *mnt;
+	/* public: */
+	loff_t size;	/* size of the file when it was opened */
+	/* private to fs. layer: */
+	char path[0];
+};
+
+/**
+ * fs_open() - open a file on the partition previously set by fs_set_blk_dev()
+ *
+ * Unlike the other file functions this does not call fs_close(): the
+ * filesystem stays mounted for as long as a handle on it is open, so that
+ * subsequent fs_pread() calls do not have to identify and parse it again.
+ * Handles must be closed before the underlying block device goes away.
+ *
+ * @filename:	full path of the file to open
+ * Return:	file handle or NULL on error with errno set appropriately
+ */
+struct fs_file *fs_open(const char *filename);
+
+/**
+ * fs_pread() - read from a file opened with fs_open()
+ *
+ * Note that not all filesystem drivers support either or both of offset != 0
+ * and len != 0.
+ *
+ * @file:	file handle
+ * @buf:	buffer to write to
+ * @offset:	offset in the file from where to start reading
+ * @len:	the number of bytes to read. Use 0 to read entire file.
+ * @actread:	returns the actual number of bytes read
+ * Return:	0 if OK with valid *actread, non-zero on error conditions
+ */
+int fs_pread(struct fs_file *file, void *buf, loff_t offset, loff_t len,
+	     loff_t *actread);
+
+/**
+ * fs_file_close() - close a file handle returned by fs_open()
+ *
+ * The filesystem is unmounted when its last open handle is closed.
+ *
+ * @file:	file handle, may be NULL
+ */
+void fs_file_close(struct fs_file *file);
+
 /*
  * Directory entry types, matches the subset of DT_x in posix readdir()
  * which apply to u-boot.
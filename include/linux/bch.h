@@ -30,6 +30,7 @@
  * @ecc_buf2:   ecc parity words buffer
  * @xi_tab:     GF(2^m) base for solving degree 2 polynomial roots
  * @syn:        syndrome buffer
+ * @syn_tab:    syndrome lookup tables, log of b(a^j) for every byte b
  * @cache:      log-based polynomial representation buffer
  * @elp:        error locator polynomial
  * @poly_2t:    temporary polynomials of degree 2t
@@ -48,6 +49,7 @@ struct bch_control {
 	uint32_t       *ecc_buf2;
 	unsigned int   *xi_tab;
 	unsigned int   *syn;
+	uint16_t       *syn_tab;
 	int            *cache;
 	struct gf_poly *elp;
 	struct gf_poly *poly_2t[4];
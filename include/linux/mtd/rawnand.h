@@ -25,6 +25,7 @@
 struct mtd_info;
 struct nand_chip;
 struct nand_flash_dev;
+struct nand_page_cache;
 struct device_node;
 
 /* Get the flash and manufacturer id and lookup if the type is supported. */
@@ -99,6 +100,8 @@ void nand_wait_ready(struct mtd_info *mtd);
 
 /* Extended commands for large page devices */
 #define NAND_CMD_READSTART	0x30
+#define NAND_CMD_READCACHESEQ	0x31
+#define NAND_CMD_READCACHEEND	0x3f
 #define NAND_CMD_RNDOUTSTART	0xE0
 #define NAND_CMD_CACHEDPROG	0x15
 
@@ -219,6 +222,9 @@ enum nand_ecc_algo {
 /* Device needs 3rd row address cycle */
 #define NAND_ROW_ADDR_3		0x00004000
 
+/* Chip has the read cache commands, used for sequential page reads */
+#define NAND_READ_CACHE		0x00008000
+
 /* Options valid for Samsung large page devices */
 #define NAND_SAMSUNG_LP_OPTIONS NAND_CACHEPRG
 
@@ -226,6 +232,7 @@ enum nand_ecc_algo {
 #define NAND_HAS_CACHEPROG(chip) ((chip->options & NAND_CACHEPRG))
 #define NAND_HAS_SUBPAGE_READ(chip) ((chip->options & NAND_SUBPAGE_READ))
 #define NAND_HAS_SUBPAGE_WRITE(chip) !((chip)->options & NAND_NO_SUBPAGE_WRITE)
+#define NAND_HAS_READ_CACHE(chip) ((chip->options & NAND_READ_CACHE))
 
 /* Non chip related options */
 /* This option skips the bbt scan during initialization. */
@@ -283,7 +290,8 @@ enum nand_ecc_algo {
 /* ONFI subfeature parameters length */
 #define ONFI_SUBFEATURE_PARAM_LEN	4
 
-/* ONFI optional commands SET/GET FEATURES supported? */
+/* ONFI optional commands READ CACHE and SET/GET FEATURES supported? */
+#define ONFI_OPT_CMD_READ_CACHE		(1 << 1)
 #define ONFI_OPT_CMD_SET_GET_FEATURES	(1 << 2)
 
 struct nand_onfi_params {
@@ -856,6 +864,8 @@ nand_get_sdr_timings(const struct nand_data_interface *conf)
  *			data_buf.
  * @pagebuf_bitflips:	[INTERN] holds the bitflip count for the page which is
  *			currently in data_buf.
+ * @page_cache:		[INTERN] recently read pages, see
+ *			CONFIG_NAND_PAGE_CACHE. NULL if not used.
  * @subpagesize:	[INTERN] holds the subpagesize
  * @onfi_version:	[INTERN] holds the chip ONFI version (BCD encoded),
  *			non 0 if ONFI supported.
@@ -932,6 +942,7 @@ struct nand_chip {
 	int pagemask;
 	int pagebuf;
 	unsigned int pagebuf_bitflips;
+	struct nand_page_cache *page_cache;
 	int subpagesize;
 	uint8_t bits_per_cell;
 	uint16_t ecc_strength_ds;
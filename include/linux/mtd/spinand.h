@@ -69,6 +69,12 @@
 		   SPI_MEM_OP_NO_DUMMY,					\
 		   SPI_MEM_OP_NO_DATA)
 
+#define SPINAND_PAGE_READ_CACHE_SEQ_OP(last)				\
+	SPI_MEM_OP(SPI_MEM_OP_CMD((last) ? 0x3f : 0x31, 1),		\
+		   SPI_MEM_OP_NO_ADDR,					\
+		   SPI_MEM_OP_NO_DUMMY,					\
+		   SPI_MEM_OP_NO_DATA)
+
 #define SPINAND_PAGE_READ_FROM_CACHE_OP(fast, addr, ndummy, buf, len)	\
 	SPI_MEM_OP(SPI_MEM_OP_CMD(fast ? 0x0b : 0x03, 1),		\
 		   SPI_MEM_OP_ADDR(2, addr, 1),				\
@@ -245,6 +251,7 @@ struct spinand_ecc_info {
 };
 
 #define SPINAND_HAS_QE_BIT		BIT(0)
+#define SPINAND_HAS_CACHE_SEQ_READ	BIT(1)
 
 /**
  * struct spinand_info - Structure used to describe SPI NAND chips
@@ -260,6 +267,9 @@ struct spinand_ecc_info {
  * @op_variants.update_cache: variants of the update-cache operation
  * @select_target: function used to select a target/die. Required only for
  *		   multi-die chips
+ * @set_cont_read: enable or disable the continuous read mode, where the
+ *		   read-from-cache operation keeps streaming the following
+ *		   pages. Only for chips supporting it
  *
  * Each SPI NAND manufacturer driver should have a spinand_info table
  * describing all the chips supported by the driver.
@@ -278,6 +288,7 @@ struct spinand_info {
 	} op_variants;
 	int (*select_target)(struct spinand_device *spinand,
 			     unsigned int target);
+	int (*set_cont_read)(struct spinand_device *spinand, bool enable);
 };
 
 #define SPINAND_INFO_OP_VARIANTS(__read, __write, __update)		\
@@ -296,6 +307,9 @@ struct spinand_info {
 #define SPINAND_SELECT_TARGET(__func)					\
 	.select_target = __func,
 
+#define SPINAND_CONT_READ(__func)					\
+	.set_cont_read = __func,
+
 #define SPINAND_INFO(__model, __id, __memorg, __eccreq, __op_variants,	\
 		     __flags, ...)					\
 	{								\
@@ -323,6 +337,8 @@ struct spinand_info {
  *		   a command addressing a page or an eraseblock embedded in
  *		   this die. Only required if your chip exposes several dies
  * @cur_target: currently selected target/die
+ * @set_cont_read: enable or disable the continuous read mode. NULL if the
+ *		   chip does not support it
  * @eccinfo: on-die ECC information
  * @cfg_cache: config register cache. One entry per die
  * @databuf: bounce buffer for data
@@ -355,6 +371,8 @@ struct spinand_device {
 			     unsigned int target);
 	unsigned int cur_target;
 
+	int (*set_cont_read)(struct spinand_device *spinand, bool enable);
+
 	struct spinand_ecc_info eccinfo;
 
 	u8 *cfg_cache;
@@ -21,4 +21,38 @@
  */
 int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn);
 
+/**
+ * LZ4_decompress_safe() - Decompress a single raw LZ4 block
+ *
+ * Unlike ulz4fn() this expects no frame header, as used by filesystems
+ * which compress each block on its own.
+ *
+ * @source: Compressed block
+ * @dest: Destination for uncompressed data
+ * @inputSize: Exact length of the compressed block
+ * @maxOutputSize: Size of the destination buffer
+ * @return number of bytes written to @dest, or negative if the block is
+ *	malformed or would overrun @dest
+ */
+int LZ4_decompress_safe(const char *source, char *dest, int inputSize,
+			int maxOutputSize);
+
+/**
+ * LZ4_decompress_safe_partial() - Decompress the start of a raw LZ4 block
+ *
+ * Stop once at least @targetOutputSize bytes have been produced. This also
+ * copes with input which is followed by padding, since decoding does not
+ * need to reach the exact end of @source.
+ *
+ * @source: Compressed block
+ * @dest: Destination for uncompressed data
+ * @inputSize: Maximum length of the compressed block
+ * @targetOutputSize: Number of bytes needed in @dest
+ * @maxOutputSize: Size of the destination buffer
+ * @return number of bytes written to @dest, which may exceed
+ *	@targetOutputSize, or negative if the block is malformed
+ */
+int LZ4_decompress_safe_partial(const char *source, char *dest, int inputSize,
+				int targetOutputSize, int maxOutputSize);
+
 #endif
@@ -73,6 +73,8 @@ struct bd_info;
 #define MMC_CAP_NONREMOVABLE	BIT(14)
 #define MMC_CAP_NEEDS_POLL	BIT(15)
 #define MMC_CAP_CD_ACTIVE_HIGH  BIT(16)
+#define MMC_CAP_CMD23		BIT(17)	/* SET_BLOCK_COUNT before transfers */
+#define MMC_CAP_SG		BIT(18)	/* takes MMC_DATA_SG transfers */
 
 #define MMC_MODE_8BIT		BIT(30)
 #define MMC_MODE_4BIT		BIT(29)
@@ -81,12 +83,17 @@ struct bd_info;
 
 
 #define SD_DATA_4BIT	0x00040000
+#define SD_CMD23_SUPPORT	0x00000002
 
 #define IS_SD(x)	((x)->version & SD_VERSION_SD)
 #define IS_MMC(x)	((x)->version & MMC_VERSION_MMC)
 
 #define MMC_DATA_READ		1
 #define MMC_DATA_WRITE		2
+#define MMC_DATA_SG		4	/* buffer is data->sg, see MMC_CAP_SG */
+
+/* Maximum number of segments in an MMC_DATA_SG transfer */
+#define MMC_MAX_SG		32
 
 #define MMC_CMD_GO_IDLE_STATE		0
 #define MMC_CMD_SEND_OP_COND		1
@@ -398,10 +405,12 @@ struct mmc_data {
 	union {
 		char *dest;
 		const char *src; /* src buffers don't get written to */
+		const struct blk_sg *sg; /* with MMC_DATA_SG */
 	};
 	uint flags;
 	uint blocks;
 	uint blocksize;
+	uint sg_count;	/* entries in sg, only valid with MMC_DATA_SG */
 };
 
 /* forward decl. */
@@ -12,6 +12,10 @@ struct host_block_dev {
 #endif
 	char *filename;
 	int fd;
+#ifdef CONFIG_BLK
+	struct list_head reqs;
+	int nr_reqs;
+#endif
 };
 
 int host_dev_bind(int dev, char *filename);
@@ -278,11 +278,17 @@ struct sdhci_ops {
 #else
 #define ADMA_DESC_LEN	8
 #endif
-#define ADMA_TABLE_NO_ENTRIES (CONFIG_SYS_MMC_MAX_BLK_COUNT * \
-			       MMC_MAX_BLOCK_LEN) / ADMA_MAX_LEN
+/* Each segment may add an alignment and a partial descriptor */
+#define ADMA_TABLE_NO_ENTRIES (DIV_ROUND_UP(CONFIG_SYS_MMC_MAX_BLK_COUNT * \
+					   MMC_MAX_BLOCK_LEN, ADMA_MAX_LEN) + \
+			       2 * MMC_MAX_SG)
 
 #define ADMA_TABLE_SZ (ADMA_TABLE_NO_ENTRIES * ADMA_DESC_LEN)
 
+/* Buffer addresses must be aligned, see sdhci_prepare_adma_table() */
+#define ADMA_ALIGN	4
+#define ADMA_ALIGN_SZ	ROUND(MMC_MAX_SG * ADMA_ALIGN, ARCH_DMA_MINALIGN)
+
 /* Decriptor table defines */
 #define ADMA_DESC_ATTR_VALID		BIT(0)
 #define ADMA_DESC_ATTR_END		BIT(1)
@@ -334,6 +340,7 @@ struct sdhci_host {
 	dma_addr_t adma_addr;
 #if CONFIG_IS_ENABLED(MMC_SDHCI_ADMA)
 	struct sdhci_adma_desc *adma_desc_table;
+	void *adma_align_buffer;
 	uint desc_slot;
 #endif
 };
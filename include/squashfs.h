@@ -0,0 +1,22 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * SquashFS filesystem implementation for U-Boot
+ */
+
+#ifndef __U_BOOT_SQUASHFS_H__
+#define __U_BOOT_SQUASHFS_H__
+
+struct fs_dir_stream;
+struct fs_dirent;
+
+int sqfs_probe(struct blk_desc *fs_dev_desc, disk_partition_t *fs_partition);
+int sqfs_opendir(const char *filename, struct fs_dir_stream **dirsp);
+int sqfs_readdir(struct fs_dir_stream *dirs, struct fs_dirent **dentp);
+void sqfs_closedir(struct fs_dir_stream *dirs);
+int sqfs_read(const char *filename, void *buf, loff_t offset, loff_t len,
+	      loff_t *actread);
+int sqfs_size(const char *filename, loff_t *size);
+int sqfs_exists(const char *filename);
+void sqfs_close(void);
+
+#endif /* __U_BOOT_SQUASHFS_H__ */
@@ -179,6 +179,21 @@ int usb_reset_root_port(struct usb_device *dev);
 #define usb_reset_root_port(dev)
 #endif
 
+/**
+ * struct usb_bulk_xfer - one bulk message of a batch
+ *
+ * @buffer:	Data buffer
+ * @length:	Number of bytes to transfer
+ * @act_len:	Set to the number of bytes transferred
+ * @status:	Set to the USB_ST_... status, USB_ST_NOT_PROC if not done
+ */
+struct usb_bulk_xfer {
+	void *buffer;
+	int length;
+	int act_len;
+	unsigned long status;
+};
+
 int submit_bulk_msg(struct usb_device *dev, unsigned long pipe,
 			void *buffer, int transfer_len);
 int submit_control_msg(struct usb_device *dev, unsigned long pipe, void *buffer,
@@ -651,11 +666,13 @@ struct usb_dev_platdata {
  *		so this will be false.
  * @companion:  True if this is a companion controller to another USB
  *		controller
+ * @scan_err:	Result of starting the scan of the root hub, 0 if OK
  */
 struct usb_bus_priv {
 	int next_addr;
 	bool desc_before_addr;
 	bool companion;
+	int scan_err;
 };
 
 /**
@@ -706,6 +723,17 @@ struct dm_usb_ops {
 	 */
 	int (*bulk)(struct udevice *bus, struct usb_device *udev,
 		    unsigned long pipe, void *buffer, int length);
+	/**
+	 * bulk_batch() - Send several bulk messages to one endpoint
+	 *
+	 * Optional, see submit_bulk_msg_batch().
+	 *
+	 * @xfers: Messages to send, in order
+	 * @count: Number of entries in @xfers
+	 */
+	int (*bulk_batch)(struct udevice *bus, struct usb_device *udev,
+			  unsigned long pipe, struct usb_bulk_xfer *xfers,
+			  int count);
 	/**
 	 * interrupt() - Send an interrupt message
 	 *
@@ -851,6 +879,19 @@ bool usb_hub_is_root_hub(struct udevice *hub);
  */
 int usb_hub_scan(struct udevice *hub);
 
+/**
+ * usb_hub_scan_hold() - Hold back the port scan of new hubs
+ *
+ * While held, configuring a hub powers up its ports and queues them for
+ * scanning without waiting for them. This lets the power-on and connect
+ * delays of several hubs run at the same time. Releasing the hold scans
+ * all queued ports together.
+ *
+ * @hold:	true to hold, false to release and scan
+ * @return 0 if OK, -ve on error
+ */
+int usb_hub_scan_hold(bool hold);
+
 /**
  * usb_scan_device() - Scan a device on a bus
  *
@@ -997,6 +1038,23 @@ int usb_update_hub_device(struct usb_device *dev);
  */
 int usb_get_max_xfer_size(struct usb_device *dev, size_t *size);
 
+/**
+ * submit_bulk_msg_batch() - Send several bulk messages to one endpoint
+ *
+ * Controllers which support it queue the messages together and complete
+ * them in order, which avoids the gap between back-to-back messages. Others
+ * send one message after the other. The batch stops at the first message
+ * which fails, the messages after it keep the status USB_ST_NOT_PROC.
+ *
+ * @dev:		USB device
+ * @pipe:		Bulk pipe to use
+ * @xfers:		Messages to send, act_len and status are filled in
+ * @count:		Number of entries in @xfers
+ * @return 0 if all messages were processed, -ve on error
+ */
+int submit_bulk_msg_batch(struct usb_device *dev, unsigned long pipe,
+			  struct usb_bulk_xfer *xfers, int count);
+
 /**
  * usb_emul_setup_device() - Set up a new USB device emulation
  *
@@ -31,7 +31,8 @@
  * Algorithmic details:
  *
  * Encoding is performed by processing 32 input bits in parallel, using 4
- * remainder lookup tables.
+ * remainder lookup tables. Syndromes are computed 8 ecc bits at a time, using
+ * a lookup table per syndrome.
  *
  * The final stage of decoding involves the following internal steps:
  * a. Syndrome computation
@@ -103,6 +104,9 @@
 #define BCH_ECC_WORDS(_p)      DIV_ROUND_UP(GF_M(_p)*GF_T(_p), 32)
 #define BCH_ECC_BYTES(_p)      DIV_ROUND_UP(GF_M(_p)*GF_T(_p), 8)
 
+/* syn_tab entry of a zero value, which has no logarithm */
+#define BCH_SYN_TAB_ZERO       0xffff
+
 #ifndef dbg
 #define dbg(_fmt, args...)     do {} while (0)
 #endif
@@ -381,13 +385,18 @@ static inline int a_ilog(struct bch_control *bch, unsigned int x)
 
 /*
  * compute 2t syndromes of ecc polynomial, i.e. ecc(a^j) for j=1..2t
+ *
+ * The ecc polynomial is processed 8 coefficients at a time: the byte b
+ * holding the coefficients of x^e .. x^(e+7) adds a^(j*e)*b(a^j) to
+ * ecc(a^j), and the logarithm of b(a^j) is looked up in syn_tab.
  */
 static void compute_syndromes(struct bch_control *bch, uint32_t *ecc,
 			      unsigned int *syn)
 {
-	int i, j, s;
-	unsigned int m;
+	int j, q, s;
+	unsigned int m, b, e, e2, x;
 	uint32_t poly;
+	const uint16_t *tab;
 	const int t = GF_T(bch);
 
 	s = bch->ecc_bits;
@@ -402,12 +411,22 @@ static void compute_syndromes(struct bch_control *bch, uint32_t *ecc,
 	do {
 		poly = *ecc++;
 		s -= 32;
-		while (poly) {
-			i = deg(poly);
-			for (j = 0; j < 2*t; j += 2)
-				syn[j] ^= a_pow(bch, (j+1)*(i+s));
-
-			poly ^= (1 << i);
+		for (q = 0; poly; q++, poly >>= 8) {
+			b = poly & 0xff;
+			if (!b)
+				continue;
+
+			/* the first bytes of the last word may start below 0 */
+			e = mod_s(bch, s+8*q+GF_N(bch));
+			e2 = mod_s(bch, 2*e);
+			tab = bch->syn_tab;
+			/* x runs through (j+1)*e mod n */
+			for (j = 0, x = e; j < 2*t; j += 2, tab += 256) {
+				if (tab[b] != BCH_SYN_TAB_ZERO)
+					syn[j] ^= bch->a_pow_tab[mod_s(bch,
+								     tab[b]+x)];
+				x = mod_s(bch, x+e2);
+			}
 		}
 	} while (s > 0);
 
@@ -1120,6 +1139,26 @@ static int build_gf_tables(struct bch_control *bch, unsigned int poly)
 	return 0;
 }
 
+/*
+ * compute b(a^j) for every byte b and odd j=1..2t-1, see compute_syndromes()
+ */
+static void build_syn_tables(struct bch_control *bch)
+{
+	unsigned int j, b, k, v;
+	uint16_t *tab = bch->syn_tab;
+
+	for (j = 1; j < 2*GF_T(bch); j += 2) {
+		for (b = 0; b < 256; b++) {
+			for (k = 0, v = 0; k < 8; k++)
+				if (b & (1 << k))
+					v ^= a_pow(bch, j*k);
+
+			tab[b] = v ? a_log(bch, v) : BCH_SYN_TAB_ZERO;
+		}
+		tab += 256;
+	}
+}
+
 /*
  * compute generator polynomial remainder tables for fast encoding
  */
@@ -1350,6 +1389,7 @@ struct bch_control *init_bch(int m, int t, unsigned int prim_poly)
 	bch->ecc_buf2  = bch_alloc(words*sizeof(*bch->ecc_buf2), &err);
 	bch->xi_tab    = bch_alloc(m*sizeof(*bch->xi_tab), &err);
 	bch->syn       = bch_alloc(2*t*sizeof(*bch->syn), &err);
+	bch->syn_tab   = bch_alloc(t*256*sizeof(*bch->syn_tab), &err);
 	bch->cache     = bch_alloc(2*t*sizeof(*bch->cache), &err);
 	bch->elp       = bch_alloc((t+1)*sizeof(struct gf_poly_deg1), &err);
 
@@ -1371,6 +1411,8 @@ struct bch_control *init_bch(int m, int t, unsigned int prim_poly)
 	build_mod8_tables(bch, genpoly);
 	kfree(genpoly);
 
+	build_syn_tables(bch);
+
 	err = build_deg2_base(bch);
 	if (err)
 		goto fail;
@@ -1398,6 +1440,7 @@ void free_bch(struct bch_control *bch)
 		kfree(bch->ecc_buf2);
 		kfree(bch->xi_tab);
 		kfree(bch->syn);
+		kfree(bch->syn_tab);
 		kfree(bch->cache);
 		kfree(bch->elp);
 
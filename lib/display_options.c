@@ -9,6 +9,7 @@
 #include <div64.h>
 #include <version.h>
 #include <linux/ctype.h>
+#include <linux/math64.h>
 #include <asm/io.h>
 
 char *display_options_get_banner_priv(bool newlines, const char *build_tag,
@@ -130,6 +131,22 @@ void print_size(uint64_t size, const char *s)
 	printf (" %ciB%s", c, s);
 }
 
+void print_rate(uint64_t bytes, uint64_t time_us)
+{
+	if (!time_us)
+		return;
+
+	puts(" (");
+	print_size(div64_u64(bytes * 1000000, time_us), "/s)");
+}
+
+void print_read_time(uint64_t bytes, ulong time_ms)
+{
+	printf("%llu bytes read in %lu ms", bytes, time_ms);
+	print_rate(bytes, (uint64_t)time_ms * 1000);
+	puts("\n");
+}
+
 #define MAX_LINE_LENGTH_BYTES (64)
 #define DEFAULT_LINE_LENGTH_BYTES (16)
 int print_buffer(ulong addr, const void *data, uint width, uint count,
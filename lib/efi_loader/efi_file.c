@@ -33,6 +33,9 @@ struct file_handle {
 	int isdir;
 	u64 open_mode;
 
+	/* for reading a regular file: */
+	struct fs_file *file;
+
 	/* for reading a directory: */
 	struct fs_dir_stream *dirs;
 	struct fs_dirent *dent;
@@ -295,6 +298,7 @@ out:
 
 static efi_status_t file_close(struct file_handle *fh)
 {
+	fs_file_close(fh->file);
 	fs_closedir(fh->dirs);
 	free(fh);
 	return EFI_SUCCESS;
@@ -314,6 +318,8 @@ static efi_status_t EFIAPI efi_file_delete(struct efi_file_handle *file)
 
 	EFI_ENTRY("%p", file);
 
+	fs_file_close(fh->file);
+	fh->file = NULL;
 	if (set_blk_dev(fh) || fs_unlink(fh->path))
 		ret = EFI_WARN_DELETE_FAILURE;
 
@@ -331,6 +337,11 @@ static efi_status_t EFIAPI efi_file_delete(struct efi_file_handle *file)
 static efi_status_t efi_get_file_size(struct file_handle *fh,
 				      loff_t *file_size)
 {
+	if (fh->file) {
+		*file_size = fh->file->size;
+		return EFI_SUCCESS;
+	}
+
 	if (set_blk_dev(fh))
 		return EFI_DEVICE_ERROR;
 
@@ -344,21 +355,19 @@ static efi_status_t file_read(struct file_handle *fh, u64 *buffer_size,
 		void *buffer)
 {
 	loff_t actread;
-	efi_status_t ret;
-	loff_t file_size;
 
-	ret = efi_get_file_size(fh, &file_size);
-	if (ret != EFI_SUCCESS)
-		return ret;
-	if (file_size < fh->offset) {
-		ret = EFI_DEVICE_ERROR;
-		return ret;
+	/* Keep the file system mounted until the handle is closed */
+	if (!fh->file) {
+		if (set_blk_dev(fh))
+			return EFI_DEVICE_ERROR;
+		fh->file = fs_open(fh->path);
+		if (!fh->file)
+			return EFI_DEVICE_ERROR;
 	}
-
-	if (set_blk_dev(fh))
+	if (fh->file->size < fh->offset)
 		return EFI_DEVICE_ERROR;
-	if (fs_read(fh->path, map_to_sysmem(buffer), fh->offset,
-		    *buffer_size, &actread))
+
+	if (fs_pread(fh->file, buffer, fh->offset, *buffer_size, &actread))
 		return EFI_DEVICE_ERROR;
 
 	*buffer_size = actread;
@@ -499,6 +508,9 @@ static efi_status_t EFIAPI efi_file_write(struct efi_file_handle *file,
 	if (!*buffer_size)
 		goto out;
 
+	/* The size recorded in the read handle is about to become stale */
+	fs_file_close(fh->file);
+	fh->file = NULL;
 	if (set_blk_dev(fh)) {
 		ret = EFI_DEVICE_ERROR;
 		goto out;
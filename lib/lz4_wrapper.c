@@ -136,3 +136,19 @@ int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn)
 	*dstn = out - dst;
 	return ret;
 }
+
+int LZ4_decompress_safe(const char *source, char *dest, int inputSize,
+			int maxOutputSize)
+{
+	return LZ4_decompress_generic(source, dest, inputSize, maxOutputSize,
+				      endOnInputSize, full, 0, noDict,
+				      (BYTE *)dest, NULL, 0);
+}
+
+int LZ4_decompress_safe_partial(const char *source, char *dest, int inputSize,
+				int targetOutputSize, int maxOutputSize)
+{
+	return LZ4_decompress_generic(source, dest, inputSize, maxOutputSize,
+				      endOnInputSize, partial, targetOutputSize,
+				      noDict, (BYTE *)dest, NULL, 0);
+}
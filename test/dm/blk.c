@@ -4,7 +4,11 @@
  */
 
 #include <common.h>
+#include <blk.h>
 #include <dm.h>
+#include <malloc.h>
+#include <os.h>
+#include <sandboxblockdev.h>
 #include <usb.h>
 #include <asm/state.h>
 #include <dm/test.h>
@@ -162,3 +166,63 @@ static int dm_test_blk_get_from_parent(struct unit_test_state *uts)
 	return 0;
 }
 DM_TEST(dm_test_blk_get_from_parent, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+/* Test asynchronous requests on a sandbox host device */
+static int dm_test_blk_async(struct unit_test_state *uts)
+{
+	const int blksz = 512, nblks = 64, nreqs = 4;
+	struct blk_req req[nreqs];
+	struct udevice *dev;
+	u8 *data, *buf;
+	int i;
+
+	data = malloc(nblks * blksz);
+	ut_assertnonnull(data);
+	buf = malloc(nblks * blksz);
+	ut_assertnonnull(buf);
+	for (i = 0; i < nblks * blksz; i++)
+		data[i] = i / blksz + i;
+	ut_assertok(os_write_file("blk_async.img", data, nblks * blksz));
+	ut_assertok(host_dev_bind(0, "blk_async.img"));
+	ut_assertok(blk_get_device(IF_TYPE_HOST, 0, &dev));
+
+	/* Read the image in several requests, all in flight together */
+	memset(buf, 0, nblks * blksz);
+	for (i = 0; i < nreqs; i++) {
+		req[i].write = false;
+		req[i].start = i * nblks / nreqs;
+		req[i].blkcnt = nblks / nreqs;
+		req[i].buffer = buf + i * nblks / nreqs * blksz;
+		ut_assertok(blk_submit(dev, &req[i]));
+	}
+	ut_asserteq(nreqs, blk_poll(dev) + 1);
+	for (i = 0; i < nreqs; i++)
+		ut_asserteq(nblks / nreqs, blk_wait(dev, &req[i]));
+	ut_asserteq(0, blk_poll(dev));
+	ut_assertok(memcmp(data, buf, nblks * blksz));
+
+	/* Write new data and read it back the synchronous way */
+	for (i = 0; i < nblks; i++)
+		memset(buf + i * blksz, i, blksz);
+	req[0].write = true;
+	req[0].start = 0;
+	req[0].blkcnt = nblks;
+	req[0].buffer = buf;
+	ut_assertok(blk_submit(dev, &req[0]));
+	ut_asserteq(nblks, blk_wait(dev, &req[0]));
+	ut_asserteq(nblks, blk_dread(dev_get_uclass_platdata(dev), 0, nblks,
+				     data));
+	ut_assertok(memcmp(data, buf, nblks * blksz));
+
+	/* A request which was never submitted cannot be waited for */
+	req[1].done = false;
+	ut_asserteq(-EINVAL, blk_wait(dev, &req[1]));
+
+	ut_assertok(host_dev_bind(0, NULL));
+	os_unlink("blk_async.img");
+	free(buf);
+	free(data);
+
+	return 0;
+}
+DM_TEST(dm_test_blk_async, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
@@ -41,3 +41,28 @@ static int dm_test_mmc_blk(struct unit_test_state *uts)
 	return 0;
 }
 DM_TEST(dm_test_mmc_blk, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+static int dm_test_mmc_blk_sg(struct unit_test_state *uts)
+{
+	struct blk_desc *dev_desc;
+	char buf1[512], buf2[1024];
+	struct blk_sg sg[] = {
+		{ .buffer = buf1, .blkcnt = 1 },
+		{ .buffer = buf2, .blkcnt = 2 },
+	};
+
+	ut_assertok(blk_get_device_by_str("mmc", "0", &dev_desc));
+
+	/*
+	 * A single-block read returns zeroes, so finding the string in the
+	 * first segment shows that all segments were read with one command
+	 */
+	memset(buf1, '\0', sizeof(buf1));
+	memset(buf2, '\0', sizeof(buf2));
+	ut_asserteq(3, blk_dread_sg(dev_desc, 0, sg, ARRAY_SIZE(sg)));
+	ut_assertok(strcmp(buf1, "this is a test"));
+	ut_assertok(strcmp(buf2, "this is a test"));
+
+	return 0;
+}
+DM_TEST(dm_test_mmc_blk_sg, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
@@ -101,3 +101,79 @@ static int dm_test_spi_flash_func(struct unit_test_state *uts)
 	return 0;
 }
 DM_TEST(dm_test_spi_flash_func, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+#ifdef CONFIG_CMD_MTD_BENCH
+/* Run the MTD benchmark on the sandbox SPI flash and check what it wrote */
+static int dm_test_spi_flash_mtd_bench(struct unit_test_state *uts)
+{
+	struct udevice *dev;
+	int size = 0x20000;
+	u8 *dst;
+	int i;
+
+	ut_asserteq(0, run_command_list(
+		"host save hostfs - 0 spi.bin 200000;"
+		"sf probe;"
+		"mtd bench.write nor0 0 20000;"
+		"mtd bench nor0 10000 10000", -1, 0));
+
+	/* The program pass leaves its pattern behind */
+	ut_assertok(uclass_first_device_err(UCLASS_SPI_FLASH, &dev));
+	dst = map_sysmem(0x20000, size);
+	ut_assertok(spi_flash_read_dm(dev, 0, size, dst));
+	for (i = 0; i < size; i++)
+		ut_asserteq((u8)i ^ 0x5a, dst[i]);
+
+	/* Unaligned ranges and ranges past the end are refused */
+	ut_asserteq(1, run_command("mtd bench nor0 80 10000", 0));
+	ut_asserteq(1, run_command("mtd bench.write nor0 0 1000", 0));
+	ut_asserteq(1, run_command("mtd bench nor0 1f0000 20000", 0));
+
+	sandbox_sf_unbind_emul(state_get_current(), 0, 0);
+
+	return 0;
+}
+DM_TEST(dm_test_spi_flash_mtd_bench, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+#endif
+
+/* Update the sandbox SPI flash over blank and programmed sectors */
+static int dm_test_spi_flash_update(struct unit_test_state *uts)
+{
+	struct udevice *dev;
+	int size = 0x20000;
+	int len = 0x1ff00;
+	u8 *src, *old, *dst;
+	int i;
+
+	ut_assertok(run_command_list(
+		"host save hostfs - 0 spi.bin 200000;"
+		"sf probe;"
+		"sf erase 0 10000", -1, 0));
+	ut_assertok(uclass_first_device_err(UCLASS_SPI_FLASH, &dev));
+
+	old = map_sysmem(0x300000, size);
+	ut_assertok(spi_flash_read_dm(dev, 0, size, old));
+
+	/* Leave a few all-0xff pages in the new data */
+	src = map_sysmem(0x400000, size);
+	for (i = 0; i < len; i++)
+		src[i] = (i & 0x400) ? 0xff : i;
+
+	/* The first sector is blank, the second one needs an erase */
+	ut_assertok(run_command("sf update 400000 0 1ff00", 0));
+	dst = map_sysmem(0x500000, size);
+	ut_assertok(spi_flash_read_dm(dev, 0, size, dst));
+	ut_assertok(memcmp(src, dst, len));
+	ut_assertok(memcmp(old + len, dst + len, size - len));
+
+	/* Nothing changes the second time */
+	ut_assertok(run_command("sf update 400000 0 1ff00", 0));
+	ut_assertok(spi_flash_read_dm(dev, 0, size, dst));
+	ut_assertok(memcmp(src, dst, len));
+	ut_assertok(memcmp(old + len, dst + len, size - len));
+
+	sandbox_sf_unbind_emul(state_get_current(), 0, 0);
+
+	return 0;
+}
+DM_TEST(dm_test_spi_flash_update, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
@@ -6,6 +6,7 @@
 #include <common.h>
 #include <console.h>
 #include <dm.h>
+#include <scsi.h>
 #include <usb.h>
 #include <asm/io.h>
 #include <asm/state.h>
@@ -61,6 +62,56 @@ static int dm_test_usb_flash(struct unit_test_state *uts)
 }
 DM_TEST(dm_test_usb_flash, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
 
+/* Test reading the data and the status of a command as one batch */
+static int dm_test_usb_bulk_batch(struct unit_test_state *uts)
+{
+	struct usb_bulk_xfer xfers[2];
+	struct umass_bbb_cbw cbw;
+	struct umass_bbb_csw csw;
+	struct usb_device *udev;
+	struct udevice *dev;
+	char cmp[512];
+	int actlen;
+
+	state_set_skip_delays(true);
+	ut_assertok(usb_init());
+	ut_assertok(uclass_get_device(UCLASS_MASS_STORAGE, 0, &dev));
+	udev = dev_get_parent_priv(dev);
+
+	/* READ(10) of the first block, sent to the OUT endpoint 1 */
+	memset(&cbw, '\0', sizeof(cbw));
+	cbw.dCBWSignature = cpu_to_le32(CBWSIGNATURE);
+	cbw.dCBWTag = cpu_to_le32(1);
+	cbw.dCBWDataTransferLength = cpu_to_le32(sizeof(cmp));
+	cbw.bCBWFlags = CBWFLAGS_IN;
+	cbw.bCDBLength = 10;
+	cbw.CBWCDB[0] = SCSI_READ10;
+	cbw.CBWCDB[8] = 1;
+	ut_assertok(usb_bulk_msg(udev, usb_sndbulkpipe(udev, 1), &cbw,
+				 UMASS_BBB_CBW_SIZE, &actlen, 1000));
+
+	/* Data and status both come from the IN endpoint 2 */
+	memset(cmp, '\0', sizeof(cmp));
+	xfers[0].buffer = cmp;
+	xfers[0].length = sizeof(cmp);
+	xfers[1].buffer = &csw;
+	xfers[1].length = UMASS_BBB_CSW_SIZE;
+	ut_assertok(submit_bulk_msg_batch(udev, usb_rcvbulkpipe(udev, 2),
+					  xfers, 2));
+	ut_asserteq(0, xfers[0].status);
+	ut_asserteq(sizeof(cmp), xfers[0].act_len);
+	ut_assertok(strcmp(cmp, "this is a test"));
+	ut_asserteq(0, xfers[1].status);
+	ut_asserteq(UMASS_BBB_CSW_SIZE, xfers[1].act_len);
+	ut_asserteq(CSWSIGNATURE, le32_to_cpu(csw.dCSWSignature));
+	ut_asserteq(1, le32_to_cpu(csw.dCSWTag));
+	ut_asserteq(CSWSTATUS_GOOD, csw.bCSWStatus);
+	ut_assertok(usb_stop());
+
+	return 0;
+}
+DM_TEST(dm_test_usb_bulk_batch, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
 /* test that we can handle multiple storage devices */
 static int dm_test_usb_multi(struct unit_test_state *uts)
 {
@@ -0,0 +1,265 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Unit tests for the BCH encoder and decoder
+ *
+ * Errors are injected into encoded data and decode_bch() must report
+ * exactly their locations. The syndromes computed by decode_bch() are
+ * checked against a plain evaluation of the error polynomial.
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include <linux/bch.h>
+#include <test/lib.h>
+#include <test/test.h>
+#include <test/ut.h>
+
+/* Largest ecc and error count of the configurations tested below */
+#define BCH_TEST_MAX_ECC	64
+#define BCH_TEST_MAX_T		16
+
+static u32 bch_test_seed;
+
+static u32 bch_test_rand(void)
+{
+	bch_test_seed = bch_test_seed * 1103515245 + 12345;
+
+	return bch_test_seed >> 8;
+}
+
+/*
+ * Map bit @r of the codeword, counting from the first data bit, to the
+ * errloc numbering of decode_bch(). This skips the pad bits of the last
+ * ecc byte when ecc_bits is not a multiple of 8.
+ */
+static unsigned int bch_test_loc(unsigned int r)
+{
+	return (r & ~7) | (7 - (r & 7));
+}
+
+/* Flip a bit of the codeword, @pos uses the errloc numbering of decode_bch() */
+static void bch_test_flip(u8 *data, u8 *ecc, unsigned int len,
+			  unsigned int pos)
+{
+	if (pos < 8 * len)
+		data[pos / 8] ^= 1 << (pos % 8);
+	else
+		ecc[pos / 8 - len] ^= 1 << (pos % 8);
+}
+
+/**
+ * bch_test_check() - decode and compare against the injected errors
+ *
+ * @uts:	test state
+ * @bch:	BCH control structure
+ * @data:	data with the errors applied
+ * @len:	length of @data in bytes
+ * @ecc:	ecc of the data before the errors were applied
+ * @pos:	the injected error locations, all different
+ * @count:	number of entries in @pos
+ * Return:	0 if OK, -ve on error
+ */
+static int bch_test_check(struct unit_test_state *uts, struct bch_control *bch,
+			  const u8 *data, unsigned int len, const u8 *ecc,
+			  const unsigned int *pos, int count)
+{
+	const unsigned int nbits = 8 * len + bch->ecc_bits;
+	unsigned int errloc[BCH_TEST_MAX_T];
+	unsigned int syn, r;
+	int i, j, k, found;
+
+	ut_asserteq(count, decode_bch(bch, data, len, ecc, NULL, NULL,
+				      errloc));
+	if (!count)
+		return 0;
+
+	for (i = 0; i < count; i++) {
+		for (j = 0, found = 0; j < count; j++)
+			found += errloc[j] == pos[i];
+		ut_asserteq(1, found);
+	}
+
+	/* syndrome j is the sum of a^(j*r) over the error degrees r */
+	for (j = 1; j <= 2 * bch->t; j++) {
+		for (k = 0, syn = 0; k < count; k++) {
+			r = nbits - 1 - bch_test_loc(pos[k]);
+			syn ^= bch->a_pow_tab[(j * r) % bch->n];
+		}
+		ut_asserteq(syn, bch->syn[j - 1]);
+	}
+
+	return 0;
+}
+
+/* Inject every single and double bit error into a short codeword */
+static int lib_test_bch_exhaustive(struct unit_test_state *uts)
+{
+	const unsigned int len = 16;
+	u8 data[16], ref[16], ecc[BCH_TEST_MAX_ECC], fecc[BCH_TEST_MAX_ECC];
+	struct bch_control *bch;
+	unsigned int nbits, r0, r1, pos[2];
+	int i;
+
+	bch = init_bch(8, 2, 0);
+	ut_assertnonnull(bch);
+	nbits = 8 * len + bch->ecc_bits;
+
+	bch_test_seed = 1;
+	for (i = 0; i < len; i++)
+		ref[i] = bch_test_rand();
+	memset(ecc, 0, sizeof(ecc));
+	encode_bch(bch, ref, len, ecc);
+
+	memcpy(data, ref, len);
+	ut_assertok(bch_test_check(uts, bch, data, len, ecc, pos, 0));
+
+	for (r0 = 0; r0 < nbits; r0++) {
+		pos[0] = bch_test_loc(r0);
+		memcpy(data, ref, len);
+		memcpy(fecc, ecc, bch->ecc_bytes);
+		bch_test_flip(data, fecc, len, pos[0]);
+		ut_assertok(bch_test_check(uts, bch, data, len, fecc, pos, 1));
+
+		for (r1 = r0 + 1; r1 < nbits; r1++) {
+			pos[1] = bch_test_loc(r1);
+			bch_test_flip(data, fecc, len, pos[1]);
+			ut_assertok(bch_test_check(uts, bch, data, len, fecc,
+						   pos, 2));
+			bch_test_flip(data, fecc, len, pos[1]);
+		}
+	}
+
+	free_bch(bch);
+
+	return 0;
+}
+
+LIB_TEST(lib_test_bch_exhaustive, 0);
+
+/* Pick a random error location that is not in @pos[0..@count - 1] yet */
+static unsigned int bch_test_pick(const unsigned int *pos, int count,
+				  unsigned int nbits)
+{
+	unsigned int loc;
+	int i;
+
+	do {
+		loc = bch_test_loc(bch_test_rand() % nbits);
+		for (i = 0; i < count; i++)
+			if (pos[i] == loc)
+				break;
+	} while (i < count);
+
+	return loc;
+}
+
+/* Inject up to t random errors into NAND sized codewords */
+static int lib_test_bch_random(struct unit_test_state *uts)
+{
+	static const struct {
+		int m, t;
+		unsigned int len;
+	} cfg[] = {
+		{ 13, 4, 512 },
+		{ 13, 8, 512 },
+		{ 14, 16, 1024 },
+	};
+	u8 ecc[BCH_TEST_MAX_ECC];
+	unsigned int pos[BCH_TEST_MAX_T];
+	struct bch_control *bch;
+	int c, i, k, iter, count;
+	u8 *data;
+
+	data = malloc(1024);
+	ut_assertnonnull(data);
+
+	bch_test_seed = 2;
+	for (c = 0; c < ARRAY_SIZE(cfg); c++) {
+		const unsigned int len = cfg[c].len;
+		unsigned int nbits;
+
+		bch = init_bch(cfg[c].m, cfg[c].t, 0);
+		ut_assertnonnull(bch);
+		nbits = 8 * len + bch->ecc_bits;
+
+		for (iter = 0; iter < 100; iter++) {
+			for (i = 0; i < len; i++)
+				data[i] = bch_test_rand();
+			memset(ecc, 0, sizeof(ecc));
+			encode_bch(bch, data, len, ecc);
+
+			count = bch_test_rand() % (cfg[c].t + 1);
+			for (k = 0; k < count; k++) {
+				pos[k] = bch_test_pick(pos, k, nbits);
+				bch_test_flip(data, ecc, len, pos[k]);
+			}
+
+			ut_assertok(bch_test_check(uts, bch, data, len, ecc,
+						   pos, count));
+		}
+		free_bch(bch);
+	}
+	free(data);
+
+	return 0;
+}
+
+LIB_TEST(lib_test_bch_random, 0);
+
+/*
+ * Decode from a received and a calculated ecc, as NAND drivers with a
+ * hardware ecc engine do, and correct the data with the result.
+ */
+static int lib_test_bch_calc_ecc(struct unit_test_state *uts)
+{
+	const unsigned int len = 512;
+	unsigned int errloc[BCH_TEST_MAX_T];
+	u8 ecc[BCH_TEST_MAX_ECC], calc[BCH_TEST_MAX_ECC];
+	struct bch_control *bch;
+	unsigned int i, k, pos;
+	u8 *data, *ref;
+	int iter, count;
+
+	bch = init_bch(13, 8, 0);
+	ut_assertnonnull(bch);
+	data = malloc(2 * len);
+	ut_assertnonnull(data);
+	ref = data + len;
+
+	bch_test_seed = 3;
+	for (iter = 0; iter < 100; iter++) {
+		for (i = 0; i < len; i++)
+			ref[i] = bch_test_rand();
+		memset(ecc, 0, sizeof(ecc));
+		encode_bch(bch, ref, len, ecc);
+
+		/* Only data bits, so the calculated ecc sees every error */
+		memcpy(data, ref, len);
+		count = bch_test_rand() % (bch->t + 1);
+		for (k = 0; k < count; k++) {
+			do {
+				pos = bch_test_rand() % (8 * len);
+			} while ((data[pos / 8] ^ ref[pos / 8]) &
+				 (1 << (pos % 8)));
+			data[pos / 8] ^= 1 << (pos % 8);
+		}
+
+		memset(calc, 0, sizeof(calc));
+		encode_bch(bch, data, len, calc);
+		ut_asserteq(count, decode_bch(bch, NULL, len, ecc, calc, NULL,
+					      errloc));
+
+		for (k = 0; k < count; k++) {
+			ut_assert(errloc[k] < 8 * len);
+			data[errloc[k] / 8] ^= 1 << (errloc[k] % 8);
+		}
+		ut_asserteq_mem(ref, data, len);
+	}
+
+	free(data);
+	free_bch(bch);
+
+	return 0;
+}
+
+LIB_TEST(lib_test_bch_calc_ecc, 0);
@@ -3,7 +3,12 @@
 # Author: JJ Hiblot <jjhiblot@ti.com>
 #
 
+import os
+import re
+import shutil
+import zlib
 from subprocess import check_call, CalledProcessError
+from fstest_defs import ADDR
 
 def assert_fs_integrity(fs_type, fs_img):
     try:
@@ -11,3 +16,113 @@ def assert_fs_integrity(fs_type, fs_img):
             check_call('fsck.ext4 -n -f %s' % fs_img, shell=True)
     except CalledProcessError:
         raise
+
+#
+# Helpers for the read-only file systems (SquashFS, EROFS)
+#
+
+RO_FILES = {
+    # Small enough to be stored inline or in a fragment
+    'small.txt': b'Hello U-Boot\n' * 30,
+    # Several blocks followed by a partial tail
+    'multi.bin': bytes(range(256)) * 1100,
+    # Block aligned, in a subdirectory
+    'dir/aligned.bin': bytes([i % 251 for i in range(256 * 1024)]),
+}
+
+def crc(data):
+    """Return the CRC32 of data as printed by the crc32 command."""
+    return '%08x' % (zlib.crc32(data) & 0xffffffff)
+
+def make_tree(base, files):
+    """Create files below base.src, plus a 'link' to dir/aligned.bin.
+
+    Args:
+        base: Path prefix of the directory.
+        files: Dictionary of file names and contents.
+
+    Returns:
+        Path of the directory.
+    """
+    src = base + '.src'
+    shutil.rmtree(src, ignore_errors=True)
+    for name, data in files.items():
+        path = os.path.join(src, name)
+        os.makedirs(os.path.dirname(path), exist_ok=True)
+        with open(path, 'wb') as f:
+            f.write(data)
+    os.symlink('dir/aligned.bin', os.path.join(src, 'link'))
+    return src
+
+class RoFsTests(object):
+    """Listing and reading tests shared by the read-only file systems.
+
+    A Test... subclass sets the commands and the files of its image, and
+    its module provides the image as the ro_fs_img fixture, made from
+    make_tree(..., files).
+    """
+    ls_cmd = 'ls'
+    load_cmd = 'load'
+    files = RO_FILES
+    partial_files = ['multi.bin']
+
+    def test_ls(self, u_boot_console, ro_fs_img):
+        """
+        Test Case 1 - list the root and a subdirectory
+        """
+        output = u_boot_console.run_command_list([
+            'host bind 0 %s' % ro_fs_img,
+            '%s host 0 /' % self.ls_cmd])
+        output = ''.join(output)
+        assert(re.search('%d *small.txt' % len(self.files['small.txt']),
+                         output))
+        assert('dir/' in output)
+        assert('link' in output)
+
+        output = u_boot_console.run_command('%s host 0 /dir' % self.ls_cmd)
+        assert(re.search('262144 *aligned.bin', output))
+
+    def test_load(self, u_boot_console, ro_fs_img):
+        """
+        Test Case 2 - load whole files and compare their CRC
+        """
+        u_boot_console.run_command('host bind 0 %s' % ro_fs_img)
+        for name, data in self.files.items():
+            output = u_boot_console.run_command_list([
+                '%s host 0 %x /%s' % (self.load_cmd, ADDR, name),
+                'printenv filesize',
+                'crc32 %x $filesize' % ADDR])
+            output = ''.join(output)
+            assert('filesize=%x' % len(data) in output)
+            assert(crc(data) in output)
+
+    def test_load_partial(self, u_boot_console, ro_fs_img):
+        """
+        Test Case 3 - load ranges crossing block boundaries, and the tail
+        """
+        u_boot_console.run_command('host bind 0 %s' % ro_fs_img)
+        for name in self.partial_files:
+            data = self.files[name]
+            for pos, size in [(0x1000, 0x2345), (0xfff0, 0x20),
+                              (0x1fff0, 0x20), (0x40010, 0x100),
+                              (len(data) - 0x30, 0x30)]:
+                output = u_boot_console.run_command_list([
+                    '%s host 0 %x /%s %x %x'
+                        % (self.load_cmd, ADDR, name, size, pos),
+                    'crc32 %x %x' % (ADDR, size)])
+                assert(crc(data[pos:pos + size]) in ''.join(output))
+
+    def test_symlink(self, u_boot_console, ro_fs_img):
+        """
+        Test Case 4 - load through a symbolic link, and a missing file
+        """
+        data = self.files['dir/aligned.bin']
+        output = u_boot_console.run_command_list([
+            'host bind 0 %s' % ro_fs_img,
+            'load host 0 %x /link' % ADDR,
+            'crc32 %x $filesize' % ADDR])
+        assert(crc(data) in ''.join(output))
+
+        output = u_boot_console.run_command('%s host 0 %x /missing'
+                                            % (self.load_cmd, ADDR))
+        assert('bytes read' not in output)
@@ -0,0 +1,113 @@
+# SPDX-License-Identifier:      GPL-2.0+
+#
+# U-Boot File System: EROFS Test
+
+"""
+This test verifies listing and reading files from an EROFS image, and
+compares the load time of a large file with the same file on ext4.
+"""
+
+import os
+import pytest
+import re
+from subprocess import check_call
+from fstest_defs import *
+from fstest_helpers import RO_FILES, RoFsTests, crc, make_tree
+
+EROFS_FILES = dict(RO_FILES, **{
+    # Large and compressible, used for the throughput comparison
+    'big.bin': b''.join(b'%08d: EROFS throughput test\n' % i
+                        for i in range(128 * 1024)),
+})
+
+@pytest.fixture(scope='module', params=['plain', 'lz4'])
+def ro_fs_img(request, u_boot_config):
+    """Create an EROFS image, uncompressed or LZ4 compressed.
+
+    Args:
+        request: Pytest request, the layout is request.param.
+        u_boot_config: U-Boot configuration.
+
+    Returns:
+        Path of the image.
+    """
+    base = os.path.join(u_boot_config.persistent_data_dir, 'erofs')
+    src = make_tree(base, EROFS_FILES)
+    img = '%s.%s.img' % (base, request.param)
+    opts = '-zlz4' if request.param == 'lz4' else ''
+
+    if os.path.exists(img):
+        os.remove(img)
+    try:
+        check_call('mkfs.erofs %s %s %s' % (opts, img, src), shell=True)
+    except Exception:
+        pytest.skip('mkfs.erofs cannot create %s images' % request.param)
+
+    return img
+
+@pytest.fixture(scope='module')
+def ext4_img(u_boot_config):
+    """Create an ext4 image holding the same files, for comparison.
+
+    Args:
+        u_boot_config: U-Boot configuration.
+
+    Returns:
+        Path of the image.
+    """
+    base = os.path.join(u_boot_config.persistent_data_dir, 'erofs')
+    src = make_tree(base, EROFS_FILES)
+    img = base + '.ext4.img'
+
+    if os.path.exists(img):
+        os.remove(img)
+    try:
+        check_call('mkfs.ext4 -q -O ^metadata_csum -d %s %s 16M'
+                   % (src, img), shell=True)
+    except Exception:
+        pytest.skip('mkfs.ext4 cannot populate an image')
+
+    return img
+
+def load_time(output):
+    """Return the load time in ms reported by the 'load' command."""
+    m = re.search('bytes read in ([0-9]+) ms', output)
+    assert(m)
+    return int(m.group(1))
+
+@pytest.mark.boardspec('sandbox')
+@pytest.mark.buildconfigspec('fs_erofs')
+@pytest.mark.requiredtool('mkfs.erofs')
+class TestErofs(RoFsTests):
+    files = EROFS_FILES
+    partial_files = ['multi.bin', 'big.bin']
+
+    def test_erofs_ls_dots(self, u_boot_console, ro_fs_img):
+        """
+        Test Case 5 - the '.' and '..' entries are not listed
+        """
+        output = u_boot_console.run_command_list([
+            'host bind 0 %s' % ro_fs_img,
+            'ls host 0 /'])
+        assert('./' not in ''.join(output))
+
+    @pytest.mark.buildconfigspec('fs_ext4')
+    @pytest.mark.requiredtool('mkfs.ext4')
+    def test_erofs_throughput(self, u_boot_console, ro_fs_img, ext4_img):
+        """
+        Test Case 6 - compare the load time of a large file with ext4
+        """
+        data = EROFS_FILES['big.bin']
+        times = {}
+        for fs, img in [('erofs', ro_fs_img), ('ext4', ext4_img)]:
+            output = u_boot_console.run_command_list([
+                'host bind 0 %s' % img,
+                'load host 0 %x /big.bin' % ADDR,
+                'crc32 %x $filesize' % ADDR])
+            output = ''.join(output)
+            assert(crc(data) in output)
+            times[fs] = load_time(output)
+
+        u_boot_console.log.info('%s: %d bytes in %d ms (erofs), %d ms (ext4)'
+                                % (os.path.basename(ro_fs_img), len(data),
+                                   times['erofs'], times['ext4']))
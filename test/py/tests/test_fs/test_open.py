@@ -0,0 +1,74 @@
+# SPDX-License-Identifier:      GPL-2.0+
+#
+# U-Boot File System: Open file test
+
+"""
+This test verifies reading through file handles, as load does with
+fs_open()/fs_pread()/fs_file_close(), while the file system is switched
+between files and devices and mounted again.
+"""
+
+import pytest
+from fstest_defs import *
+
+@pytest.mark.boardspec('sandbox')
+@pytest.mark.slow
+class TestFsOpen(object):
+    def test_fs_open1(self, u_boot_console, fs_obj_basic):
+        """
+        Test Case 1 - read two files one after the other
+        """
+        fs_type,fs_img,md5val = fs_obj_basic
+        with u_boot_console.log.section('Test Case 1a - load small file'):
+            output = u_boot_console.run_command_list([
+                'host bind 0 %s' % fs_img,
+                '%sload host 0:0 %x /%s' % (fs_type, ADDR, SMALL_FILE),
+                'md5sum %x $filesize' % ADDR,
+                'setenv filesize'])
+            assert(md5val[0] in ''.join(output))
+
+        with u_boot_console.log.section('Test Case 1b - load big file'):
+            output = u_boot_console.run_command_list([
+                '%sload host 0:0 %x /%s %x 0x9c300000'
+                    % (fs_type, ADDR, BIG_FILE, LENGTH),
+                'md5sum %x $filesize' % ADDR,
+                'setenv filesize'])
+            assert(md5val[2] in ''.join(output))
+
+        with u_boot_console.log.section('Test Case 1c - load small file again'):
+            output = u_boot_console.run_command_list([
+                '%sload host 0:0 %x /%s' % (fs_type, ADDR, SMALL_FILE),
+                'md5sum %x $filesize' % ADDR,
+                'setenv filesize'])
+            assert(md5val[0] in ''.join(output))
+
+    def test_fs_open2(self, u_boot_console, fs_obj_basic):
+        """
+        Test Case 2 - read from a second device and after a remount
+        """
+        fs_type,fs_img,md5val = fs_obj_basic
+        with u_boot_console.log.section('Test Case 2a - two devices'):
+            output = u_boot_console.run_command_list([
+                'host bind 0 %s' % fs_img,
+                'host bind 1 %s' % fs_img,
+                '%sload host 0:0 %x /%s' % (fs_type, ADDR, SMALL_FILE),
+                'md5sum %x $filesize' % ADDR,
+                '%sload host 1:0 %x /%s %x 0x0'
+                    % (fs_type, ADDR, BIG_FILE, LENGTH),
+                'md5sum %x $filesize' % ADDR,
+                'setenv filesize',
+                'host bind 1'])
+            assert(md5val[0] in ''.join(output))
+            assert(md5val[1] in ''.join(output))
+
+        with u_boot_console.log.section('Test Case 2b - remount'):
+            output = u_boot_console.run_command_list([
+                'host bind 0 %s' % fs_img,
+                '%sload host 0:0 %x /%s %x 0x0'
+                    % (fs_type, ADDR, BIG_FILE, LENGTH),
+                'md5sum %x $filesize' % ADDR,
+                '%sload host 0:0 %x /%s' % (fs_type, ADDR, SMALL_FILE),
+                'md5sum %x $filesize' % ADDR,
+                'setenv filesize'])
+            assert(md5val[1] in ''.join(output))
+            assert(md5val[0] in ''.join(output))
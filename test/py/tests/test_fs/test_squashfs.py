@@ -0,0 +1,49 @@
+# SPDX-License-Identifier:      GPL-2.0+
+#
+# U-Boot File System: SquashFS Test
+
+"""
+This test verifies listing and reading files from a SquashFS image.
+"""
+
+import os
+import pytest
+from subprocess import check_call
+from fstest_helpers import RO_FILES, RoFsTests, make_tree
+
+@pytest.fixture(scope='module', params=['gzip', 'lzo', 'lz4', 'zstd'])
+def ro_fs_img(request, u_boot_config):
+    """Create a SquashFS image compressed with the given algorithm.
+
+    Args:
+        request: Pytest request, the compressor is request.param.
+        u_boot_config: U-Boot configuration.
+
+    Returns:
+        Path of the image.
+    """
+    comp = request.param
+    if comp != 'gzip' and \
+            u_boot_config.buildconfig.get('config_%s' % comp, 'n') != 'y':
+        pytest.skip('%s decompression is not enabled' % comp)
+
+    base = os.path.join(u_boot_config.persistent_data_dir, 'sqfs')
+    src = make_tree(base, RO_FILES)
+    img = '%s.%s.img' % (base, comp)
+
+    if os.path.exists(img):
+        os.remove(img)
+    try:
+        check_call('mksquashfs %s %s -comp %s -b 131072 -noappend -quiet'
+                   % (src, img, comp), shell=True)
+    except Exception:
+        pytest.skip('mksquashfs cannot create %s images' % comp)
+
+    return img
+
+@pytest.mark.boardspec('sandbox')
+@pytest.mark.buildconfigspec('cmd_squashfs')
+@pytest.mark.requiredtool('mksquashfs')
+class TestSquashfs(RoFsTests):
+    ls_cmd = 'sqfsls'
+    load_cmd = 'sqfsload'
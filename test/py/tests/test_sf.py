@@ -215,3 +215,23 @@ def test_sf_update(u_boot_console, env__sf_config):
 
     sf_params = sf_prepare(u_boot_console, env__sf_config)
     sf_update(u_boot_console, env__sf_config, sf_params)
+
+@pytest.mark.buildconfigspec('cmd_sf_bench')
+@pytest.mark.buildconfigspec('cmd_crc32')
+@pytest.mark.buildconfigspec('cmd_memory')
+def test_sf_bench(u_boot_console, env__sf_config):
+    sf_params = sf_prepare(u_boot_console, env__sf_config)
+    addr = sf_params['ram_base']
+    offset = env__sf_config['offset']
+    count = sf_params['len']
+
+    cmd = 'sf bench %08x %08x %x 3' % (addr, offset, count)
+    output = u_boot_console.run_command(cmd)
+    m = re.search('3 x %d bytes .* avg ([0-9]+) us, best ([0-9]+) us, '
+                  '([0-9]+) KiB/s' % count, output)
+    assert m, 'sf bench did not report its results'
+    assert int(m.group(2)) <= int(m.group(1))
+
+    # The data read by the benchmark must match a plain read
+    crc_bench = u_boot_utils.crc32(u_boot_console, addr, count)
+    assert crc_bench == sf_read(u_boot_console, env__sf_config, sf_params)